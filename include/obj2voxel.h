@@ -33,9 +33,14 @@ typedef bool(obj2voxel_triangle_callback)(void *callback_data, obj2voxel_triangl
 /// A callback which writes voxels to an output.
 /// Returns true if writing voxels succeeded.
 typedef bool(obj2voxel_voxel_callback)(void *callback_data, uint32_t *voxel_data, size_t voxel_count);
+/// A callback which writes one z-slice of a signed distance field with resolution * resolution values, x fastest.
+/// Returns true if writing the slice succeeded.
+typedef bool(obj2voxel_sdf_callback)(void *callback_data, uint32_t z, const float *distances, size_t count);
 /// A callback which handles log messages.
 /// Returns true if the message was handled or false if it should be default-logged.
 typedef bool(obj2voxel_log_callback)(void *callback_data, const char *msg, obj2voxel_enum_t level);
+/// A callback which is invoked once an asynchronous voxelization has completed, with its result.
+typedef void(obj2voxel_completion_callback)(void *callback_data, obj2voxel_error_t result);
 
 // ENUMS ===============================================================================================================
 
@@ -44,11 +49,41 @@ static const obj2voxel_enum_t OBJ2VOXEL_MAX_STRATEGY = 0;
 /// Voxel color is a weighted average of triangle piece colors, weighted by area.
 static const obj2voxel_enum_t OBJ2VOXEL_BLEND_STRATEGY = 1;
 
+/// Voxels carry the ARGB color sampled from their triangles.
+static const obj2voxel_enum_t OBJ2VOXEL_ATTRIBUTE_COLOR = 0;
+/// Voxels carry the material index of the triangle with the greatest area inside of them.
+static const obj2voxel_enum_t OBJ2VOXEL_ATTRIBUTE_MATERIAL = 1;
+
+/// Every voxel which the surface intersects is kept, producing a 26-separating surface.
+static const obj2voxel_enum_t OBJ2VOXEL_CONSERVATIVE_TOPOLOGY = 0;
+/// Only voxels which are needed for a 6-separating surface are kept, producing a thin surface with fewer voxels.
+static const obj2voxel_enum_t OBJ2VOXEL_THIN_TOPOLOGY = 1;
+
+/// Voxels are grown by one layer per unit of radius, taking the value of a neighboring voxel.
+static const obj2voxel_enum_t OBJ2VOXEL_MORPHOLOGY_DILATE = 0;
+/// Voxels are shrunk by one layer per unit of radius.
+static const obj2voxel_enum_t OBJ2VOXEL_MORPHOLOGY_ERODE = 1;
+/// Voxels are dilated and then eroded by the radius, which closes gaps and holes up to twice the radius in size.
+static const obj2voxel_enum_t OBJ2VOXEL_MORPHOLOGY_CLOSE = 2;
+/// Only the outermost layers of voxels are kept, with the radius as the thickness of the remaining shell.
+static const obj2voxel_enum_t OBJ2VOXEL_MORPHOLOGY_HOLLOW = 3;
+
 /// UV coordinates are clamped to range [0,1].
 static const obj2voxel_enum_t OBJ2VOXEL_UV_CLAMP = 0;
 /// UV coordinates are wrapped around range [0,1] (for tiling textures).
 static const obj2voxel_enum_t OBJ2VOXEL_UV_WRAP = 1;
 
+/// Borrowed pixels have three bytes in the order red, green, blue.
+static const obj2voxel_enum_t OBJ2VOXEL_CHANNELS_RGB = 0;
+/// Borrowed pixels have three bytes in the order blue, green, red.
+static const obj2voxel_enum_t OBJ2VOXEL_CHANNELS_BGR = 1;
+/// Borrowed pixels have four bytes in the order red, green, blue, alpha.
+static const obj2voxel_enum_t OBJ2VOXEL_CHANNELS_RGBA = 2;
+/// Borrowed pixels have four bytes in the order blue, green, red, alpha.
+static const obj2voxel_enum_t OBJ2VOXEL_CHANNELS_BGRA = 3;
+/// Borrowed pixels have four bytes in the order alpha, red, green, blue.
+static const obj2voxel_enum_t OBJ2VOXEL_CHANNELS_ARGB = 4;
+
 /// Nothing gets logged.
 static const obj2voxel_enum_t OBJ2VOXEL_LOG_LEVEL_SILENT = 0;
 /// Errors get logged.
@@ -66,7 +101,7 @@ static const obj2voxel_error_t OBJ2VOXEL_ERR_OK = 0;
 static const obj2voxel_error_t OBJ2VOXEL_ERR_NO_INPUT = 1;
 /// No output was provided.
 static const obj2voxel_error_t OBJ2VOXEL_ERR_NO_OUTPUT = 2;
-/// No resolution was specified.
+/// No resolution was specified or the resolution is too large.
 static const obj2voxel_error_t OBJ2VOXEL_ERR_NO_RESOLUTION = 3;
 /// An I/O error occured when attempting to open the input file.
 static const obj2voxel_error_t OBJ2VOXEL_ERR_IO_ERROR_ON_OPEN_INPUT_FILE = 4;
@@ -124,6 +159,9 @@ obj2voxel_enum_t obj2voxel_get_log_level(void);
 /**
  * @brief Sets the voxelization resolution on all axes.
  * Setting this to 128 means that the model is voxelized in a 128x128x128 cube.
+ * The resolution multiplied with the supersampling level may be at most 2^27 (134217728), otherwise voxelization fails
+ * with OBJ2VOXEL_ERR_NO_RESOLUTION.
+ * Vertices are stored as single-precision floats, so positions are only exact to a voxel up to about 2^23.
  * @param instance the instance
  * @param resolution the resolution; must not be zero
  */
@@ -145,6 +183,77 @@ void obj2voxel_set_supersampling(obj2voxel_instance *instance, uint32_t level);
  */
 void obj2voxel_set_color_strategy(obj2voxel_instance *instance, obj2voxel_enum_t strategy);
 
+/**
+ * @brief Sets the alpha cutoff for textured triangles.
+ * Fragments whose sampled texture alpha is below the cutoff are discarded, which is useful for alpha-masked textures
+ * such as foliage.
+ * With OBJ2VOXEL_MAX_STRATEGY, the voxel takes the color of the opaque fragment with the greatest area, so a voxel is
+ * only discarded if all of its fragments are transparent.
+ * The cutoff has no effect when voxels carry OBJ2VOXEL_ATTRIBUTE_MATERIAL because no textures are sampled.
+ * @param instance the instance
+ * @param cutoff the alpha cutoff in [0, 1], where 0 disables the alpha test (default)
+ */
+void obj2voxel_set_alpha_cutoff(obj2voxel_instance *instance, float cutoff);
+
+/**
+ * @brief Sets the attribute which voxels carry.
+ * With OBJ2VOXEL_ATTRIBUTE_MATERIAL, the triangle with the greatest area in a voxel decides its material index.
+ * No colors are sampled in this mode.
+ * Voxel callbacks receive the material index in place of the ARGB color.
+ * Paletted file formats get a palette of material colors, other file formats get the color of each voxel's material.
+ * @param instance the instance
+ * @param attribute OBJ2VOXEL_ATTRIBUTE_COLOR (default) or OBJ2VOXEL_ATTRIBUTE_MATERIAL
+ */
+void obj2voxel_set_voxel_attribute(obj2voxel_instance *instance, obj2voxel_enum_t attribute);
+
+/**
+ * @brief Sets the topology of the voxelized surface.
+ * A thin surface only keeps the voxel which the triangle plane crosses along the dominant axis of its normal.
+ * Such surfaces are 6-separating and are up to 1.7 times smaller on diagonal surfaces than conservative ones.
+ * @param instance the instance
+ * @param topology OBJ2VOXEL_CONSERVATIVE_TOPOLOGY (default) or OBJ2VOXEL_THIN_TOPOLOGY
+ */
+void obj2voxel_set_topology(obj2voxel_instance *instance, obj2voxel_enum_t topology);
+
+/**
+ * @brief Enables mesh decimation through vertex clustering.
+ * After the mesh is transformed into voxel space, every vertex is snapped to the center of its cell in a grid with the
+ * given number of cells per voxel and axis.
+ * Triangles which collapse or become identical in the process are removed before voxelization.
+ * This makes voxelizing meshes with many triangles per voxel much cheaper at the cost of moving the surface by at most
+ * half a cell diagonal.
+ * UV coordinates and materials are never merged, so texture and material boundaries are preserved.
+ * @param instance the instance
+ * @param cells_per_voxel the number of cells per voxel and axis or zero to disable decimation (default)
+ */
+void obj2voxel_set_decimation(obj2voxel_instance *instance, uint32_t cells_per_voxel);
+
+/**
+ * @brief Appends a morphological operation to the post-processing steps, which are applied in the order they were
+ * added.
+ * Voxelized chunks are then kept in memory as bitsets instead of being written immediately.
+ * Each step runs in passes over all non-empty chunks, which are processed concurrently by the workers.
+ * Every pass looks at the 26 neighbors of each voxel, so the radius is measured as Chebyshev distance.
+ * Voxels outside of the grid count as empty.
+ * Normals are post-processed along with the voxels, so every output voxel keeps a matching normal.
+ * Distance fields are still computed from the unprocessed surface.
+ * @param instance the instance
+ * @param operation OBJ2VOXEL_MORPHOLOGY_DILATE, OBJ2VOXEL_MORPHOLOGY_ERODE, OBJ2VOXEL_MORPHOLOGY_CLOSE or
+ * OBJ2VOXEL_MORPHOLOGY_HOLLOW
+ * @param radius the radius or shell thickness in voxels, where zero makes the step have no effect
+ */
+void obj2voxel_add_morphology(obj2voxel_instance *instance, obj2voxel_enum_t operation, uint32_t radius);
+
+/**
+ * @brief Removes small connected components of voxels, such as the floating islands of scanned meshes.
+ * Voxels are connected if they touch in a face, edge or corner.
+ * Components are labeled after all morphological steps have been applied, in parallel on the workers.
+ * @param instance the instance
+ * @param min_voxels the minimum number of voxels of a component, where zero or one keeps all components (default)
+ * @param max_islands the number of largest components which are kept or zero to keep all of them (default)
+ */
+void obj2voxel_set_island_removal(obj2voxel_instance *instance, uint64_t min_voxels, uint32_t max_islands);
+
 /**
  * @brief Adds a fallback texture to the instance.
  * The fallback texture is used for voxelizing input files when a triangle has UV coordinates but no material.
@@ -160,6 +269,8 @@ void obj2voxel_set_texture(obj2voxel_instance *instance, obj2voxel_texture *text
  * @brief Sets the input to a file path with an optional type.
  * If the type is not specified, the file type is detected based on the file path and/or contents.
  * The file is not loaded immediately, but when voxelization starts.
+ * The path "-" stands for standard input, from which OBJ and STL files can be read when the type is specified.
+ * STL files are parsed in blocks as they arrive.
  * @param instance the instance
  * @param file the file
  * @param type the file type as an extension without a dot or null for auto-detection (e.g. "vox")
@@ -178,16 +289,69 @@ void obj2voxel_set_input_callback(obj2voxel_instance *instance,
                                   obj2voxel_triangle_callback *callback,
                                   void *callback_data);
 
+/**
+ * @brief Pushes triangles into the instance, which replaces any other input.
+ * This function may be called concurrently from any number of threads.
+ * Each thread appends to its own staging buffer, so producers don't contend with each other except for a brief lookup
+ * of their buffer.
+ * The order in which triangles of different threads are voxelized is unspecified.
+ * Once all triangles are pushed, obj2voxel_finish_input() must be called before voxelization.
+ * @param instance the instance
+ * @param vertices the vertices of the triangles, 9 floats per triangle
+ * @param colors the colors of the triangles, 3 floats per triangle, or null for triangles without color
+ * @param count the number of triangles
+ */
+void obj2voxel_push_triangles(obj2voxel_instance *instance,
+                              const float vertices[],
+                              const float colors[],
+                              size_t count);
+
+/**
+ * @brief Finishes the input of obj2voxel_push_triangles().
+ * The mesh boundaries of all threads are merged, so the boundaries don't need to be searched during voxelization.
+ * This must be called once all pushing threads are done and no more triangles may be pushed afterwards.
+ * @param instance the instance
+ */
+void obj2voxel_finish_input(obj2voxel_instance *instance);
+
 /**
  * @brief Sets the output to a file path with an optional type.
  * If the type is not specified, the file type is detected based on the file path and/or contents.
  * The file is not written immediately, but when voxelization starts.
+ * The path "-" stands for standard output, which requires the type to be specified.
+ * Voxels are written to standard output in large blocks as chunks are voxelized, except for paletted formats, which
+ * are only written once voxelization is complete.
  * @param instance the instance
  * @param file the file
  * @param type the file type as an extension without a dot or null for auto-detection (e.g. "vox")
  */
 void obj2voxel_set_output_file(obj2voxel_instance *instance, const char *file, const char *type);
 
+/**
+ * @brief Splits the file output into tiles which are written to separate files.
+ * The grid is divided into the given number of cubic tiles per axis, rounded so that tiles are aligned to chunks.
+ * Each tile is written to "<name>_x_y_z.<ext>" as soon as all of its chunks are voxelized, with the tile's origin as
+ * the file's origin, so only unfinished tiles are kept in memory.
+ * Empty tiles produce no files.
+ * A manifest "<name>.tiles" lists the voxel bounds and the file of each tile in the same format as tiled input.
+ * This only works with file output.
+ * @param instance the instance
+ * @param tiles_per_axis the number of tiles per axis or zero to write a single file (default)
+ */
+void obj2voxel_set_output_tiles(obj2voxel_instance *instance, uint32_t tiles_per_axis);
+
+/**
+ * @brief Toggles direct I/O for file output.
+ * Output files are always written asynchronously in large blocks, using io_uring where available.
+ * With direct I/O, they are additionally opened with O_DIRECT so that multi-gigabyte outputs don't evict the page
+ * cache.
+ * File systems without direct I/O support are written through the page cache instead.
+ * Direct I/O is disabled by default.
+ * @param instance the instance
+ * @param enabled true if direct I/O should be used
+ */
+void obj2voxel_set_direct_io(obj2voxel_instance *instance, bool enabled);
+
 /**
  * @brief Sets the output to be memory with a file type.
  * Voxels will be stored in memory instead of being written to a file.
@@ -208,6 +372,41 @@ void obj2voxel_set_output_callback(obj2voxel_instance *instance,
                                    obj2voxel_voxel_callback *callback,
                                    void *callback_data);
 
+/**
+ * @brief Enables the normal channel and sets a callback that consumes per-voxel normals.
+ * Normals are accumulated from the normals of all triangles in a voxel, weighted by area.
+ * The data passed to the callback is laid out like VL32, meaning (x,y,z,normal), where the normal is octahedrally
+ * encoded.
+ * The upper 16 bits of the normal store the x-component and the lower 16 bits store the y-component of the unfolded
+ * octahedron, where [0, 65535] maps to [-1, 1].
+ * Every voxel which is passed to the regular output is also passed to this callback.
+ * Voxels which are added by morphological operations take the normal of the neighbor whose color they take.
+ * @param instance the instance
+ * @param callback the callback
+ * @param callback_data data passed to the callback each invocation
+ */
+void obj2voxel_set_normal_output_callback(obj2voxel_instance *instance,
+                                          obj2voxel_voxel_callback *callback,
+                                          void *callback_data);
+
+/**
+ * @brief Enables signed distance field output.
+ * The distance field has the output resolution in every dimension and is passed slice by slice to the callback.
+ * Distances are measured in voxels from each voxel center to the nearest triangle.
+ * They are negative inside the mesh and positive outside.
+ * When this output is enabled, setting a regular voxel output is optional.
+ * The field is computed in a dense grid, so voxelization fails with OBJ2VOXEL_ERR_NO_RESOLUTION if the resolution
+ * exceeds 2048.
+ * @param instance the instance
+ * @param band the half-width of the narrow band to which distances are clamped or 0 for an unclamped field
+ * @param callback the callback
+ * @param callback_data data passed to the callback each invocation
+ */
+void obj2voxel_set_sdf_output(obj2voxel_instance *instance,
+                              float band,
+                              obj2voxel_sdf_callback *callback,
+                              void *callback_data);
+
 /**
  * @brief Toggles parallelism.
  * Parallelism is disabled by default.
@@ -262,6 +461,28 @@ uint32_t obj2voxel_get_chunk_size(obj2voxel_instance *instance);
  */
 const obj2voxel_byte_t *obj2voxel_get_output_memory(obj2voxel_instance *instance, size_t *out_size);
 
+/**
+ * @brief After voxelization, returns the number of triangles which were culled instead of being voxelized.
+ * Triangles are degenerate if they have almost no area after transformation and decimation.
+ * Triangles are duplicates if another triangle with the same corners and material was kept, regardless of winding.
+ * For tiled input, triangles which overlap multiple tile regions are still counted once.
+ * @param instance the instance
+ * @param out_degenerate the number of degenerate triangles output parameter or nullptr
+ * @param out_duplicate the number of duplicate triangles output parameter or nullptr
+ */
+void obj2voxel_get_culled_triangle_counts(obj2voxel_instance *instance,
+                                          uint64_t *out_degenerate,
+                                          uint64_t *out_duplicate);
+
+/**
+ * @brief Returns the number of pages of cached triangles which are still allocated while chunks are voxelized.
+ * A page is freed as soon as every chunk which references its triangles has been voxelized.
+ * This may be called during voxelization, for example from the output callback.
+ * @param instance the instance
+ * @return the number of live triangle pages
+ */
+uint64_t obj2voxel_get_live_triangle_pages(obj2voxel_instance *instance);
+
 // TRIANGLES ===========================================================================================================
 
 /**
@@ -291,6 +512,16 @@ void obj2voxel_set_triangle_textured(obj2voxel_triangle *triangle,
                                      const float textures[6],
                                      obj2voxel_texture *texture);
 
+/**
+ * @brief Sets the material index of a triangle.
+ * This must be called after the other triangle setters, which reset the material index to 0.
+ * Material indices are only used when voxels carry OBJ2VOXEL_ATTRIBUTE_MATERIAL.
+ * For OBJ files, the material index is the position in the material library plus one, 0 meaning no material.
+ * @param triangle the triangle
+ * @param material the material index
+ */
+void obj2voxel_set_triangle_material(obj2voxel_triangle *triangle, uint32_t material);
+
 // TEXTURES ============================================================================================================
 
 /**
@@ -341,6 +572,26 @@ bool obj2voxel_texture_load_from_memory(obj2voxel_texture *texture,
 bool obj2voxel_texture_load_pixels(
     obj2voxel_texture *texture, const obj2voxel_byte_t *pixels, size_t width, size_t height, size_t channels);
 
+/**
+ * @brief Makes a texture sample caller-owned pixel data in place instead of copying it.
+ * The pixel data always has a bit-depth of 8.
+ * The caller must keep the pixels alive and unmodified until the texture is freed or loaded with other pixels.
+ * Since voxelization only reads textures, one texture may be shared between concurrently voxelizing instances.
+ * @param texture the texture
+ * @param pixels the pixel data of the first row
+ * @param width the width
+ * @param height the height
+ * @param stride the distance in bytes between the beginnings of two consecutive rows, at least width * channels
+ * @param channel_order one of the OBJ2VOXEL_CHANNELS_ constants
+ * @return true if the texture could be loaded
+ */
+bool obj2voxel_texture_borrow_pixels(obj2voxel_texture *texture,
+                                     const obj2voxel_byte_t *pixels,
+                                     size_t width,
+                                     size_t height,
+                                     size_t stride,
+                                     obj2voxel_enum_t channel_order);
+
 /**
  * @brief Sets the UV mode of the texture.
  * The default is wrap.
@@ -364,11 +615,22 @@ void obj2voxel_texture_get_meta(obj2voxel_texture *texture,
 /**
  * @brief Copies the pixels of the texture into an output buffer.
  * The output buffer must be (width * height * channels) bytes large.
+ * Borrowed pixels are converted into tightly packed RGB or ARGB, like the pixels of obj2voxel_texture_load_pixels().
  * @param texture the texture
  * @param out_pixels the pixels
  */
 void obj2voxel_texture_get_pixels(obj2voxel_texture *texture, obj2voxel_byte_t *out_pixels);
 
+/**
+ * @brief Returns the pixels of the texture without copying them.
+ * For loaded textures, these are the pixels in the layout of obj2voxel_texture_get_pixels().
+ * For borrowed textures, this is the borrowed memory in its original layout.
+ * @param texture the texture
+ * @param out_stride the output distance in bytes between two rows, may be null
+ * @return the pixels which stay valid until the texture is freed or loaded again
+ */
+const obj2voxel_byte_t *obj2voxel_texture_peek_pixels(obj2voxel_texture *texture, size_t *out_stride);
+
 // THREADING ===========================================================================================================
 
 /**
@@ -405,6 +667,60 @@ uint32_t obj2voxel_get_worker_count(obj2voxel_instance *instance);
  */
 obj2voxel_error_t obj2voxel_voxelize(obj2voxel_instance *instance);
 
+/**
+ * @brief Starts voxelizing on a new thread and returns immediately.
+ * The voxelization behaves exactly like obj2voxel_voxelize(), including the use of worker threads.
+ * Its completion can be observed with obj2voxel_poll(), obj2voxel_wait(), a completion callback or the descriptor
+ * returned by obj2voxel_get_completion_fd().
+ * No settings of the instance may be changed while the voxelization is in progress.
+ * obj2voxel_free() blocks until an asynchronous voxelization has completed.
+ * @param instance the instance
+ * @return OBJ2VOXEL_ERR_OK if voxelization was started or OBJ2VOXEL_ERR_DOUBLE_VOXELIZATION if it had already been
+ */
+obj2voxel_error_t obj2voxel_voxelize_async(obj2voxel_instance *instance);
+
+/**
+ * @brief Returns whether an asynchronous voxelization has completed, without blocking.
+ * @param instance the instance
+ * @param out_result receives the result of the voxelization if it has completed, may be null
+ * @return true if the voxelization has completed
+ */
+bool obj2voxel_poll(obj2voxel_instance *instance, obj2voxel_error_t *out_result);
+
+/**
+ * @brief Blocks until an asynchronous voxelization has completed or the timeout expires.
+ * If no asynchronous voxelization was started, this returns false immediately.
+ * @param instance the instance
+ * @param timeout_ms the timeout in milliseconds or a negative value to wait indefinitely
+ * @param out_result receives the result of the voxelization if it has completed, may be null
+ * @return true if the voxelization has completed
+ */
+bool obj2voxel_wait(obj2voxel_instance *instance, int64_t timeout_ms, obj2voxel_error_t *out_result);
+
+/**
+ * @brief Sets a callback which is invoked once an asynchronous voxelization has completed.
+ * The callback runs on the voxelization thread after obj2voxel_poll() starts returning true.
+ * It must not free the instance.
+ * This must be set before obj2voxel_voxelize_async() is called.
+ * @param instance the instance
+ * @param callback the callback or nullptr to remove it
+ * @param callback_data the data passed to the callback
+ */
+void obj2voxel_set_completion_callback(obj2voxel_instance *instance,
+                                       obj2voxel_completion_callback *callback,
+                                       void *callback_data);
+
+/**
+ * @brief Returns a file descriptor which becomes readable once an asynchronous voxelization has completed.
+ * This allows waiting for completion in an event loop using epoll, kqueue, poll or select.
+ * On Linux, this is an eventfd, on other POSIX systems the read end of a pipe.
+ * The descriptor is owned by the instance and closed by obj2voxel_free().
+ * It may be obtained before or after voxelization has been started.
+ * @param instance the instance
+ * @return the file descriptor or -1 if the platform doesn't support it
+ */
+int obj2voxel_get_completion_fd(obj2voxel_instance *instance);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,519 @@
+#include "asyncfile.hpp"
+
+#include "constants.hpp"
+#include "pipes.hpp"
+#include "threading.hpp"
+
+#include "voxelio/log.hpp"
+#include "voxelio/stream.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define OBJ2VOXEL_ASYNC_IO_POSIX
+#include <fcntl.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+#if defined(OBJ2VOXEL_ASYNC_IO_POSIX) && defined(__linux__)
+#define OBJ2VOXEL_ASYNC_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+
+namespace obj2voxel {
+
+#ifdef OBJ2VOXEL_ASYNC_IO_POSIX
+
+namespace {
+
+/// Writes all bytes at the given offset, continuing after short or interrupted writes.
+bool pwriteFully(int fd, const u8 *data, usize size, u64 offset) noexcept
+{
+    while (size != 0) {
+        const ssize_t written = ::pwrite(fd, data, size, static_cast<off_t>(offset));
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return false;
+        }
+        data += written;
+        size -= static_cast<usize>(written);
+        offset += static_cast<u64>(written);
+    }
+    return true;
+}
+
+/// Writes all bytes at the current position, which is the only way of writing to pipes.
+bool writeFully(int fd, const u8 *data, usize size) noexcept
+{
+    while (size != 0) {
+        const ssize_t written = ::write(fd, data, size);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return false;
+        }
+        data += written;
+        size -= static_cast<usize>(written);
+    }
+    return true;
+}
+
+// WRITE BACKENDS ======================================================================================================
+
+struct WriteResult {
+    u32 buffer;
+    bool success;
+};
+
+/// Performs the writes of an AsyncFileOutputStream.
+/// There is at most one write in flight per buffer, so at most ASYNC_WRITE_BUFFER_COUNT writes in total.
+class WriteBackend {
+protected:
+    int fd;
+    u8 *buffers;
+
+    WriteBackend(int fd, u8 *buffers) noexcept : fd{fd}, buffers{buffers} {}
+
+    u8 *bufferAt(u32 buffer) const noexcept
+    {
+        return buffers + usize{buffer} * ASYNC_WRITE_BUFFER_SIZE;
+    }
+
+public:
+    virtual ~WriteBackend() = default;
+
+    /// Starts writing the first bytes of a buffer to the given offset in the file.
+    virtual void submit(u32 buffer, usize size, u64 offset) noexcept = 0;
+
+    /// Blocks until any submitted write completes and returns its buffer.
+    virtual WriteResult wait() noexcept = 0;
+};
+
+/// Writes buffers with pwrite() on a background thread, in the order in which they are submitted.
+/// Sequential backends ignore the offsets and write() each buffer at the current position instead.
+class ThreadWriteBackend final : public WriteBackend {
+private:
+    struct WriteJob {
+        u32 buffer;
+        usize size;
+        u64 offset;
+    };
+
+    static constexpr u32 EXIT = ~u32{0};
+
+    async::RingBuffer<WriteJob, ASYNC_WRITE_BUFFER_COUNT> jobs;
+    async::RingBuffer<WriteResult, ASYNC_WRITE_BUFFER_COUNT> results;
+    bool sequential;
+    std::thread thread;
+
+public:
+    ThreadWriteBackend(int fd, u8 *buffers, bool sequential)
+        : WriteBackend{fd, buffers}, sequential{sequential}, thread{&ThreadWriteBackend::run, this}
+    {
+    }
+
+    ~ThreadWriteBackend() final
+    {
+        jobs.push({EXIT, 0, 0});
+        thread.join();
+    }
+
+    void submit(u32 buffer, usize size, u64 offset) noexcept final
+    {
+        jobs.push({buffer, size, offset});
+    }
+
+    WriteResult wait() noexcept final
+    {
+        return results.pop();
+    }
+
+private:
+    void run() noexcept
+    {
+        for (WriteJob job = jobs.pop(); job.buffer != EXIT; job = jobs.pop()) {
+            const u8 *data = bufferAt(job.buffer);
+            const bool success = sequential ? writeFully(fd, data, job.size)
+                                            : pwriteFully(fd, data, job.size, job.offset);
+            results.push({job.buffer, success});
+        }
+    }
+};
+
+#ifdef OBJ2VOXEL_ASYNC_IO_URING
+
+/**
+ * @brief Submits writes to an io_uring, which is set up with raw system calls so that liburing isn't required.
+ * The buffers are registered with the ring if the kernel allows it, which saves mapping them for every write.
+ * Failed and short writes are completed synchronously with pwrite(), so kernels which support io_uring but not
+ * IORING_OP_WRITE still produce correct files.
+ */
+class UringWriteBackend final : public WriteBackend {
+private:
+    int ringFd;
+    u8 *sqRing = nullptr;
+    u8 *cqRing = nullptr;
+    usize sqRingSize = 0;
+    usize cqRingSize = 0;
+    io_uring_sqe *sqes = nullptr;
+    usize sqesSize = 0;
+
+    u32 *sqTail = nullptr;
+    u32 *sqMask = nullptr;
+    u32 *sqArray = nullptr;
+    u32 *cqHead = nullptr;
+    u32 *cqTail = nullptr;
+    u32 *cqMask = nullptr;
+    io_uring_cqe *cqes = nullptr;
+
+    bool registered = false;
+    /// The size and offset of the write in flight for each buffer, so that short writes can be completed.
+    usize sizes[ASYNC_WRITE_BUFFER_COUNT]{};
+    u64 offsets[ASYNC_WRITE_BUFFER_COUNT]{};
+
+    UringWriteBackend(int fd, u8 *buffers, int ringFd) noexcept : WriteBackend{fd, buffers}, ringFd{ringFd} {}
+
+public:
+    /// Sets up a ring for writing to the given file or returns nullptr if io_uring is unavailable.
+    static std::unique_ptr<UringWriteBackend> create(int fd, u8 *buffers) noexcept
+    {
+        io_uring_params params{};
+        const auto ringFd = static_cast<int>(::syscall(__NR_io_uring_setup, ASYNC_WRITE_BUFFER_COUNT, &params));
+        if (ringFd < 0) {
+            return nullptr;
+        }
+        std::unique_ptr<UringWriteBackend> result{new UringWriteBackend{fd, buffers, ringFd}};
+        if (not result->mapRings(params)) {
+            return nullptr;
+        }
+        result->registerBuffers();
+        return result;
+    }
+
+    ~UringWriteBackend() final
+    {
+        if (sqes != nullptr) {
+            ::munmap(sqes, sqesSize);
+        }
+        if (cqRing != nullptr && cqRing != sqRing) {
+            ::munmap(cqRing, cqRingSize);
+        }
+        if (sqRing != nullptr) {
+            ::munmap(sqRing, sqRingSize);
+        }
+        ::close(ringFd);
+    }
+
+    void submit(u32 buffer, usize size, u64 offset) noexcept final
+    {
+        sizes[buffer] = size;
+        offsets[buffer] = offset;
+
+        // only this thread produces submissions, so the tail can't change concurrently
+        const u32 tail = *sqTail;
+        const u32 index = tail & *sqMask;
+        io_uring_sqe &sqe = sqes[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = registered ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+        sqe.fd = fd;
+        sqe.addr = reinterpret_cast<u64>(bufferAt(buffer));
+        sqe.len = static_cast<u32>(size);
+        sqe.off = offset;
+        sqe.buf_index = registered ? static_cast<u16>(buffer) : 0;
+        sqe.user_data = buffer;
+        sqArray[index] = index;
+        __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+
+        enter(1, 0, 0);
+    }
+
+    WriteResult wait() noexcept final
+    {
+        while (true) {
+            const u32 head = *cqHead;
+            if (head == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) {
+                enter(0, 1, IORING_ENTER_GETEVENTS);
+                continue;
+            }
+            const io_uring_cqe cqe = cqes[head & *cqMask];
+            __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+
+            const auto buffer = static_cast<u32>(cqe.user_data);
+            const usize written = cqe.res < 0 ? 0 : static_cast<usize>(cqe.res);
+            const bool success = written == sizes[buffer] || pwriteFully(fd,
+                                                                         bufferAt(buffer) + written,
+                                                                         sizes[buffer] - written,
+                                                                         offsets[buffer] + written);
+            return {buffer, success};
+        }
+    }
+
+private:
+    bool mapRings(const io_uring_params &params) noexcept
+    {
+        const auto map = [this](usize size, u64 offset) -> u8 * {
+            void *address = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, offset);
+            return address == MAP_FAILED ? nullptr : static_cast<u8 *>(address);
+        };
+
+        sqRingSize = params.sq_off.array + params.sq_entries * sizeof(u32);
+        cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMap) {
+            sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+        }
+
+        if ((sqRing = map(sqRingSize, IORING_OFF_SQ_RING)) == nullptr) {
+            return false;
+        }
+        if ((cqRing = singleMap ? sqRing : map(cqRingSize, IORING_OFF_CQ_RING)) == nullptr) {
+            return false;
+        }
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        if ((sqes = reinterpret_cast<io_uring_sqe *>(map(sqesSize, IORING_OFF_SQES))) == nullptr) {
+            return false;
+        }
+
+        sqTail = reinterpret_cast<u32 *>(sqRing + params.sq_off.tail);
+        sqMask = reinterpret_cast<u32 *>(sqRing + params.sq_off.ring_mask);
+        sqArray = reinterpret_cast<u32 *>(sqRing + params.sq_off.array);
+        cqHead = reinterpret_cast<u32 *>(cqRing + params.cq_off.head);
+        cqTail = reinterpret_cast<u32 *>(cqRing + params.cq_off.tail);
+        cqMask = reinterpret_cast<u32 *>(cqRing + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe *>(cqRing + params.cq_off.cqes);
+        return true;
+    }
+
+    void registerBuffers() noexcept
+    {
+        iovec vectors[ASYNC_WRITE_BUFFER_COUNT];
+        for (u32 i = 0; i < ASYNC_WRITE_BUFFER_COUNT; ++i) {
+            vectors[i] = {bufferAt(i), ASYNC_WRITE_BUFFER_SIZE};
+        }
+        // registration counts against the locked memory limit, so it may fail for unprivileged users
+        const long result =
+            ::syscall(__NR_io_uring_register, ringFd, IORING_REGISTER_BUFFERS, vectors, ASYNC_WRITE_BUFFER_COUNT);
+        registered = result == 0;
+        VXIO_LOG(DEBUG, std::string{"Writing with io_uring "} + (registered ? "with" : "without") + " fixed buffers");
+    }
+
+    void enter(u32 toSubmit, u32 minComplete, u32 flags) noexcept
+    {
+        while (::syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, nullptr, 0) < 0) {
+            VXIO_ASSERTM(errno == EINTR || errno == EAGAIN, "io_uring_enter failed: " + std::string{strerror(errno)});
+        }
+    }
+};
+
+#endif  // OBJ2VOXEL_ASYNC_IO_URING
+
+// ASYNC FILE OUTPUT STREAM ============================================================================================
+
+/**
+ * @brief An output stream which collects bytes in fixed buffers and writes full buffers in the background.
+ * Every buffer is written to a fixed offset, which is a multiple of the buffer size.
+ * Flushing writes the partially filled buffer too, but keeps filling it afterwards and writes it again once it is full.
+ * This keeps all offsets and sizes aligned, as required for direct I/O.
+ * Sequential streams write to pipes instead, where every byte can only be written once, so flushing moves on to the
+ * next buffer.
+ */
+class AsyncFileOutputStream final : public OutputStream {
+private:
+    int fd;
+    bool direct;
+    bool sequential;
+    u8 *buffers;
+    std::unique_ptr<WriteBackend> backend;
+    std::vector<u32> freeBuffers;
+    u32 current = 0;
+    usize fill = 0;
+    /// The offset in the file at which the current buffer is written.
+    u64 offset = 0;
+    u32 inFlight = 0;
+
+public:
+    AsyncFileOutputStream(int fd, bool direct, bool sequential) : fd{fd}, direct{direct}, sequential{sequential}
+    {
+        constexpr usize totalSize = usize{ASYNC_WRITE_BUFFER_COUNT} * ASYNC_WRITE_BUFFER_SIZE;
+        buffers = static_cast<u8 *>(std::aligned_alloc(DIRECT_IO_ALIGNMENT, totalSize));
+        VXIO_ASSERT_NOTNULL(buffers);
+
+#ifdef OBJ2VOXEL_ASYNC_IO_URING
+        // writes to pipes could be reordered by the ring, so they are left to the thread
+        if (not sequential) {
+            backend = UringWriteBackend::create(fd, buffers);
+        }
+#endif
+        if (backend == nullptr) {
+            const std::string function = sequential ? "write()" : "pwrite()";
+            VXIO_LOG(DEBUG, "Writing with " + function + " on a background thread");
+            backend = std::make_unique<ThreadWriteBackend>(fd, buffers, sequential);
+        }
+
+        for (u32 i = ASYNC_WRITE_BUFFER_COUNT - 1; i != 0; --i) {
+            freeBuffers.push_back(i);
+        }
+    }
+
+    AsyncFileOutputStream(const AsyncFileOutputStream &) = delete;
+
+    ~AsyncFileOutputStream() final
+    {
+        flush();
+        backend.reset();
+        std::free(buffers);
+        ::close(fd);
+    }
+
+    void write(u8 byte) final
+    {
+        buffers[usize{current} * ASYNC_WRITE_BUFFER_SIZE + fill++] = byte;
+        if (fill == ASYNC_WRITE_BUFFER_SIZE) {
+            submitCurrent();
+        }
+    }
+
+    void write(const u8 *data, usize size) final
+    {
+        while (size != 0) {
+            const usize count = std::min(size, ASYNC_WRITE_BUFFER_SIZE - fill);
+            std::memcpy(buffers + usize{current} * ASYNC_WRITE_BUFFER_SIZE + fill, data, count);
+            fill += count;
+            data += count;
+            size -= count;
+            if (fill == ASYNC_WRITE_BUFFER_SIZE) {
+                submitCurrent();
+            }
+        }
+    }
+
+    void flush() final
+    {
+        if (sequential) {
+            if (fill != 0) {
+                submitCurrent();
+            }
+            while (inFlight != 0) {
+                completeWrite();
+            }
+            return;
+        }
+        if (fill != 0) {
+            // direct I/O can only write whole blocks, so the last block is padded and truncated afterwards
+            const usize size = direct ? divCeil(fill, usize{DIRECT_IO_ALIGNMENT}) * DIRECT_IO_ALIGNMENT : fill;
+            std::memset(buffers + usize{current} * ASYNC_WRITE_BUFFER_SIZE + fill, 0, size - fill);
+            backend->submit(current, size, offset);
+            ++inFlight;
+        }
+        while (inFlight != 0) {
+            completeWrite();
+        }
+        if (fill != 0) {
+            // the current buffer is kept and has been returned to the free buffers by its completion
+            freeBuffers.erase(std::find(freeBuffers.begin(), freeBuffers.end(), current));
+            if (direct && ::ftruncate(fd, static_cast<off_t>(offset + fill)) != 0) {
+                flagErr = true;
+            }
+        }
+    }
+
+private:
+    void submitCurrent() noexcept
+    {
+        backend->submit(current, fill, offset);
+        ++inFlight;
+        offset += fill;
+        fill = 0;
+
+        if (freeBuffers.empty()) {
+            completeWrite();
+        }
+        current = freeBuffers.back();
+        freeBuffers.pop_back();
+    }
+
+    void completeWrite() noexcept
+    {
+        VXIO_DEBUG_ASSERT_NE(inFlight, 0u);
+        const WriteResult result = backend->wait();
+        --inFlight;
+        if (not result.success && not flagErr) {
+            VXIO_LOG(ERROR, "Failed to write output file");
+            flagErr = true;
+        }
+        freeBuffers.push_back(result.buffer);
+    }
+};
+
+}  // namespace
+
+std::unique_ptr<OutputStream> openAsyncFileOutput(const std::string &path, bool directIo) noexcept
+{
+    if (isStdioPath(path)) {
+        // the duplicate can be closed by the stream without closing standard output
+        const int fd = ::fcntl(STDOUT_FILENO, F_DUPFD_CLOEXEC, 0);
+        if (fd < 0) {
+            return nullptr;
+        }
+        enlargePipe(fd);
+        return std::make_unique<AsyncFileOutputStream>(fd, false, true);
+    }
+
+    constexpr int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+    int fd = -1;
+#ifdef O_DIRECT
+    if (directIo) {
+        fd = ::open(path.c_str(), flags | O_DIRECT, 0666);
+        if (fd < 0 && errno == EINVAL) {
+            VXIO_LOG(WARNING, "Direct I/O is not supported for \"" + path + "\", writing through the page cache");
+            directIo = false;
+        }
+    }
+#else
+    if (directIo) {
+        VXIO_LOG(WARNING, "Direct I/O is not supported on this platform, writing through the page cache");
+        directIo = false;
+    }
+#endif
+    if (not directIo) {
+        fd = ::open(path.c_str(), flags, 0666);
+    }
+    if (fd < 0) {
+        return nullptr;
+    }
+    return std::make_unique<AsyncFileOutputStream>(fd, directIo, false);
+}
+
+#else
+
+std::unique_ptr<OutputStream> openAsyncFileOutput(const std::string &path, bool directIo) noexcept
+{
+    if (isStdioPath(path)) {
+        VXIO_LOG(ERROR, "Writing to standard output is not supported on this platform");
+        return nullptr;
+    }
+    if (directIo) {
+        VXIO_LOG(WARNING, "Direct I/O is not supported on this platform, writing through the page cache");
+    }
+    std::optional<FileOutputStream> stream = FileOutputStream::open(path, OpenMode::BINARY);
+    if (not stream.has_value()) {
+        return nullptr;
+    }
+    return std::make_unique<FileOutputStream>(std::move(*stream));
+}
+
+#endif  // OBJ2VOXEL_ASYNC_IO_POSIX
+
+}  // namespace obj2voxel
@@ -0,0 +1,33 @@
+#ifndef OBJ2VOXEL_ASYNCFILE_HPP
+#define OBJ2VOXEL_ASYNCFILE_HPP
+
+#include "voxelio/streamfwd.hpp"
+
+#include <memory>
+#include <string>
+
+namespace obj2voxel {
+
+using namespace voxelio;
+
+/**
+ * @brief Opens a file for writing whose stream writes in large blocks with several writes in flight.
+ * Bytes are collected in one of a few fixed buffers, and each full buffer is written in the background while the next
+ * one is filled, so the writing thread only waits when every buffer is in flight.
+ *
+ * On Linux, writes are submitted to an io_uring with registered buffers.
+ * If io_uring is unavailable, a background thread writes the buffers with pwrite() instead.
+ * On platforms without either, a regular FileOutputStream is returned.
+ *
+ * If the path is "-", the buffers are written to standard output one after another, without direct I/O.
+ *
+ * @param path the file path or "-" for standard output
+ * @param directIo true if the file should be written with O_DIRECT, bypassing the page cache.
+ * If the file system doesn't support direct I/O, the file is written through the page cache.
+ * @return the stream or nullptr if the file couldn't be opened
+ */
+std::unique_ptr<OutputStream> openAsyncFileOutput(const std::string &path, bool directIo) noexcept;
+
+}  // namespace obj2voxel
+
+#endif  // OBJ2VOXEL_ASYNCFILE_HPP
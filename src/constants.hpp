@@ -8,9 +8,30 @@
 namespace obj2voxel {
 
 constexpr uint32_t CHUNK_SIZE = 64;
+// Chunks are identified by 64-bit Morton indices, which have 21 bits per axis
+constexpr uint32_t MAX_SAMPLE_RESOLUTION = CHUNK_SIZE << 21;
+// Distance fields are dense grids with five bytes per voxel, which is 40 GiB at this resolution
+constexpr uint32_t MAX_SDF_RESOLUTION = 2048;
 constexpr uint32_t BATCH_SIZE = 1024;
+// Number of triangles per page of triangle storage, which is released once all chunks referencing it are voxelized
+constexpr uint32_t TRIANGLE_PAGE_SIZE = 4 * BATCH_SIZE;
+// Number of distance grid lines transformed by one worker command
+constexpr uint32_t SDF_LINE_BATCH_SIZE = 256;
+// Maximum number of Morton ranges per axis into which chunks are divided, so that ranges can be binned concurrently
+constexpr uint32_t CHUNK_RANGES_PER_AXIS = 4;
+// Edge length in chunks of the cubic regions into which tiled models are divided
+constexpr uint32_t TILE_REGION_SIZE = 4;
+// Number and size of the buffers of asynchronous file output, which also bounds the number of writes in flight
+constexpr uint32_t ASYNC_WRITE_BUFFER_COUNT = 4;
+constexpr uint32_t ASYNC_WRITE_BUFFER_SIZE = 1024 * 1024;
+// Alignment of memory, offsets and sizes of direct I/O writes
+constexpr uint32_t DIRECT_IO_ALIGNMENT = 4096;
+// Size of the blocks in which standard input is read and the capacity requested for pipes on either end
+constexpr uint32_t PIPE_BUFFER_SIZE = 1024 * 1024;
 
 constexpr size_t SUBDIVISION_VOLUME_LIMIT = 512;
+// Triangles with less area than this (in squared voxels after transformation) are culled before voxelization
+constexpr float DEGENERATE_TRIANGLE_AREA = 1.f / (1 << 16);
 // This corresponds to an angle of 60° or higher from the diagonal vector
 constexpr float COS_SUBDIVISION_DIAGONALITY_LIMIT = 0.5f;
 
@@ -33,12 +54,22 @@ constexpr const char *VERBOSE_DESCR = "Enables verbose logging.";
 constexpr const char *VERSION_DESCR = "Displays the version and other information.";
 constexpr const char *EIGHTY_DESCR = "Print help menu in 80 column mode.";
 
-constexpr const char *INPUT_DESCR = "First argument. Path to input file.";
-constexpr const char *OUTPUT_DESCR = "Second argument. Path to output file.";
+constexpr const char *INPUT_DESCR = "First argument. Path to input file, or - for standard input.";
+constexpr const char *OUTPUT_DESCR = "Second argument. Path to output file, or - for standard output.";
 
 constexpr const char *INPUT_FORMAT_DESCR = "Explicit input format. (Optional)";
 constexpr const char *OUTPUT_FORMAT_DESCR = "Explicit output format. (Optional)";
 
+constexpr const char *NORMALS_DESCR = "Path to an additional VL32 file in which each voxel stores its area-weighted "
+                                      "surface normal, octahedrally encoded, instead of a color. (Optional)";
+
+constexpr const char *OUTPUT_TILES_DESCR = "Splits the output into this many tiles per axis, which are written to "
+                                           "separate files as soon as they are complete, along with a manifest. "
+                                           "(Default: 0, single file)";
+
+constexpr const char *DIRECT_IO_DESCR = "Writes output files with O_DIRECT, bypassing the page cache. This keeps "
+                                        "multi-gigabyte outputs from evicting cached input files.";
+
 constexpr const char *TEXTURE_DESCR = "Fallback texture path. Used when model has UV coordinates but textures can't "
                                       "be found in the material library. (Default: none)";
 
@@ -56,6 +87,35 @@ constexpr const char *SS_DESCR =
     "Enables supersampling. "
     "The model is voxelized at double resolution and then downscaled while combining colors.";
 
+constexpr const char *THIN_DESCR = "Keeps only the voxels needed for a 6-separating surface instead of every voxel "
+                                   "that the surface touches. This produces fewer voxels on diagonal surfaces.";
+
+constexpr const char *MATERIALS_DESCR = "Colors each voxel with the diffuse color of the material with the greatest "
+                                        "area instead of sampling textures. Paletted formats get one palette entry "
+                                        "per material.";
+
+constexpr const char *ALPHA_CUTOFF_DESCR = "Discards texture samples whose alpha is below this value in [0, 1], "
+                                           "e.g. for foliage textures. (Default: 0, disabled)";
+
+constexpr const char *DECIMATE_DESCR = "Clusters vertices on a grid with this many cells per voxel and axis before "
+                                       "voxelizing, which removes redundant triangles from dense meshes. "
+                                       "(Default: 0, disabled)";
+
+constexpr const char *MORPH_DESCR = "Comma-separated morphological operations applied after voxelization, each as "
+                                    "operation:radius, where the operation is dilate, erode, close or hollow. "
+                                    "(e.g. close:2,hollow:1)";
+
+constexpr const char *MIN_ISLAND_DESCR = "Removes connected components of voxels with fewer voxels than this, "
+                                         "such as the floating islands of scanned meshes. (Default: 0, disabled)";
+
+constexpr const char *KEEP_LARGEST_DESCR = "Keeps only this many of the largest connected components of voxels. "
+                                           "(Default: 0, all)";
+
+constexpr const char *SDF_DESCR = "Writes a signed distance field in NRRD format instead of voxels. "
+                                  "Distances are clamped to this band in voxels, 0 for no clamping.";
+
+constexpr const char *SDF_QUANTIZED_DESCR = "Stores distances as 8-bit integers scaled to the band instead of floats.";
+
 constexpr const char *THREADS_DESCR = "Number of worker threads to be started for voxelization. "
                                       "Set to zero for single-threaded voxelization. "
                                       "(Default: CPU threads)";
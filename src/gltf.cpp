@@ -0,0 +1,848 @@
+#include "io.hpp"
+#include "mappedfile.hpp"
+
+#include "voxelio/format/png.hpp"
+#include "voxelio/log.hpp"
+#include "voxelio/stringify.hpp"
+
+#include <cstdlib>
+#include <future>
+#include <limits>
+#include <string_view>
+
+namespace obj2voxel {
+namespace {
+
+// JSON ================================================================================================================
+
+constexpr usize NO_INDEX = ~usize{0};
+
+/// A minimal JSON document model, just large enough for reading glTF.
+struct JsonValue {
+    enum class Type : u8 { NUL, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT };
+
+    Type type = Type::NUL;
+    bool boolean = false;
+    double number = 0;
+    std::string string;
+    /// Array elements or object member values.
+    std::vector<JsonValue> values;
+    /// Object member keys, parallel to values.
+    std::vector<std::string> keys;
+
+    /// Returns the object member with the given key or nullptr.
+    const JsonValue *find(std::string_view key) const noexcept
+    {
+        for (usize i = 0; i < keys.size(); ++i) {
+            if (keys[i] == key) {
+                return &values[i];
+            }
+        }
+        return nullptr;
+    }
+
+    /// Returns the array element at the given index or nullptr.
+    const JsonValue *at(usize index) const noexcept
+    {
+        return type == Type::ARRAY && index < values.size() ? &values[index] : nullptr;
+    }
+
+    /// Returns the number of the member with the given key or a default value if there is no such number.
+    double numberOr(std::string_view key, double defaultValue) const noexcept
+    {
+        const JsonValue *member = find(key);
+        return member != nullptr && member->type == Type::NUMBER ? member->number : defaultValue;
+    }
+
+    /// Returns the number as an index or NO_INDEX if it is not a number in the range of usize.
+    usize asIndex() const noexcept
+    {
+        // the upper limit is 2^64 exactly, which is the smallest double that would overflow the conversion
+        constexpr double limit = static_cast<double>(std::numeric_limits<usize>::max());
+        return type == Type::NUMBER && number >= 0 && number < limit ? static_cast<usize>(number) : NO_INDEX;
+    }
+
+    /// Returns the non-negative integer of the member with the given key or a default value.
+    usize indexOr(std::string_view key, usize defaultValue) const noexcept
+    {
+        const JsonValue *member = find(key);
+        const usize index = member == nullptr ? NO_INDEX : member->asIndex();
+        return index != NO_INDEX ? index : defaultValue;
+    }
+};
+
+class JsonParser {
+private:
+    static constexpr usize MAX_DEPTH = 64;
+
+    std::string_view in;
+    usize pos = 0;
+    usize depth = 0;
+
+public:
+    explicit JsonParser(std::string_view in) noexcept : in{in} {}
+
+    /// Parses the entire input. Returns false if the input is not a single valid JSON value.
+    bool parse(JsonValue &out) noexcept
+    {
+        if (not parseValue(out)) {
+            return false;
+        }
+        skipWhitespace();
+        // GLB pads the JSON chunk with spaces, but some writers use null bytes instead
+        while (pos < in.size() && in[pos] == '\0') {
+            ++pos;
+        }
+        return pos == in.size();
+    }
+
+private:
+    void skipWhitespace() noexcept
+    {
+        while (pos < in.size() && (in[pos] == ' ' || in[pos] == '\t' || in[pos] == '\n' || in[pos] == '\r')) {
+            ++pos;
+        }
+    }
+
+    bool consume(char c) noexcept
+    {
+        skipWhitespace();
+        if (pos < in.size() && in[pos] == c) {
+            ++pos;
+            return true;
+        }
+        return false;
+    }
+
+    bool consumeLiteral(std::string_view literal) noexcept
+    {
+        if (in.substr(pos, literal.size()) != literal) {
+            return false;
+        }
+        pos += literal.size();
+        return true;
+    }
+
+    bool parseValue(JsonValue &out) noexcept
+    {
+        skipWhitespace();
+        if (pos >= in.size() || depth >= MAX_DEPTH) {
+            return false;
+        }
+        switch (in[pos]) {
+        case '{': return parseObject(out);
+        case '[': return parseArray(out);
+        case '"': out.type = JsonValue::Type::STRING; return parseString(out.string);
+        case 't': out.type = JsonValue::Type::BOOLEAN; out.boolean = true; return consumeLiteral("true");
+        case 'f': out.type = JsonValue::Type::BOOLEAN; return consumeLiteral("false");
+        case 'n': out.type = JsonValue::Type::NUL; return consumeLiteral("null");
+        default: out.type = JsonValue::Type::NUMBER; return parseNumber(out.number);
+        }
+    }
+
+    bool parseObject(JsonValue &out) noexcept
+    {
+        out.type = JsonValue::Type::OBJECT;
+        ++pos;
+        ++depth;
+        if (consume('}')) {
+            --depth;
+            return true;
+        }
+        do {
+            skipWhitespace();
+            std::string &key = out.keys.emplace_back();
+            if (not parseString(key) || not consume(':') || not parseValue(out.values.emplace_back())) {
+                return false;
+            }
+        } while (consume(','));
+        --depth;
+        return consume('}');
+    }
+
+    bool parseArray(JsonValue &out) noexcept
+    {
+        out.type = JsonValue::Type::ARRAY;
+        ++pos;
+        ++depth;
+        if (consume(']')) {
+            --depth;
+            return true;
+        }
+        do {
+            if (not parseValue(out.values.emplace_back())) {
+                return false;
+            }
+        } while (consume(','));
+        --depth;
+        return consume(']');
+    }
+
+    bool parseString(std::string &out) noexcept
+    {
+        if (pos >= in.size() || in[pos] != '"') {
+            return false;
+        }
+        for (++pos; pos < in.size(); ++pos) {
+            const char c = in[pos];
+            if (c == '"') {
+                ++pos;
+                return true;
+            }
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (++pos >= in.size()) {
+                return false;
+            }
+            switch (in[pos]) {
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u': {
+                // glTF keys and URIs are practically always ASCII, so we only encode the basic multilingual plane
+                if (pos + 4 >= in.size()) {
+                    return false;
+                }
+                const std::string hex{in.substr(pos + 1, 4)};
+                const auto codePoint = static_cast<u32>(std::strtoul(hex.c_str(), nullptr, 16));
+                pos += 4;
+                if (codePoint < 0x80) {
+                    out += static_cast<char>(codePoint);
+                }
+                else if (codePoint < 0x800) {
+                    out += static_cast<char>(0xc0 | (codePoint >> 6));
+                    out += static_cast<char>(0x80 | (codePoint & 0x3f));
+                }
+                else {
+                    out += static_cast<char>(0xe0 | (codePoint >> 12));
+                    out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3f));
+                    out += static_cast<char>(0x80 | (codePoint & 0x3f));
+                }
+                break;
+            }
+            default: out += in[pos]; break;
+            }
+        }
+        return false;
+    }
+
+    bool parseNumber(double &out) noexcept
+    {
+        const usize start = pos;
+        while (pos < in.size() && std::string_view{"+-0123456789.eE"}.find(in[pos]) != std::string_view::npos) {
+            ++pos;
+        }
+        if (start == pos) {
+            return false;
+        }
+        const std::string number{in.substr(start, pos - start)};
+        char *end = nullptr;
+        out = std::strtod(number.c_str(), &end);
+        return end == number.c_str() + number.size();
+    }
+};
+
+// GLTF ACCESSORS ======================================================================================================
+
+constexpr u32 GLB_MAGIC = 0x46546C67;
+constexpr u32 GLB_CHUNK_JSON = 0x4E4F534A;
+constexpr u32 GLB_CHUNK_BIN = 0x004E4942;
+
+enum class ComponentType : u32 {
+    BYTE = 5120,
+    UNSIGNED_BYTE = 5121,
+    SHORT = 5122,
+    UNSIGNED_SHORT = 5123,
+    UNSIGNED_INT = 5125,
+    FLOAT = 5126
+};
+
+constexpr usize sizeOf(ComponentType type) noexcept
+{
+    switch (type) {
+    case ComponentType::BYTE:
+    case ComponentType::UNSIGNED_BYTE: return 1;
+    case ComponentType::SHORT:
+    case ComponentType::UNSIGNED_SHORT: return 2;
+    case ComponentType::UNSIGNED_INT:
+    case ComponentType::FLOAT: return 4;
+    }
+    return 0;
+}
+
+enum class PrimitiveMode : u32 { POINTS, LINES, LINE_LOOP, LINE_STRIP, TRIANGLES, TRIANGLE_STRIP, TRIANGLE_FAN };
+
+/// A strided view of accessor data inside the memory-mapped binary chunk.
+struct AccessorView {
+    const u8 *data = nullptr;
+    usize stride = 0;
+    usize count = 0;
+    ComponentType componentType = ComponentType::FLOAT;
+    bool normalized = false;
+
+    bool isPresent() const noexcept
+    {
+        return data != nullptr;
+    }
+
+    /// Reads one component of an element as float, applying normalization to integer types.
+    float component(usize element, usize index) const noexcept
+    {
+        VXIO_DEBUG_ASSERT_LT(element, count);
+        const u8 *bytes = data + element * stride + index * sizeOf(componentType);
+        switch (componentType) {
+        case ComponentType::FLOAT: return decodeLittle<f32>(bytes);
+        case ComponentType::UNSIGNED_BYTE: return normalized ? bytes[0] / 255.f : bytes[0];
+        case ComponentType::UNSIGNED_SHORT: {
+            const u16 value = decodeLittle<u16>(bytes);
+            return normalized ? value / 65535.f : value;
+        }
+        case ComponentType::BYTE: {
+            const auto value = static_cast<i8>(bytes[0]);
+            return normalized ? std::max(value / 127.f, -1.f) : value;
+        }
+        case ComponentType::SHORT: {
+            const i16 value = decodeLittle<i16>(bytes);
+            return normalized ? std::max(value / 32767.f, -1.f) : value;
+        }
+        case ComponentType::UNSIGNED_INT: return static_cast<float>(decodeLittle<u32>(bytes));
+        }
+        VXIO_DEBUG_ASSERT_UNREACHABLE();
+    }
+
+    /// Reads an element of an index accessor.
+    u32 index(usize element) const noexcept
+    {
+        VXIO_DEBUG_ASSERT_LT(element, count);
+        const u8 *bytes = data + element * stride;
+        switch (componentType) {
+        case ComponentType::UNSIGNED_BYTE: return bytes[0];
+        case ComponentType::UNSIGNED_SHORT: return decodeLittle<u16>(bytes);
+        default: return decodeLittle<u32>(bytes);
+        }
+    }
+};
+
+/// A material which is fully resolved so that no lookups are necessary during triangle iteration.
+struct GltfMaterial {
+    TriangleType type = TriangleType::MATERIALLESS;
+    const Texture *texture = nullptr;
+    Vec3f color = Vec3f::one();
+};
+
+struct GltfPrimitive {
+    AccessorView positions;
+    AccessorView uvs;
+    AccessorView indices;
+    PrimitiveMode mode;
+    AffineTransform transform;
+    GltfMaterial material;
+
+    /// Returns the number of elements (vertices or indices) which make up the triangles.
+    usize elementCount() const noexcept
+    {
+        return indices.isPresent() ? indices.count : positions.count;
+    }
+
+    usize triangleCount() const noexcept
+    {
+        const usize elements = elementCount();
+        if (mode == PrimitiveMode::TRIANGLES) {
+            return elements / 3;
+        }
+        return elements >= 3 ? elements - 2 : 0;
+    }
+};
+
+/// Holds everything needed while reading the glTF document.
+struct GltfDocument {
+    JsonValue json;
+    const u8 *bin = nullptr;
+    usize binSize = 0;
+    std::string error;
+
+    const JsonValue *element(std::string_view array, usize index) const noexcept
+    {
+        const JsonValue *values = json.find(array);
+        return values == nullptr ? nullptr : values->at(index);
+    }
+
+    /// Resolves an accessor into a view of the binary chunk. Returns false and sets error on failure.
+    /// Index accessors must be scalars of an unsigned integer type.
+    bool resolveAccessor(usize index, usize expectedComponents, AccessorView &out, bool isIndexAccessor = false)
+    {
+        const JsonValue *accessor = element("accessors", index);
+        if (accessor == nullptr) {
+            error = "Missing accessor " + stringify(index);
+            return false;
+        }
+        const JsonValue *typeValue = accessor->find("type");
+        const std::string type = typeValue == nullptr ? "" : typeValue->string;
+        const usize components = type == "SCALAR" ? 1
+                                 : type == "VEC2" ? 2
+                                 : type == "VEC3" ? 3
+                                 : type == "VEC4" ? 4
+                                                  : 0;
+        if (components != expectedComponents) {
+            error = "Accessor " + stringify(index) + " has unexpected type \"" + type + '"';
+            return false;
+        }
+
+        out.componentType = static_cast<ComponentType>(accessor->indexOr("componentType", 0));
+        out.count = accessor->indexOr("count", 0);
+        out.normalized = accessor->find("normalized") != nullptr && accessor->find("normalized")->boolean;
+        const usize elementSize = sizeOf(out.componentType) * components;
+        if (elementSize == 0) {
+            error = "Accessor " + stringify(index) + " has unsupported component type";
+            return false;
+        }
+        if (isIndexAccessor && out.componentType != ComponentType::UNSIGNED_BYTE &&
+            out.componentType != ComponentType::UNSIGNED_SHORT && out.componentType != ComponentType::UNSIGNED_INT) {
+            error = "Index accessor " + stringify(index) + " must have an unsigned integer component type";
+            return false;
+        }
+
+        const usize viewIndex = accessor->indexOr("bufferView", NO_INDEX);
+        const JsonValue *view = element("bufferViews", viewIndex);
+        if (view == nullptr) {
+            // sparse accessors without buffer views are only used for morph targets which we don't support
+            error = "Accessor " + stringify(index) + " has no buffer view";
+            return false;
+        }
+        if (view->indexOr("buffer", 0) != 0 || bin == nullptr) {
+            error = "Buffer view " + stringify(viewIndex) + " does not reference the GLB binary chunk";
+            return false;
+        }
+
+        const usize viewOffset = view->indexOr("byteOffset", 0);
+        const usize viewLength = view->indexOr("byteLength", 0);
+        const usize accessorOffset = accessor->indexOr("byteOffset", 0);
+        out.stride = view->indexOr("byteStride", elementSize);
+
+        // all sizes come from the document, so the accessor extent is compared without computing it
+        bool inBounds = viewOffset <= binSize && viewLength <= binSize - viewOffset;
+        if (inBounds && out.count != 0) {
+            inBounds = accessorOffset <= viewLength && elementSize <= viewLength - accessorOffset;
+            const usize strideSpace = inBounds ? viewLength - accessorOffset - elementSize : 0;
+            inBounds = inBounds && (out.stride == 0 || out.count - 1 <= strideSpace / out.stride);
+        }
+        if (not inBounds) {
+            error = "Accessor " + stringify(index) + " exceeds the bounds of its buffer";
+            return false;
+        }
+        out.data = bin + viewOffset + accessorOffset;
+        return true;
+    }
+
+    /// Returns the bytes of a buffer view in the binary chunk or false on failure.
+    bool resolveBufferView(usize index, const u8 *&outData, usize &outSize) const noexcept
+    {
+        const JsonValue *view = element("bufferViews", index);
+        if (view == nullptr || view->indexOr("buffer", 0) != 0 || bin == nullptr) {
+            return false;
+        }
+        const usize offset = view->indexOr("byteOffset", 0);
+        const usize length = view->indexOr("byteLength", 0);
+        if (offset > binSize || length > binSize - offset) {
+            return false;
+        }
+        outData = bin + offset;
+        outSize = length;
+        return true;
+    }
+};
+
+// TRANSFORMS ==========================================================================================================
+
+AffineTransform localTransformOf(const JsonValue &node)
+{
+    AffineTransform result{};
+
+    if (const JsonValue *matrix = node.find("matrix"); matrix != nullptr && matrix->values.size() == 16) {
+        // glTF matrices are column-major
+        for (usize row = 0; row < 3; ++row) {
+            for (usize col = 0; col < 3; ++col) {
+                result.matrix[row][col] = static_cast<real_type>(matrix->values[col * 4 + row].number);
+            }
+            result.translation[row] = static_cast<real_type>(matrix->values[12 + row].number);
+        }
+        return result;
+    }
+
+    Vec3 scale = Vec3::one();
+    if (const JsonValue *s = node.find("scale"); s != nullptr && s->values.size() == 3) {
+        scale = {s->values[0].number, s->values[1].number, s->values[2].number};
+    }
+
+    if (const JsonValue *r = node.find("rotation"); r != nullptr && r->values.size() == 4) {
+        const auto x = static_cast<real_type>(r->values[0].number);
+        const auto y = static_cast<real_type>(r->values[1].number);
+        const auto z = static_cast<real_type>(r->values[2].number);
+        const auto w = static_cast<real_type>(r->values[3].number);
+        result.matrix[0] = {1 - 2 * (y * y + z * z), 2 * (x * y - z * w), 2 * (x * z + y * w)};
+        result.matrix[1] = {2 * (x * y + z * w), 1 - 2 * (x * x + z * z), 2 * (y * z - x * w)};
+        result.matrix[2] = {2 * (x * z - y * w), 2 * (y * z + x * w), 1 - 2 * (x * x + y * y)};
+    }
+
+    // R * S scales the columns of R
+    for (usize row = 0; row < 3; ++row) {
+        for (usize col = 0; col < 3; ++col) {
+            result.matrix[row][col] *= scale[col];
+        }
+    }
+
+    if (const JsonValue *t = node.find("translation"); t != nullptr && t->values.size() == 3) {
+        result.translation = {t->values[0].number, t->values[1].number, t->values[2].number};
+    }
+    return result;
+}
+
+// GLB TRIANGLE STREAM =================================================================================================
+
+struct GlbTriangleStream final : public ITriangleStream {
+private:
+    MappedFile file;
+    std::vector<std::optional<Texture>> images;
+    std::vector<GltfPrimitive> primitives;
+
+    usize primitiveIndex = 0;
+    usize triangleIndex = 0;
+
+public:
+    GlbTriangleStream(MappedFile file,
+                      std::vector<std::optional<Texture>> images,
+                      std::vector<GltfPrimitive> primitives) noexcept
+        : file{std::move(file)}, images{std::move(images)}, primitives{std::move(primitives)}
+    {
+    }
+
+    bool next(VisualTriangle &out) noexcept final;
+};
+
+bool GlbTriangleStream::next(VisualTriangle &triangle) noexcept
+{
+    while (primitiveIndex < primitives.size() && triangleIndex >= primitives[primitiveIndex].triangleCount()) {
+        ++primitiveIndex;
+        triangleIndex = 0;
+    }
+    if (primitiveIndex >= primitives.size()) {
+        return false;
+    }
+
+    const GltfPrimitive &primitive = primitives[primitiveIndex];
+    const usize t = triangleIndex++;
+
+    usize elements[3];
+    switch (primitive.mode) {
+    case PrimitiveMode::TRIANGLE_STRIP: elements[0] = t, elements[1] = t + 1, elements[2] = t + 2; break;
+    case PrimitiveMode::TRIANGLE_FAN: elements[0] = 0, elements[1] = t + 1, elements[2] = t + 2; break;
+    default: elements[0] = t * 3, elements[1] = t * 3 + 1, elements[2] = t * 3 + 2; break;
+    }
+
+    const bool textured = primitive.material.type == TriangleType::TEXTURED;
+    for (usize i = 0; i < 3; ++i) {
+        const usize vertex = primitive.indices.isPresent() ? primitive.indices.index(elements[i]) : elements[i];
+        const Vec3 position{primitive.positions.component(vertex, 0),
+                            primitive.positions.component(vertex, 1),
+                            primitive.positions.component(vertex, 2)};
+        triangle.v[i] = primitive.transform * position;
+        // glTF has its UV origin in the top left, VisualTriangle expects it in the bottom left like OBJ
+        triangle.t[i] = textured ? Vec2f{primitive.uvs.component(vertex, 0), 1 - primitive.uvs.component(vertex, 1)}
+                                 : Vec2f{};
+    }
+
+    triangle.type = primitive.material.type;
+    if (textured) {
+        triangle.texture = primitive.material.texture;
+    }
+    else {
+        triangle.color = primitive.material.color;
+    }
+    return true;
+}
+
+/// Decodes all images of the document concurrently.
+/// Embedded images are decoded straight from the mapped binary chunk; external images are loaded relative to the GLB.
+std::vector<std::optional<Texture>> decodeImages(const GltfDocument &doc, const std::string &glbFile)
+{
+    const JsonValue *imagesJson = doc.json.find("images");
+    const usize imageCount = imagesJson == nullptr ? 0 : imagesJson->values.size();
+
+    std::vector<std::future<std::optional<Texture>>> futures;
+    futures.reserve(imageCount);
+
+    for (usize i = 0; i < imageCount; ++i) {
+        const JsonValue &image = imagesJson->values[i];
+        const u8 *data = nullptr;
+        usize size = 0;
+
+        if (doc.resolveBufferView(image.indexOr("bufferView", NO_INDEX), data, size)) {
+            futures.push_back(std::async(std::launch::async, [data, size, i]() -> std::optional<Texture> {
+                std::string err;
+                std::optional<Image> decoded = voxelio::png::decode(data, size, 4, err);
+                if (not decoded.has_value()) {
+                    VXIO_LOG(WARNING, "Failed to decode embedded image " + stringify(i) + ": " + err);
+                    return std::nullopt;
+                }
+                decoded->setWrapMode(WrapMode::REPEAT);
+                return Texture{std::move(*decoded)};
+            }));
+        }
+        else if (const JsonValue *uri = image.find("uri"); uri != nullptr && uri->string.rfind("data:", 0) != 0) {
+            std::string path = resolveReferencedPath(glbFile, uri->string);
+            futures.push_back(std::async(std::launch::async, [path = std::move(path)]() {
+                return loadTexture(path, "glTF");
+            }));
+        }
+        else {
+            VXIO_LOG(WARNING, "Image " + stringify(i) + " is neither embedded nor an external file, ignoring it");
+            futures.push_back(std::async(std::launch::deferred, []() -> std::optional<Texture> {
+                return std::nullopt;
+            }));
+        }
+    }
+
+    std::vector<std::optional<Texture>> result;
+    result.reserve(imageCount);
+    for (auto &future : futures) {
+        result.push_back(future.get());
+    }
+    return result;
+}
+
+/// Resolves a glTF material into a texture pointer or a flat color.
+GltfMaterial resolveMaterial(const GltfDocument &doc,
+                             const std::vector<std::optional<Texture>> &images,
+                             usize materialIndex,
+                             usize &outTexCoord)
+{
+    GltfMaterial result;
+    outTexCoord = 0;
+
+    const JsonValue *material = doc.element("materials", materialIndex);
+    if (material == nullptr) {
+        return result;
+    }
+    result.type = TriangleType::UNTEXTURED;
+
+    const JsonValue *pbr = material->find("pbrMetallicRoughness");
+    if (pbr == nullptr) {
+        return result;
+    }
+    if (const JsonValue *factor = pbr->find("baseColorFactor"); factor != nullptr && factor->values.size() == 4) {
+        result.color = {factor->values[0].number, factor->values[1].number, factor->values[2].number};
+    }
+
+    // the base color factor is not applied on top of textures; textures are typically authored with a white factor
+    const JsonValue *textureInfo = pbr->find("baseColorTexture");
+    if (textureInfo == nullptr) {
+        return result;
+    }
+    const JsonValue *texture = doc.element("textures", textureInfo->indexOr("index", NO_INDEX));
+    const usize imageIndex = texture == nullptr ? NO_INDEX : texture->indexOr("source", NO_INDEX);
+    if (imageIndex >= images.size() || not images[imageIndex].has_value()) {
+        return result;
+    }
+
+    result.type = TriangleType::TEXTURED;
+    result.texture = &*images[imageIndex];
+    outTexCoord = textureInfo->indexOr("texCoord", 0);
+    return result;
+}
+
+/// Appends all triangle primitives of a mesh with the given transform.
+bool appendMeshPrimitives(GltfDocument &doc,
+                          const std::vector<std::optional<Texture>> &images,
+                          usize meshIndex,
+                          const AffineTransform &transform,
+                          std::vector<GltfPrimitive> &out)
+{
+    const JsonValue *mesh = doc.element("meshes", meshIndex);
+    const JsonValue *primitives = mesh == nullptr ? nullptr : mesh->find("primitives");
+    if (primitives == nullptr) {
+        doc.error = "Missing mesh " + stringify(meshIndex);
+        return false;
+    }
+
+    for (const JsonValue &primitiveJson : primitives->values) {
+        GltfPrimitive primitive{};
+        primitive.mode = static_cast<PrimitiveMode>(primitiveJson.indexOr("mode", 4));
+        primitive.transform = transform;
+
+        if (primitive.mode < PrimitiveMode::TRIANGLES || primitive.mode > PrimitiveMode::TRIANGLE_FAN) {
+            VXIO_LOG(WARNING, "Skipping non-triangle primitive in mesh " + stringify(meshIndex));
+            continue;
+        }
+
+        const JsonValue *attributes = primitiveJson.find("attributes");
+        const usize positionAccessor = attributes == nullptr ? NO_INDEX : attributes->indexOr("POSITION", NO_INDEX);
+        if (not doc.resolveAccessor(positionAccessor, 3, primitive.positions)) {
+            return false;
+        }
+
+        if (const usize indexAccessor = primitiveJson.indexOr("indices", NO_INDEX); indexAccessor != NO_INDEX) {
+            if (not doc.resolveAccessor(indexAccessor, 1, primitive.indices, true)) {
+                return false;
+            }
+            for (usize i = 0; i < primitive.indices.count; ++i) {
+                if (primitive.indices.index(i) >= primitive.positions.count) {
+                    doc.error = "Index accessor " + stringify(indexAccessor) + " references a missing vertex";
+                    return false;
+                }
+            }
+        }
+
+        usize texCoord = 0;
+        primitive.material = resolveMaterial(doc, images, primitiveJson.indexOr("material", NO_INDEX), texCoord);
+
+        if (primitive.material.type == TriangleType::TEXTURED) {
+            const usize uvAccessor = attributes->indexOr("TEXCOORD_" + stringify(texCoord), NO_INDEX);
+            if (uvAccessor == NO_INDEX) {
+                // textured material but no UVs; fall back to the flat base color
+                primitive.material.type = TriangleType::UNTEXTURED;
+            }
+            else if (not doc.resolveAccessor(uvAccessor, 2, primitive.uvs)) {
+                return false;
+            }
+            else if (primitive.uvs.count < primitive.positions.count) {
+                doc.error = "TEXCOORD accessor " + stringify(uvAccessor) + " has fewer elements than POSITION";
+                return false;
+            }
+        }
+
+        out.push_back(std::move(primitive));
+    }
+    return true;
+}
+
+bool appendNode(GltfDocument &doc,
+                const std::vector<std::optional<Texture>> &images,
+                usize nodeIndex,
+                const AffineTransform &parentTransform,
+                std::vector<GltfPrimitive> &out,
+                usize depth = 0)
+{
+    constexpr usize maxDepth = 256;
+
+    const JsonValue *node = doc.element("nodes", nodeIndex);
+    if (node == nullptr || depth > maxDepth) {
+        doc.error = "Missing node " + stringify(nodeIndex) + " or node hierarchy is cyclic";
+        return false;
+    }
+
+    const AffineTransform transform = parentTransform * localTransformOf(*node);
+
+    if (const usize mesh = node->indexOr("mesh", NO_INDEX); mesh != NO_INDEX) {
+        if (not appendMeshPrimitives(doc, images, mesh, transform, out)) {
+            return false;
+        }
+    }
+    if (const JsonValue *children = node->find("children"); children != nullptr) {
+        for (const JsonValue &child : children->values) {
+            if (not appendNode(doc, images, child.asIndex(), transform, out, depth + 1)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/// Reads the GLB container. Returns an error message or an empty string on success.
+std::string parseGlbContainer(const u8 *data, usize size, GltfDocument &out)
+{
+    if (size < 20 || decodeLittle<u32>(data) != GLB_MAGIC) {
+        return "File is not a binary glTF (GLB) file";
+    }
+    if (decodeLittle<u32>(data + 4) != 2) {
+        return "Only glTF 2.0 is supported";
+    }
+    const usize length = std::min(usize{decodeLittle<u32>(data + 8)}, size);
+
+    std::string_view json;
+    for (usize offset = 12; offset + 8 <= length;) {
+        const usize chunkLength = decodeLittle<u32>(data + offset);
+        const u32 chunkType = decodeLittle<u32>(data + offset + 4);
+        offset += 8;
+        if (chunkLength > length - offset) {
+            return "Chunk exceeds file size";
+        }
+        if (chunkType == GLB_CHUNK_JSON && json.empty()) {
+            json = {reinterpret_cast<const char *>(data + offset), chunkLength};
+        }
+        else if (chunkType == GLB_CHUNK_BIN && out.bin == nullptr) {
+            out.bin = data + offset;
+            out.binSize = chunkLength;
+        }
+        // chunks are padded to four bytes
+        offset += (chunkLength + 3) & ~usize{3};
+    }
+
+    if (json.empty()) {
+        return "GLB file has no JSON chunk";
+    }
+    if (not JsonParser{json}.parse(out.json) || out.json.type != JsonValue::Type::OBJECT) {
+        return "Malformed JSON chunk";
+    }
+    return {};
+}
+
+}  // namespace
+
+std::unique_ptr<ITriangleStream> ITriangleStream::fromGlbFile(const std::string &inFile) noexcept
+{
+    std::optional<MappedFile> file = MappedFile::open(inFile);
+    if (not file.has_value()) {
+        VXIO_LOG(ERROR, "Failed to open GLB file: \"" + inFile + "\"");
+        return nullptr;
+    }
+
+    GltfDocument doc;
+    if (std::string error = parseGlbContainer(file->data(), file->size(), doc); not error.empty()) {
+        VXIO_LOG(ERROR, "Failed to read GLB file \"" + inFile + "\": " + error);
+        return nullptr;
+    }
+
+    // images must be decoded before resolving materials because materials point to them
+    std::vector<std::optional<Texture>> images = decodeImages(doc, inFile);
+    std::vector<GltfPrimitive> primitives;
+
+    const JsonValue *scenes = doc.json.find("scenes");
+    const JsonValue *scene = scenes == nullptr ? nullptr : scenes->at(doc.json.indexOr("scene", 0));
+    bool success = true;
+
+    if (const JsonValue *roots = scene == nullptr ? nullptr : scene->find("nodes"); roots != nullptr) {
+        for (usize i = 0; success && i < roots->values.size(); ++i) {
+            success = appendNode(doc, images, roots->values[i].asIndex(), AffineTransform{}, primitives);
+        }
+    }
+    else {
+        // files without scenes are libraries of meshes; we voxelize all of them untransformed
+        const JsonValue *meshes = doc.json.find("meshes");
+        for (usize i = 0; success && meshes != nullptr && i < meshes->values.size(); ++i) {
+            success = appendMeshPrimitives(doc, images, i, AffineTransform{}, primitives);
+        }
+    }
+
+    if (not success) {
+        VXIO_LOG(ERROR, "Failed to read GLB file \"" + inFile + "\": " + doc.error);
+        return nullptr;
+    }
+
+    usize triangleCount = 0;
+    for (const GltfPrimitive &primitive : primitives) {
+        triangleCount += primitive.triangleCount();
+    }
+    VXIO_LOG(INFO,
+             "Mapped GLB file with " + stringifyLargeInt(primitives.size()) + " primitives, " +
+                 stringifyLargeInt(triangleCount) + " triangles and " + stringifyLargeInt(images.size()) +
+                 " images");
+
+    return std::unique_ptr<ITriangleStream>{
+        new GlbTriangleStream{std::move(*file), std::move(images), std::move(primitives)}};
+}
+
+}  // namespace obj2voxel
@@ -1,4 +1,5 @@
 #include "io.hpp"
+#include "pipes.hpp"
 
 // TODO consider not including all of voxelization because this is currently happening just for the triangle callback
 #include "voxelization.hpp"
@@ -17,6 +18,7 @@
 #include "voxelio/voxelio.hpp"
 
 #include <algorithm>
+#include <istream>
 
 #define TINYOBJLOADER_IMPLEMENTATION
 #include "3rd_party/tinyobj.hpp"
@@ -79,6 +81,28 @@ struct CallbackTriangleStream final : public ITriangleStream {
     }
 };
 
+struct BufferTriangleStream final : public ITriangleStream {
+    std::vector<std::vector<VisualTriangle>> buffers;
+    usize bufferIndex = 0;
+    usize triangleIndex = 0;
+
+    BufferTriangleStream(std::vector<std::vector<VisualTriangle>> buffers) : buffers{std::move(buffers)} {}
+
+    bool next(VisualTriangle &out) noexcept final
+    {
+        for (; bufferIndex < buffers.size(); ++bufferIndex, triangleIndex = 0) {
+            std::vector<VisualTriangle> &buffer = buffers[bufferIndex];
+            if (triangleIndex < buffer.size()) {
+                out = buffer[triangleIndex++];
+                return true;
+            }
+            // each buffer is freed once it has been streamed, since the triangles are cached by the caller
+            buffer = {};
+        }
+        return false;
+    }
+};
+
 template <usize PRIM_VERTICES, std::enable_if_t<PRIM_VERTICES == 3 || PRIM_VERTICES == 4, int> = 0>
 struct SimpleMeshTriangleStream final : public ITriangleStream {
     static constexpr usize floatsPerVertex = 3;
@@ -160,37 +184,6 @@ struct IndexedMeshTriangleStream final : public ITriangleStream {
     }
 };
 
-struct StlTriangleStream final : public ITriangleStream {
-private:
-    std::vector<f32> vertices;
-    usize index = 0;
-
-public:
-    StlTriangleStream(std::vector<f32> vertices) noexcept : vertices{std::move(vertices)} {}
-
-    bool next(VisualTriangle &triangle) noexcept final
-    {
-        if (not hasNext()) {
-            return false;
-        }
-
-        for (usize i = 0; i < 3; ++i) {
-            index += 3;
-            triangle.v[i] = Vec3f{vertices.data() + index}.cast<real_type>();
-            triangle.t[i] = {};
-        }
-
-        triangle.type = TriangleType::MATERIALLESS;
-        return true;
-    }
-
-private:
-    bool hasNext() const noexcept
-    {
-        return index < vertices.size();
-    }
-};
-
 struct ObjTriangleStream final : public ITriangleStream {
 public:
     using attrib_type = tinyobj::attrib_t;
@@ -199,11 +192,22 @@ public:
     using textures_type = std::map<std::string, Texture>;
 
 private:
+    /// A material with its texture already looked up, so that no string lookups are necessary per face.
+    struct ResolvedMaterial {
+        /// The type of faces which have UV coordinates.
+        TriangleType texturedType;
+        /// The type of faces which have no UV coordinates.
+        TriangleType untexturedType;
+        const Texture *texture;
+        Vec3f color;
+    };
+
     attrib_type attrib;
     shapes_type shapes;
     materials_type materials;
     textures_type textures;
-    const Texture *defaultTexture;
+    /// Resolved materials, indexed by material id + 1 so that faces without material (id -1) map to the first entry.
+    std::vector<ResolvedMaterial> materialTable;
 
     usize shapesIndex = 0;
     usize faceIndex = 0;
@@ -221,14 +225,26 @@ public:
         , shapes{std::move(shapes)}
         , materials{std::move(materials)}
         , textures{std::move(textures)}
-        , defaultTexture{defaultTexture}
         , faceCountOfCurrentShape{faceCountOfShapeOrZero(0)}
     {
+        resolveMaterials(defaultTexture);
     }
 
     bool next(VisualTriangle &out) noexcept final;
 
+    std::vector<u32> materialColors() const noexcept final
+    {
+        std::vector<u32> result;
+        result.reserve(materialTable.size());
+        for (const ResolvedMaterial &material : materialTable) {
+            result.push_back(Color32{material.color}.argb());
+        }
+        return result;
+    }
+
 private:
+    void resolveMaterials(const Texture *defaultTexture) noexcept;
+
     bool hasNext() const noexcept
     {
         return shapesIndex < shapes.size() && faceIndex < faceCountOfCurrentShape;
@@ -241,68 +257,67 @@ private:
     }
 };
 
+void ObjTriangleStream::resolveMaterials(const Texture *defaultTexture) noexcept
+{
+    materialTable.reserve(materials.size() + 1);
+
+    // faces without material use the default texture if they have UV coordinates
+    const TriangleType defaultType = defaultTexture != nullptr ? TriangleType::TEXTURED : TriangleType::MATERIALLESS;
+    materialTable.push_back({defaultType, TriangleType::MATERIALLESS, defaultTexture, Vec3f::one()});
+
+    for (const tinyobj::material_t &material : materials) {
+        const Vec3f color = Vec3{material.diffuse}.cast<float>();
+        const std::string &textureName = material.diffuse_texname;
+        const auto location = textureName.empty() ? textures.end() : textures.find(textureName);
+        if (location == textures.end()) {
+            // materials whose texture failed to load fall back to their diffuse color
+            materialTable.push_back({TriangleType::UNTEXTURED, TriangleType::UNTEXTURED, nullptr, color});
+        }
+        else {
+            materialTable.push_back({TriangleType::TEXTURED, TriangleType::UNTEXTURED, &location->second, color});
+        }
+    }
+}
+
 bool ObjTriangleStream::next(VisualTriangle &triangle) noexcept
 {
     if (not hasNext()) {
         return false;
     }
 
-    tinyobj::shape_t &shape = shapes[shapesIndex];
+    const tinyobj::shape_t &shape = shapes[shapesIndex];
+    VXIO_DEBUG_ASSERT_EQ(shape.mesh.num_face_vertices[faceIndex], 3u);
 
-    usize vertexCount = shape.mesh.num_face_vertices[faceIndex];
-    VXIO_DEBUG_ASSERT_EQ(vertexCount, 3u);
+    const tinyobj::index_t *indices = shape.mesh.indices.data() + indexOffset;
+    const tinyobj::real_t *vertices = attrib.vertices.data();
+    const tinyobj::real_t *texcoords = attrib.texcoords.data();
 
     bool hasTexCoords = true;
+    for (usize v = 0; v < 3; v++) {
+        const tinyobj::index_t idx = indices[v];
+        VXIO_DEBUG_ASSERT_GE(idx.vertex_index, 0);
+        triangle.v[v] = Vec3{vertices + 3 * idx.vertex_index};
 
-    // Loop over vertices in the face.
-    for (usize v = 0; v < vertexCount; v++) {
-        // access to vertex
-        tinyobj::index_t idx = shape.mesh.indices[indexOffset + v];
-        VXIO_ASSERTM(idx.vertex_index >= 0, "Vertex without vertex coordinates found");
-        Vec3 &vertex = triangle.v[v];
-        vertex = Vec3{attrib.vertices.data() + 3 * idx.vertex_index};
-
-        if (idx.texcoord_index >= 0) {
-            triangle.t[v] = Vec2f{attrib.texcoords.data() + 2 * idx.texcoord_index};
-        }
-        else {
-            // Even if this value will never be used by untexture materials, we initialize it.
-            // This could lead to accidental denormalized float operations which are expensive.
-            triangle.t[v] = {};
-            hasTexCoords = false;
-        }
+        // Even if UVs will never be used by untextured materials, we initialize them.
+        // This could lead to accidental denormalized float operations which are expensive.
+        hasTexCoords &= idx.texcoord_index >= 0;
+        triangle.t[v] = idx.texcoord_index >= 0 ? Vec2f{texcoords + 2 * idx.texcoord_index} : Vec2f{};
     }
 
-    const int materialIndex = shape.mesh.material_ids[faceIndex];
-    const tinyobj::material_t *material = materialIndex < 0 ? nullptr : &materials[static_cast<usize>(materialIndex)];
+    const auto materialIndex = static_cast<usize>(shape.mesh.material_ids[faceIndex] + 1);
+    VXIO_DEBUG_ASSERT_LT(materialIndex, materialTable.size());
+    const ResolvedMaterial &material = materialTable[materialIndex];
 
-    if (material == nullptr) {
-        if (hasTexCoords && defaultTexture != nullptr) {
-            triangle.type = TriangleType::TEXTURED;
-            triangle.texture = defaultTexture;
-        }
-        else {
-            triangle.type = TriangleType::MATERIALLESS;
-        }
-    }
-    else if (hasTexCoords) {
-        const std::string &textureName = material->diffuse_texname;
-        if (textureName.empty()) {
-            goto untextured;
-        }
-        auto location = textures.find(textureName);
-        VXIO_ASSERTM(location != textures.end(),
-                     "Face with material \"" + material->name + "\" has unloaded texture name \"" + textureName + '"');
-        triangle.texture = &location->second;
-        triangle.type = TriangleType::TEXTURED;
+    triangle.type = hasTexCoords ? material.texturedType : material.untexturedType;
+    triangle.material = static_cast<u32>(materialIndex);
+    if (triangle.type == TriangleType::TEXTURED) {
+        triangle.texture = material.texture;
     }
     else {
-    untextured:
-        triangle.color = Vec3{material->diffuse}.cast<float>();
-        triangle.type = TriangleType::UNTEXTURED;
+        triangle.color = material.color;
     }
 
-    indexOffset += vertexCount;
+    indexOffset += 3;
     if (++faceIndex >= faceCountOfCurrentShape) {
         faceIndex = 0;
         indexOffset = 0;
@@ -346,6 +361,11 @@ std::unique_ptr<ITriangleStream> ITriangleStream::fromCallback(obj2voxel_triangl
     return std::unique_ptr<ITriangleStream>{new CallbackTriangleStream{callback, callbackData}};
 }
 
+std::unique_ptr<ITriangleStream> ITriangleStream::fromBuffers(std::vector<std::vector<VisualTriangle>> buffers) noexcept
+{
+    return std::unique_ptr<ITriangleStream>{new BufferTriangleStream{std::move(buffers)}};
+}
+
 // FILE LOADING ========================================================================================================
 
 std::unique_ptr<ITriangleStream> ITriangleStream::fromObjFile(const std::string &inFile,
@@ -359,7 +379,17 @@ std::unique_ptr<ITriangleStream> ITriangleStream::fromObjFile(const std::string
     ObjTriangleStream::materials_type materials;
     ObjTriangleStream::textures_type textures;
 
-    bool tinyobjSuccess = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, inFile.c_str());
+    bool tinyobjSuccess;
+    if (isStdioPath(inFile)) {
+        // material libraries are looked up in the working directory, since standard input has no directory
+        StdinBuffer buffer;
+        std::istream in{&buffer};
+        tinyobj::MaterialFileReader materialReader{""};
+        tinyobjSuccess = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, &in, &materialReader);
+    }
+    else {
+        tinyobjSuccess = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, inFile.c_str());
+    }
     trim(warn);
     trim(err);
 
@@ -376,6 +406,16 @@ std::unique_ptr<ITriangleStream> ITriangleStream::fromObjFile(const std::string
         return nullptr;
     }
 
+    // validating indices once here keeps the per-face loop free of checks
+    for (const tinyobj::shape_t &shape : shapes) {
+        for (const tinyobj::index_t &index : shape.mesh.indices) {
+            if (index.vertex_index < 0) {
+                VXIO_LOG(ERROR, "Vertex without vertex coordinates found in shape \"" + shape.name + '"');
+                return nullptr;
+            }
+        }
+    }
+
     for (tinyobj::material_t &material : materials) {
         std::string name = material.diffuse_texname;
         if (name.empty()) {
@@ -392,46 +432,16 @@ std::unique_ptr<ITriangleStream> ITriangleStream::fromObjFile(const std::string
         std::move(attrib), std::move(shapes), std::move(materials), std::move(textures), defaultTexture});
 }
 
-std::unique_ptr<ITriangleStream> ITriangleStream::fromStlFile(const std::string &inFile) noexcept
+std::string resolveReferencedPath(const std::string &referencingFile, std::string_view path)
 {
-    std::optional<FileInputStream> stream = FileInputStream::open(inFile);
-    if (not stream.has_value()) {
-        VXIO_LOG(ERROR, "Failed to open STL file: \"" + inFile + "\"");
-        return nullptr;
-    }
-
-    char header[80];
-    usize headerSize = stream->read(reinterpret_cast<u8 *>(header), sizeof(header));
-    if (headerSize != 80) {
-        VXIO_LOG(ERROR, "Binary STL file must start with a header of 80 characters");
-        return nullptr;
-    }
-    if (std::string{header, 5} == "solid") {
-        VXIO_LOG(ERROR, "The given file is an ASCII STL file which is not supported");
-        return nullptr;
-    }
-
-    u32 triangleCount = stream->readLittle<u32>();
-    if (not stream->good()) {
-        VXIO_LOG(ERROR, "Couldn't read STL triangle count");
-        return nullptr;
-    }
-
-    std::vector<float> vertices;
-    for (u32 i = 0; i < triangleCount; ++i) {
-        f32 triangleData[12];
-
-        stream->readLittle<12, f32>(triangleData);
-        stream->readLittle<u16>();
-        if (not stream->good()) {
-            VXIO_LOG(ERROR, "Unexpected EOF or error when reading triangle");
-            return nullptr;
-        }
-
-        vertices.insert(vertices.end(), triangleData + 3, triangleData + 12);
-    }
-
-    return std::unique_ptr<StlTriangleStream>(new StlTriangleStream{std::move(vertices)});
+    // drive letters and URI schemes contain a colon, which relative paths practically never do
+    const bool isAbsolute = not path.empty() && (path.front() == '/' || path.find(':') != std::string_view::npos);
+    if (isAbsolute) {
+        return std::string{path};
+    }
+    const usize separator = referencingFile.find_last_of("/\\");
+    const usize directoryLength = separator == std::string::npos ? 0 : separator + 1;
+    return referencingFile.substr(0, directoryLength) + std::string{path};
 }
 
 std::optional<Texture> loadTexture(const std::string &name, const std::string &material)
@@ -504,6 +514,11 @@ struct CallbackVoxelSink final : public IVoxelSink {
         return voxelCount;
     }
 
+    void useMaterials(std::vector<u32>) noexcept final
+    {
+        // material indices are passed to the callback as they are
+    }
+
     void write(Voxel32 voxels[], usize size) noexcept final;
 
     void finalize() noexcept final
@@ -528,10 +543,13 @@ private:
     std::unique_ptr<OutputStream> stream;
     std::unique_ptr<AbstractListWriter> writer;
     std::vector<Voxel32> buffer;
+    /// Palette indices or ARGB colors of each material index, depending on whether the format uses a palette.
+    std::vector<u32> materialValues;
 
     usize voxelCount = 0;
     ResultCode err = ResultCode::OK;
     const bool usePalette;
+    bool useMaterialValues = false;
     bool finalized = false;
 
 public:
@@ -562,9 +580,14 @@ public:
         return voxelCount;
     }
 
+    void useMaterials(std::vector<u32> materialColors) noexcept final;
+
     void write(Voxel32 voxels[], usize size) noexcept final;
 
     void finalize() noexcept final;
+
+private:
+    u32 valueOfMaterial(u32 material) noexcept;
 };
 
 VoxelioVoxelSink::VoxelioVoxelSink(std::unique_ptr<OutputStream> out, FileType outFormat, usize resolution)
@@ -579,6 +602,31 @@ VoxelioVoxelSink::VoxelioVoxelSink(std::unique_ptr<OutputStream> out, FileType o
     buffer.reserve(BUFFER_SIZE);
 }
 
+void VoxelioVoxelSink::useMaterials(std::vector<u32> materialColors) noexcept
+{
+    VXIO_ASSERTM(voxelCount == 0, "Materials must be set before writing voxels");
+    useMaterialValues = true;
+    materialValues = std::move(materialColors);
+
+    // the palette is built once from the material colors, so no voxel ever needs to be looked up in it
+    if (usePalette) {
+        Palette32 &palette = writer->palette();
+        for (u32 &value : materialValues) {
+            value = palette.insert(value);
+        }
+    }
+}
+
+u32 VoxelioVoxelSink::valueOfMaterial(u32 material) noexcept
+{
+    if (material >= materialValues.size()) {
+        // materials without known colors are white
+        constexpr u32 white = 0xffffffff;
+        materialValues.resize(material + 1, usePalette ? writer->palette().insert(white) : white);
+    }
+    return materialValues[material];
+}
+
 void VoxelioVoxelSink::write(Voxel32 voxels[], usize size) noexcept
 {
     VXIO_ASSERTM(not finalized, "Writing to finalized voxel sink");
@@ -586,11 +634,19 @@ void VoxelioVoxelSink::write(Voxel32 voxels[], usize size) noexcept
 
     voxelCount += size;
 
-    if (usePalette) {
-        Palette32 &palette = writer->palette();
+    if (useMaterialValues) {
         for (usize i = 0; i < size; ++i) {
-            Voxel32 &voxel = voxels[i];
-            voxel.index = palette.insert(voxel.argb);
+            voxels[i].index = valueOfMaterial(voxels[i].index);
+        }
+    }
+
+    if (usePalette) {
+        if (not useMaterialValues) {
+            Palette32 &palette = writer->palette();
+            for (usize i = 0; i < size; ++i) {
+                Voxel32 &voxel = voxels[i];
+                voxel.index = palette.insert(voxel.argb);
+            }
         }
         this->buffer.insert(buffer.end(), voxels, voxels + size);
     }
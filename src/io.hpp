@@ -9,6 +9,7 @@
 #include "voxelio/voxelio.hpp"
 
 #include <optional>
+#include <string_view>
 #include <vector>
 
 namespace obj2voxel {
@@ -38,9 +39,12 @@ struct ITriangleStream {
     static std::unique_ptr<ITriangleStream> fromCallback(obj2voxel_triangle_callback callback,
                                                          void *callbackData) noexcept;
 
+    /// Streams the triangles of several buffers, one buffer after another.
+    static std::unique_ptr<ITriangleStream> fromBuffers(std::vector<std::vector<VisualTriangle>> buffers) noexcept;
+
     /**
      * @brief Loads an OBJ file from disk.
-     * @param inFile the input file
+     * @param inFile the input file or "-" for standard input
      * @param textureFile the default texture file, to be used for vertices with no material but UV coordinates
      * @return the OBJ triangle stream or nullptr if the file couldn't be opened
      */
@@ -48,18 +52,51 @@ struct ITriangleStream {
                                                         const Texture *defaultTexture) noexcept;
 
     /**
-     * @brief Loads an STL file from disk.
+     * @brief Loads a binary or ASCII STL file from disk.
      * The result is a vector of triangle vertices.
      * Each nine coordinates in the vector are one triangle.
      * No normals are stored in the vector.
-     * @param inFile the input file path
+     * ASCII files are memory-mapped, split at facet boundaries and parsed by multiple threads.
+     * Standard input is parsed in blocks while triangles are streamed instead.
+     * @param inFile the input file path or "-" for standard input
      * @return the STL triangle stream or nullptr if the file couldn't be opened
      */
     static std::unique_ptr<ITriangleStream> fromStlFile(const std::string &inFile) noexcept;
 
+    /**
+     * @brief Maps a binary PLY file into memory and streams its faces without copying them.
+     * Faces with more than three vertices are triangulated as fans.
+     * Vertex colors and a texture given in a "comment TextureFile" line are supported.
+     * @param inFile the input file path
+     * @return the PLY triangle stream or nullptr if the file couldn't be opened or is not a binary PLY file
+     */
+    static std::unique_ptr<ITriangleStream> fromPlyFile(const std::string &inFile) noexcept;
+
+    /**
+     * @brief Maps a binary glTF (GLB) file into memory and streams the triangles of its default scene.
+     * Vertex data is read directly from the binary chunk; embedded textures are decoded concurrently.
+     * @param inFile the input file path
+     * @return the GLB triangle stream or nullptr if the file couldn't be opened or is malformed
+     */
+    static std::unique_ptr<ITriangleStream> fromGlbFile(const std::string &inFile) noexcept;
+
     /// Virtual destructor.
     virtual ~ITriangleStream() noexcept;
 
+    /// Returns the ARGB colors of all materials, indexed by the material index of triangles.
+    /// Streams without materials return an empty vector.
+    virtual std::vector<u32> materialColors() const noexcept
+    {
+        return {};
+    }
+
+    /// Returns true if the stream ended early because its input turned out to be malformed or truncated.
+    /// Streams which parse their entire input when they are opened fail to open instead.
+    virtual bool failed() const noexcept
+    {
+        return false;
+    }
+
     /// Assigns the next triangle.
     /// Returns true if another triangle could be obtained from the stream, else false.
     /// If false gets returned, this signals the end of the stream and no more triangles should be read.
@@ -84,6 +121,10 @@ struct IVoxelSink {
     /// Returns the total number of voxels written to the sink.
     virtual usize voxelsWritten() const noexcept = 0;
 
+    /// Makes the sink interpret the values of written voxels as material indices instead of ARGB colors.
+    /// The material colors are used by formats which can't store material indices directly.
+    virtual void useMaterials(std::vector<u32> materialColors) noexcept = 0;
+
     /// Writes a buffer of voxels to the sink.
     virtual void write(Voxel32 voxels[], usize size) noexcept = 0;
 
@@ -94,6 +135,10 @@ struct IVoxelSink {
 /// Loads a texture with the given file name.
 std::optional<Texture> loadTexture(const std::string &name, const std::string &material);
 
+/// Resolves a path which is referenced by a file, such as the texture of a mesh or a tile of a manifest.
+/// Relative paths are relative to the directory of the referencing file, absolute paths are returned unchanged.
+std::string resolveReferencedPath(const std::string &referencingFile, std::string_view path);
+
 }  // namespace obj2voxel
 
 #endif  // OBJ2VOXEL_IO_HPP
@@ -1,7 +1,9 @@
 #include "obj2voxel.h"
 
 #include "3rd_party/args.hpp"
+#include "asyncfile.hpp"
 #include "constants.hpp"
+#include "pipes.hpp"
 
 #include "voxelio/filetype.hpp"
 #include "voxelio/log.hpp"
@@ -10,7 +12,11 @@
 #include "voxelio/stringmanip.hpp"
 #include "voxelio/vec.hpp"
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <memory>
 #include <set>
@@ -58,6 +64,7 @@ constexpr bool isSupportedFormat<FilePurpose::INPUT>(FileType type)
 {
     switch (type) {
     case FileType::WAVEFRONT_OBJ:
+    case FileType::STANFORD_TRIANGLE:
     case FileType::STEREOLITHOGRAPHY: return true;
     default: return false;
     }
@@ -82,6 +89,12 @@ FileType getAndValidateFileType(const std::string &file, const std::string &form
     constexpr bool isInput = PURPOSE == FilePurpose::INPUT;
 
     std::optional<FileType> type;
+    if (format.empty() && isStdioPath(file)) {
+        VXIO_LOG(FAILURE,
+                 std::string(isInput ? "Standard input requires an input format (-i)"
+                                     : "Standard output requires an output format (-o)"));
+        std::exit(1);
+    }
     if (format.empty()) {
         type = detectFileType(file);
         if (not type.has_value()) {
@@ -112,6 +125,69 @@ FileType getAndValidateFileType(const std::string &file, const std::string &form
     return *type;
 }
 
+/// Binary glTF and tile manifests are not voxelio formats, so they are recognized here before any voxelio file type
+/// detection. Returns the extension of such a format or nullptr for any other input.
+const char *nonVoxelioInputExtension(const std::string &file, std::string format)
+{
+    if (format.empty()) {
+        const usize dot = file.find_last_of('.');
+        format = dot == std::string::npos ? "" : file.substr(dot + 1);
+    }
+    toLowerCase(format);
+    return format == "glb" ? "glb" : format == "tiles" ? "tiles" : nullptr;
+}
+
+/// Writes per-voxel normals as VL32, where the color of each voxel is replaced with its octahedral normal.
+struct NormalFileWriter {
+    std::unique_ptr<OutputStream> stream;
+
+    static bool write(void *data, uint32_t *voxelData, size_t voxelCount)
+    {
+        auto &self = *static_cast<NormalFileWriter *>(data);
+        for (usize i = 0; i < voxelCount * 4; ++i) {
+            self.stream->writeBig<u32>(voxelData[i]);
+        }
+        return not self.stream->err();
+    }
+};
+
+/// Writes a signed distance field as a raw NRRD volume of 32-bit floats or of 8-bit integers scaled to the band.
+struct SdfFileWriter {
+    std::unique_ptr<OutputStream> stream;
+    float band;
+    bool quantized;
+
+    void writeHeader(unsigned resolution)
+    {
+        const std::string size = stringify(resolution);
+        stream->writeString("NRRD0004\n");
+        stream->writeString(quantized ? "type: int8\n" : "type: float\n");
+        stream->writeString("dimension: 3\n");
+        stream->writeString("sizes: " + size + ' ' + size + ' ' + size + '\n');
+        if (not quantized) {
+            stream->writeString("endian: little\n");
+        }
+        stream->writeString("encoding: raw\n\n");
+    }
+
+    static bool writeSlice(void *data, uint32_t, const float *distances, size_t count)
+    {
+        auto &self = *static_cast<SdfFileWriter *>(data);
+        for (usize i = 0; i < count; ++i) {
+            if (self.quantized) {
+                const float scaled = std::round(distances[i] / self.band * 127);
+                self.stream->write(static_cast<u8>(static_cast<i8>(scaled)));
+            }
+            else {
+                u32 bits;
+                std::memcpy(&bits, distances + i, sizeof(bits));
+                self.stream->writeLittle<u32>(bits);
+            }
+        }
+        return not self.stream->err();
+    }
+};
+
 int mainImpl(std::string inFile,
              std::string outFile,
              std::string inFormat,
@@ -121,6 +197,18 @@ int mainImpl(std::string inFile,
              std::string textureFile,
              bool supersample,
              obj2voxel_enum_t colorStrategy,
+             bool thin,
+             bool materials,
+             float alphaCutoff,
+             std::string normalFile,
+             unsigned outputTiles,
+             bool directIo,
+             unsigned decimation,
+             float sdfBand,
+             bool sdfQuantized,
+             const std::vector<std::pair<obj2voxel_enum_t, unsigned>> &morphology,
+             uint64_t minIsland,
+             unsigned keepLargest,
              const int unitTransform[9])
 {
     VXIO_LOG(INFO,
@@ -132,8 +220,28 @@ int mainImpl(std::string inFile,
         return 1;
     }
 
-    const FileType inType = getAndValidateFileType<FilePurpose::INPUT>(inFile, inFormat);
-    const FileType outType = getAndValidateFileType<FilePurpose::OUTPUT>(outFile, outFormat);
+    const char *nonVoxelioExtension = nonVoxelioInputExtension(inFile, inFormat);
+    const char *inExtension = nonVoxelioExtension != nullptr
+                                  ? nonVoxelioExtension
+                                  : extensionOf(getAndValidateFileType<FilePurpose::INPUT>(inFile, inFormat));
+    const bool sdfOutput = sdfBand >= 0;
+    // the distance field replaces the voxel output, so there is no voxel file type to validate
+    const FileType outType = sdfOutput ? FileType{} : getAndValidateFileType<FilePurpose::OUTPUT>(outFile, outFormat);
+
+    std::optional<SdfFileWriter> sdfWriter;
+    if (sdfOutput) {
+        if (sdfQuantized && sdfBand == 0) {
+            VXIO_LOG(ERROR, "Quantized distance fields require a non-zero band");
+            return 1;
+        }
+        std::unique_ptr<OutputStream> stream = openAsyncFileOutput(outFile, directIo);
+        if (stream == nullptr) {
+            VXIO_LOG(ERROR, "Failed to open distance field output file \"" + outFile + '"');
+            return 1;
+        }
+        sdfWriter.emplace(SdfFileWriter{std::move(stream), sdfBand, sdfQuantized});
+        sdfWriter->writeHeader(resolution);
+    }
 
     if (resolution >= 1024 * 1024) {
         VXIO_LOG(WARNING, "Very high resolution (" + stringifyLargeInt(resolution) + "), intentional?")
@@ -144,6 +252,16 @@ int mainImpl(std::string inFile,
 
     OBJ2VOXEL_IF_DUMP_STL(globalTriangleDebugCallback = writeTriangleAsBinaryToDebugStl);
 
+    std::optional<NormalFileWriter> normalWriter;
+    if (not normalFile.empty()) {
+        std::unique_ptr<OutputStream> stream = openAsyncFileOutput(normalFile, directIo);
+        if (stream == nullptr) {
+            VXIO_LOG(ERROR, "Failed to open normal output file \"" + normalFile + '"');
+            return 1;
+        }
+        normalWriter.emplace(NormalFileWriter{std::move(stream)});
+    }
+
     obj2voxel_instance *instance = obj2voxel_alloc();
 
     std::vector<std::thread> workers;
@@ -162,8 +280,13 @@ int mainImpl(std::string inFile,
     }
 
     obj2voxel_set_parallel(instance, threads != 0);
-    obj2voxel_set_input_file(instance, inFile.c_str(), extensionOf(inType));
-    obj2voxel_set_output_file(instance, outFile.c_str(), extensionOf(outType));
+    obj2voxel_set_input_file(instance, inFile.c_str(), inExtension);
+    if (sdfWriter.has_value()) {
+        obj2voxel_set_sdf_output(instance, sdfBand, &SdfFileWriter::writeSlice, &*sdfWriter);
+    }
+    else {
+        obj2voxel_set_output_file(instance, outFile.c_str(), extensionOf(outType));
+    }
 
     obj2voxel_texture *texture = nullptr;
     if (not textureFile.empty()) {
@@ -183,6 +306,19 @@ int mainImpl(std::string inFile,
     obj2voxel_set_resolution(instance, resolution);
     obj2voxel_set_supersampling(instance, 1 + supersample);
     obj2voxel_set_color_strategy(instance, static_cast<obj2voxel_enum_t>(colorStrategy));
+    if (normalWriter.has_value()) {
+        obj2voxel_set_normal_output_callback(instance, &NormalFileWriter::write, &*normalWriter);
+    }
+    obj2voxel_set_alpha_cutoff(instance, alphaCutoff);
+    obj2voxel_set_voxel_attribute(instance, materials ? OBJ2VOXEL_ATTRIBUTE_MATERIAL : OBJ2VOXEL_ATTRIBUTE_COLOR);
+    obj2voxel_set_topology(instance, thin ? OBJ2VOXEL_THIN_TOPOLOGY : OBJ2VOXEL_CONSERVATIVE_TOPOLOGY);
+    obj2voxel_set_decimation(instance, decimation);
+    for (const auto &[operation, radius] : morphology) {
+        obj2voxel_add_morphology(instance, operation, radius);
+    }
+    obj2voxel_set_island_removal(instance, minIsland, keepLargest);
+    obj2voxel_set_output_tiles(instance, outputTiles);
+    obj2voxel_set_direct_io(instance, directIo);
 
     obj2voxel_error_t resultCode = obj2voxel_voxelize(instance);
 
@@ -216,6 +352,12 @@ void initLogging()
     setLogBackend(nullptr, ENABLE_ASYNC_LOGGING);
 }
 
+/// Log backend for when standard output carries voxel data.
+void logToStderr(const char *msg)
+{
+    std::fputs(msg, stderr);
+}
+
 // CLI ARGUMENT PARSING ================================================================================================
 
 }  // namespace
@@ -261,6 +403,36 @@ void initLogging()
     }
 }
 
+[[maybe_unused]] static std::vector<std::pair<obj2voxel_enum_t, unsigned>> parseMorphology(const std::string &str)
+{
+    using namespace voxelio;
+
+    const std::unordered_map<std::string, obj2voxel_enum_t> operationMap{{"dilate", OBJ2VOXEL_MORPHOLOGY_DILATE},
+                                                                         {"erode", OBJ2VOXEL_MORPHOLOGY_ERODE},
+                                                                         {"close", OBJ2VOXEL_MORPHOLOGY_CLOSE},
+                                                                         {"hollow", OBJ2VOXEL_MORPHOLOGY_HOLLOW}};
+
+    std::vector<std::pair<obj2voxel_enum_t, unsigned>> result;
+    for (usize begin = 0, end; begin < str.size(); begin = end + 1) {
+        end = std::min(str.find(',', begin), str.size());
+        const std::string step = str.substr(begin, end - begin);
+
+        const usize colon = step.find(':');
+        const auto operation = operationMap.find(step.substr(0, colon));
+        if (operation == operationMap.end()) {
+            VXIO_LOG(FAILURE, "Invalid morphological operation \"" + step.substr(0, colon) + "\"");
+            std::exit(1);
+        }
+        const std::string radius = colon == std::string::npos ? "" : step.substr(colon + 1);
+        if (radius.empty() || radius.find_first_not_of("0123456789") != std::string::npos) {
+            VXIO_LOG(FAILURE, "Invalid radius in morphological operation \"" + step + "\"");
+            std::exit(1);
+        }
+        result.emplace_back(operation->second, static_cast<unsigned>(std::stoul(radius)));
+    }
+    return result;
+}
+
 int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
 {
     using namespace obj2voxel;
@@ -282,6 +454,18 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
                     "",
                     DEFAULT_SUPERSAMPLE,
                     OBJ2VOXEL_MAX_STRATEGY,
+                    false,
+                    false,
+                    false,
+                    0,
+                    "",
+                    0,
+                    0,
+                    -1,
+                    false,
+                    {},
+                    0,
+                    0,
                     identityUnitTransform);
 #endif
 
@@ -299,7 +483,7 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
     auto fgroup = args::Group(parser, "File Options:");
     auto inFileArg = args::Positional<std::string>(fgroup, "INPUT_FILE", INPUT_DESCR);
     auto outFileArg = args::Positional<std::string>(fgroup, "OUTPUT_FILE", OUTPUT_DESCR);
-    auto inFormatArg = args::ValueFlag<std::string>(fgroup, "obj|stl", INPUT_FORMAT_DESCR, {'i'}, "");
+    auto inFormatArg = args::ValueFlag<std::string>(fgroup, "obj|stl|ply|glb|tiles", INPUT_FORMAT_DESCR, {'i'}, "");
     auto outFormatArg = args::ValueFlag<std::string>(fgroup, "ply|qef|vl32|vox|xyzrgb", OUTPUT_FORMAT_DESCR, {'o'}, "");
     auto textureArg = args::ValueFlag<std::string>(fgroup, "texture", TEXTURE_DESCR, {'t'}, "");
 
@@ -309,7 +493,21 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
         vgroup, "max|blend", STRATEGY_DESCR, {'s', "strat"}, strategyMap, DEFAULT_COLOR_STRATEGY);
     auto permutationArg = args::ValueFlag<std::string>(vgroup, "permutation", PERMUTATION_ARG, {'p', "perm"}, "xyz");
     auto ssArg = args::Flag(vgroup, "supersample", SS_DESCR, {'u', "super"});
+    auto thinArg = args::Flag(vgroup, "thin", THIN_DESCR, {"thin"});
+    auto materialsArg = args::Flag(vgroup, "materials", MATERIALS_DESCR, {"materials"});
+    auto alphaCutoffArg = args::ValueFlag<float>(vgroup, "cutoff", ALPHA_CUTOFF_DESCR, {"alpha-cutoff"}, 0);
+    auto normalsArg = args::ValueFlag<std::string>(fgroup, "normals", NORMALS_DESCR, {"normals"}, "");
+    auto outputTilesArg = args::ValueFlag<unsigned>(fgroup, "tiles", OUTPUT_TILES_DESCR, {"output-tiles"}, 0);
+    auto directIoArg = args::Flag(fgroup, "direct-io", DIRECT_IO_DESCR, {"direct-io"});
     auto threadsArg = args::ValueFlag<unsigned>(vgroup, "threads", THREADS_DESCR, {'j', "threads"}, threadCount);
+    auto decimateArg = args::ValueFlag<unsigned>(vgroup, "cells", DECIMATE_DESCR, {'d', "decimate"}, 0);
+    auto morphArg = args::ValueFlag<std::string>(vgroup, "op:radius,...", MORPH_DESCR, {"morph"}, "");
+    auto minIslandArg = args::ValueFlag<uint64_t>(vgroup, "voxels", MIN_ISLAND_DESCR, {"min-island"}, 0);
+    auto keepLargestArg = args::ValueFlag<unsigned>(vgroup, "count", KEEP_LARGEST_DESCR, {"keep-largest"}, 0);
+
+    auto sgroup = args::Group(parser, "Distance Field Options:");
+    auto sdfArg = args::ValueFlag<float>(sgroup, "band", SDF_DESCR, {"sdf"});
+    auto sdfQuantizedArg = args::Flag(sgroup, "sdf-quantized", SDF_QUANTIZED_DESCR, {"sdf-quantized"});
 
     bool complete = parser.ParseCLI(argc, argv);
     complete &= parser.Matched();
@@ -360,6 +558,10 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
         voxelio::setLogLevel(LogLevel::DEBUG);
     }
 
+    if (isStdioPath(outFileArg.Get()) || isStdioPath(normalsArg.Get())) {
+        setLogBackend(&logToStderr, ENABLE_ASYNC_LOGGING);
+    }
+
     int unitTransform[9];
     parsePermutation(permutationArg.Get(), unitTransform);
 
@@ -372,6 +574,18 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
              std::move(textureArg.Get()),
              ssArg.Get(),
              strategyArg.Get(),
+             thinArg.Get(),
+             materialsArg.Get(),
+             std::clamp(alphaCutoffArg.Get(), 0.f, 1.f),
+             std::move(normalsArg.Get()),
+             outputTilesArg.Get(),
+             directIoArg.Get(),
+             decimateArg.Get(),
+             sdfArg.Matched() ? std::max(sdfArg.Get(), 0.f) : -1.f,
+             sdfQuantizedArg.Get(),
+             parseMorphology(morphArg.Get()),
+             minIslandArg.Get(),
+             keepLargestArg.Get(),
              unitTransform);
 
     i64 nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now() - startTime).count();
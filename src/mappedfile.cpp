@@ -0,0 +1,136 @@
+#include "mappedfile.hpp"
+
+#include "voxelio/log.hpp"
+#include "voxelio/stream.hpp"
+
+#include <memory>
+
+#if defined(_WIN32)
+#define OBJ2VOXEL_MMAP_WINDOWS
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#define OBJ2VOXEL_MMAP_POSIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace obj2voxel {
+
+namespace {
+
+/// Fallback for platforms without memory mapping and for files which can't be mapped (e.g. pipes).
+/// Returns true if the file could be read; the caller takes ownership of the allocated array.
+bool readEntireFile(const std::string &path, u8 *&outData, usize &outSize) noexcept
+{
+    std::optional<FileInputStream> stream = FileInputStream::open(path, OpenMode::BINARY);
+    if (not stream.has_value()) {
+        return false;
+    }
+
+    constexpr usize chunkSize = 1024 * 1024;
+    usize capacity = chunkSize;
+    std::unique_ptr<u8[]> buffer{new u8[capacity]};
+    usize size = 0;
+
+    while (true) {
+        if (size == capacity) {
+            std::unique_ptr<u8[]> grown{new u8[capacity * 2]};
+            std::memcpy(grown.get(), buffer.get(), size);
+            buffer = std::move(grown);
+            capacity *= 2;
+        }
+        size += stream->read(buffer.get() + size, capacity - size);
+        if (stream->eof()) {
+            break;
+        }
+        if (stream->err()) {
+            return false;
+        }
+    }
+
+    outData = buffer.release();
+    outSize = size;
+    return true;
+}
+
+}  // namespace
+
+std::optional<MappedFile> MappedFile::open(const std::string &path) noexcept
+{
+#if defined(OBJ2VOXEL_MMAP_POSIX)
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return std::nullopt;
+    }
+    struct stat info;
+    if (::fstat(fd, &info) == 0 && S_ISREG(info.st_mode)) {
+        const auto size = static_cast<usize>(info.st_size);
+        if (size == 0) {
+            ::close(fd);
+            return MappedFile{nullptr, 0, false};
+        }
+        void *address = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (address != MAP_FAILED) {
+            // Mesh ingest walks the file front to back, so aggressive read-ahead is always beneficial.
+            ::madvise(address, size, MADV_SEQUENTIAL);
+            return MappedFile{static_cast<const u8 *>(address), size, true};
+        }
+        VXIO_LOG(DEBUG, "mmap() failed for \"" + path + "\", reading file into memory instead");
+    }
+    else {
+        ::close(fd);
+    }
+#elif defined(OBJ2VOXEL_MMAP_WINDOWS)
+    HANDLE file = ::CreateFileA(
+        path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return std::nullopt;
+    }
+    LARGE_INTEGER fileSize;
+    if (::GetFileSizeEx(file, &fileSize) && fileSize.QuadPart == 0) {
+        ::CloseHandle(file);
+        return MappedFile{nullptr, 0, false};
+    }
+    HANDLE mapping = ::CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    ::CloseHandle(file);
+    if (mapping != nullptr) {
+        void *address = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        ::CloseHandle(mapping);
+        if (address != nullptr) {
+            return MappedFile{static_cast<const u8 *>(address), static_cast<usize>(fileSize.QuadPart), true};
+        }
+    }
+    VXIO_LOG(DEBUG, "MapViewOfFile() failed for \"" + path + "\", reading file into memory instead");
+#endif
+
+    u8 *data = nullptr;
+    usize size = 0;
+    if (not readEntireFile(path, data, size)) {
+        return std::nullopt;
+    }
+    return MappedFile{data, size, false};
+}
+
+MappedFile::~MappedFile() noexcept
+{
+    if (data_ == nullptr) {
+        return;
+    }
+    if (not mapped) {
+        delete[] data_;
+        return;
+    }
+#if defined(OBJ2VOXEL_MMAP_POSIX)
+    ::munmap(const_cast<u8 *>(data_), size_);
+#elif defined(OBJ2VOXEL_MMAP_WINDOWS)
+    ::UnmapViewOfFile(data_);
+#endif
+}
+
+}  // namespace obj2voxel
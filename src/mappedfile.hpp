@@ -0,0 +1,114 @@
+#ifndef OBJ2VOXEL_MAPPEDFILE_HPP
+#define OBJ2VOXEL_MAPPEDFILE_HPP
+
+#include "voxelio/types.hpp"
+
+#include <cstring>
+#include <optional>
+#include <string>
+#include <type_traits>
+
+namespace obj2voxel {
+
+using namespace voxelio;
+
+/**
+ * @brief A read-only memory mapping of an entire file.
+ * Binary mesh formats can be read directly from the mapping without copying or parsing them into intermediate buffers.
+ *
+ * On platforms without memory mapping support, the file is read into memory instead.
+ */
+class MappedFile {
+private:
+    const u8 *data_ = nullptr;
+    usize size_ = 0;
+    bool mapped = false;
+
+    MappedFile(const u8 *data, usize size, bool mapped) noexcept : data_{data}, size_{size}, mapped{mapped} {}
+
+public:
+    /// Maps the file at the given path or returns std::nullopt if it can't be opened.
+    static std::optional<MappedFile> open(const std::string &path) noexcept;
+
+    MappedFile(const MappedFile &) = delete;
+
+    MappedFile(MappedFile &&other) noexcept : data_{other.data_}, size_{other.size_}, mapped{other.mapped}
+    {
+        other.data_ = nullptr;
+        other.size_ = 0;
+    }
+
+    ~MappedFile() noexcept;
+
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    /// Returns a pointer to the first byte of the file.
+    const u8 *data() const noexcept
+    {
+        return data_;
+    }
+
+    /// Returns the size of the file in bytes.
+    usize size() const noexcept
+    {
+        return size_;
+    }
+};
+
+// ENDIAN DECODING =====================================================================================================
+
+namespace detail {
+
+template <usize SIZE>
+struct UintOfSize;
+
+template <>
+struct UintOfSize<1> {
+    using type = u8;
+};
+
+template <>
+struct UintOfSize<2> {
+    using type = u16;
+};
+
+template <>
+struct UintOfSize<4> {
+    using type = u32;
+};
+
+template <>
+struct UintOfSize<8> {
+    using type = u64;
+};
+
+}  // namespace detail
+
+/// Decodes an arithmetic type stored in little-endian byte order at an arbitrarily aligned address.
+template <typename T, std::enable_if_t<std::is_arithmetic_v<T>, int> = 0>
+inline T decodeLittle(const u8 *bytes) noexcept
+{
+    using uint_type = typename detail::UintOfSize<sizeof(T)>::type;
+    uint_type bits = 0;
+    for (usize i = 0; i < sizeof(T); ++i) {
+        bits |= static_cast<uint_type>(static_cast<uint_type>(bytes[i]) << (i * 8));
+    }
+    T result;
+    std::memcpy(&result, &bits, sizeof(T));
+    return result;
+}
+
+/// Decodes an arithmetic type stored in big-endian byte order at an arbitrarily aligned address.
+template <typename T, std::enable_if_t<std::is_arithmetic_v<T>, int> = 0>
+inline T decodeBig(const u8 *bytes) noexcept
+{
+    u8 reversed[sizeof(T)];
+    for (usize i = 0; i < sizeof(T); ++i) {
+        reversed[i] = bytes[sizeof(T) - 1 - i];
+    }
+    return decodeLittle<T>(reversed);
+}
+
+}  // namespace obj2voxel
+
+#endif  // OBJ2VOXEL_MAPPEDFILE_HPP
@@ -0,0 +1,81 @@
+#include "notifier.hpp"
+
+#if defined(__linux__)
+#define OBJ2VOXEL_NOTIFIER_EVENTFD
+#include <sys/eventfd.h>
+#include <unistd.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#define OBJ2VOXEL_NOTIFIER_PIPE
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <cstdint>
+
+namespace obj2voxel {
+
+#if defined(OBJ2VOXEL_NOTIFIER_EVENTFD)
+
+Notifier::Notifier() noexcept
+{
+    readFd = writeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+}
+
+Notifier::~Notifier() noexcept
+{
+    if (readFd != -1) {
+        close(readFd);
+    }
+}
+
+void Notifier::notify() noexcept
+{
+    if (writeFd != -1) {
+        const std::uint64_t one = 1;
+        [[maybe_unused]] auto written = write(writeFd, &one, sizeof(one));
+    }
+}
+
+#elif defined(OBJ2VOXEL_NOTIFIER_PIPE)
+
+Notifier::Notifier() noexcept
+{
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return;
+    }
+    for (int fd : fds) {
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+    }
+    readFd = fds[0];
+    writeFd = fds[1];
+}
+
+Notifier::~Notifier() noexcept
+{
+    if (readFd != -1) {
+        close(readFd);
+        close(writeFd);
+    }
+}
+
+void Notifier::notify() noexcept
+{
+    if (writeFd != -1) {
+        const char one = 1;
+        [[maybe_unused]] auto written = write(writeFd, &one, sizeof(one));
+    }
+}
+
+#else
+
+Notifier::Notifier() noexcept = default;
+
+Notifier::~Notifier() noexcept = default;
+
+void Notifier::notify() noexcept {}
+
+#endif
+
+}  // namespace obj2voxel
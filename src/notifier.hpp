@@ -0,0 +1,37 @@
+#ifndef OBJ2VOXEL_NOTIFIER_HPP
+#define OBJ2VOXEL_NOTIFIER_HPP
+
+namespace obj2voxel {
+
+/**
+ * @brief A file descriptor which becomes readable once notify() has been called.
+ * This allows integrating the completion of asynchronous work into event loops such as epoll, kqueue or poll.
+ *
+ * On Linux, this is an eventfd, on other POSIX systems the read end of a pipe.
+ * On other platforms, no descriptor is available and fd() returns -1.
+ */
+class Notifier {
+private:
+    int readFd = -1;
+    int writeFd = -1;
+
+public:
+    Notifier() noexcept;
+    Notifier(const Notifier &) = delete;
+    ~Notifier() noexcept;
+
+    Notifier &operator=(const Notifier &) = delete;
+
+    /// Returns the readable file descriptor or -1 if none could be created.
+    int fd() const noexcept
+    {
+        return readFd;
+    }
+
+    /// Makes the descriptor readable. The notification is never consumed by the notifier itself.
+    void notify() noexcept;
+};
+
+}  // namespace obj2voxel
+
+#endif  // OBJ2VOXEL_NOTIFIER_HPP
@@ -1,16 +1,30 @@
 #include "obj2voxel.h"
 
+#include "asyncfile.hpp"
 #include "constants.hpp"
 #include "io.hpp"
+#include "notifier.hpp"
+#include "pagedvector.hpp"
+#include "pipes.hpp"
+#include "postprocess.hpp"
+#include "sdf.hpp"
 #include "threading.hpp"
+#include "tiledoutput.hpp"
+#include "tiles.hpp"
 #include "voxelization.hpp"
 
 #include "voxelio/format/png.hpp"
 #include "voxelio/stringify.hpp"
+#include "voxelio/stringmanip.hpp"
 
+#include <algorithm>
+#include <array>
 #include <atomic>
+#include <future>
+#include <map>
 #include <ostream>  // we only use this to stringify std::thread::id in a debug log message
 #include <thread>
+#include <unordered_map>
 
 namespace obj2voxel {
 namespace {
@@ -22,17 +36,22 @@ enum class CommandType {
     FIND_MESH_BOUNDS,
     /// Transforms a triangle and stores its voxel minimum and maximum coordinates.
     TRANSFORM_TRIANGLES,
-    /// Instructs a worker thread sort a triangle into chunks.
-    SORT_TRIANGLE_INTO_CHUNKS,
+    /// Sorts all triangles into the chunks of one Morton range of chunks.
+    BIN_CHUNK_RANGE,
     /// Instructs a worker thread to voxelize a chunk.
     VOXELIZE_CHUNK,
+    /// Runs the distance transform on a batch of distance grid lines along the current axis.
+    TRANSFORM_DISTANCE_LINES,
+    /// Runs the current morphological pass on one chunk of the post-processor.
+    POST_PROCESS_CHUNK,
     /// Instructs a worker to exit.
     EXIT
 };
 
 struct WorkerCommand {
     CommandType type;
-    u32 index;
+    /// The index of a batch, a range or a line, or the Morton index of a chunk, which needs 64 bits.
+    u64 index;
 };
 
 // COMMAND QUEUE =======================================================================================================
@@ -80,12 +99,19 @@ enum class IoType {
     /// A file in memory, backed by ByteArrayXXStream.
     MEMORY_FILE,
     /// A callback for reading all triangles or for writing all voxels.
-    CALLBACK
+    CALLBACK,
+    /// Triangles pushed by the user from any number of threads. Only used for input.
+    PUSHED
 };
 
+/// Mesh formats which can be read from a file.
+/// This is a separate enum because voxelio only knows a subset of these formats.
+enum class InputFormat { WAVEFRONT_OBJ, STEREOLITHOGRAPHY, STANFORD_TRIANGLE, GLTF_BINARY, TILE_MANIFEST };
+
+template <typename Format>
 struct TypedFile {
     const char *path;
-    voxelio::FileType type;
+    Format type;
 
     constexpr IoType ioType() const
     {
@@ -99,17 +125,17 @@ struct CallbackWithData {
     void *data;
 };
 
-template <typename Callback>
+template <typename Callback, typename Format>
 struct FileOrCallback {
     IoType type;
     union {
-        TypedFile file;
+        TypedFile<Format> file;
         CallbackWithData<Callback> callbackWithData;
     };
 
-    FileOrCallback() : type{IoType::MISSING}, file{nullptr, voxelio::FileType{0}} {}
+    FileOrCallback() : type{IoType::MISSING}, file{nullptr, Format{0}} {}
 
-    FileOrCallback(TypedFile file) : type{file.ioType()}, file{file} {}
+    FileOrCallback(TypedFile<Format> file) : type{file.ioType()}, file{file} {}
 
     FileOrCallback(CallbackWithData<Callback> callback) : type{IoType::CALLBACK}, callbackWithData{callback} {}
 
@@ -131,6 +157,91 @@ struct CachedTriangle : public VisualTriangle {
     }
 };
 
+/// The triangles pushed by a single thread, together with their bounds.
+struct PushBuffer {
+    std::vector<VisualTriangle> triangles;
+    Vec3 min = Vec3::filledWith(std::numeric_limits<real_type>::infinity());
+    Vec3 max = -min;
+};
+
+// TRIANGLE CULLING ====================================================================================================
+
+/// A triangle vertex together with its UV coordinates.
+struct Corner {
+    Vec3 v;
+    Vec2f t;
+
+    constexpr bool operator<(const Corner &other) const noexcept
+    {
+        for (usize i = 0; i < 3; ++i) {
+            if (v[i] != other.v[i]) {
+                return v[i] < other.v[i];
+            }
+        }
+        return t[0] != other.t[0] ? t[0] < other.t[0] : t[1] < other.t[1];
+    }
+
+    constexpr bool operator==(const Corner &other) const noexcept
+    {
+        return v == other.v && t == other.t;
+    }
+};
+
+/// Returns the corners of a triangle in sorted order, which is the same for any winding or starting vertex.
+std::array<Corner, 3> canonicalCornersOf(const VisualTriangle &triangle) noexcept
+{
+    std::array<Corner, 3> result{Corner{triangle.v[0], triangle.t[0]},
+                                 Corner{triangle.v[1], triangle.t[1]},
+                                 Corner{triangle.v[2], triangle.t[2]}};
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+/// Returns true if two triangles are identical faces with identical materials, regardless of winding.
+bool isSameFace(const VisualTriangle &lhs, const VisualTriangle &rhs) noexcept
+{
+    if (lhs.type != rhs.type || lhs.material != rhs.material) {
+        return false;
+    }
+    if (lhs.type == TriangleType::TEXTURED && lhs.texture != rhs.texture) {
+        return false;
+    }
+    if (lhs.type == TriangleType::UNTEXTURED && lhs.color != rhs.color) {
+        return false;
+    }
+    return canonicalCornersOf(lhs) == canonicalCornersOf(rhs);
+}
+
+/// Hashes a face independently of its winding.
+/// Zero is reserved for marking degenerate triangles, so it is never returned.
+u64 faceHashOf(const VisualTriangle &triangle) noexcept
+{
+    constexpr u64 fnvOffset = 0xcbf29ce484222325;
+    constexpr u64 fnvPrime = 0x100000001b3;
+
+    u64 hash = fnvOffset;
+    const auto hashBytes = [&hash](const void *data, usize size) {
+        const auto *bytes = static_cast<const u8 *>(data);
+        for (usize i = 0; i < size; ++i) {
+            hash = (hash ^ bytes[i]) * fnvPrime;
+        }
+    };
+
+    for (const Corner &corner : canonicalCornersOf(triangle)) {
+        hashBytes(corner.v.data(), sizeof(corner.v));
+        hashBytes(corner.t.data(), sizeof(corner.t));
+    }
+    hashBytes(&triangle.type, sizeof(triangle.type));
+    hashBytes(&triangle.material, sizeof(triangle.material));
+    if (triangle.type == TriangleType::TEXTURED) {
+        hashBytes(&triangle.texture, sizeof(triangle.texture));
+    }
+    else if (triangle.type == TriangleType::UNTEXTURED) {
+        hashBytes(triangle.color.data(), sizeof(triangle.color));
+    }
+    return hash == 0 ? 1 : hash;
+}
+
 }  // namespace
 }  // namespace obj2voxel
 
@@ -141,25 +252,61 @@ using namespace obj2voxel;
  */
 struct obj2voxel_instance {
     // configurable
-    FileOrCallback<obj2voxel_triangle_callback> input;
-    FileOrCallback<obj2voxel_voxel_callback> output;
+    FileOrCallback<obj2voxel_triangle_callback, InputFormat> input;
+    FileOrCallback<obj2voxel_voxel_callback, voxelio::FileType> output;
+    CallbackWithData<obj2voxel_sdf_callback> sdfOutput{nullptr, nullptr};
+    CallbackWithData<obj2voxel_voxel_callback> normalOutput{nullptr, nullptr};
+    float sdfBand = 0;
     Texture *defaultTexture = nullptr;
     Vec3f meshMin = Vec3f::filledWith(std::numeric_limits<float>::infinity());
     Vec3f meshMax = -meshMin;
     ColorStrategy colorStrategy = ColorStrategy::MAX;
+    Topology topology = Topology::CONSERVATIVE;
+    VoxelAttribute attribute = VoxelAttribute::COLOR;
+    float alphaCutoff = 0;
     uint32_t outputResolution = 0;
     uint32_t sampleResolution = 0;
     uint32_t supersampling = 1;
+    uint32_t decimation = 0;
+    uint32_t outputTiles = 0;
+    bool directIo = false;
     bool parallel = false;
     bool boundsKnown = false;
     int unitTransform[9]{1, 0, 0, 0, 1, 0, 0, 0, 1};
+    std::vector<MorphologyStep> morphology;
+    uint64_t minIslandVoxels = 0;
+    uint32_t maxIslands = 0;
 
     // initialized during voxelization
     std::unique_ptr<IVoxelSink> voxelSink = nullptr;
-    std::vector<CachedTriangle> triangles;
-    std::unordered_map<uint64_t, std::vector<uint32_t>> chunks;
-    uint32_t chunkCount = 0;
+    std::unique_ptr<IVoxelSink> normalSink = nullptr;
+    std::unique_ptr<TiledVoxelOutput> tiledOutput = nullptr;
+    /// Triangles are paged so that pages can be released as soon as every chunk referencing them is voxelized.
+    PagedVector<CachedTriangle, TRIANGLE_PAGE_SIZE> triangles;
+    /// The number of chunk references to the triangles of each page which have not been voxelized yet.
+    std::unique_ptr<std::atomic<u64>[]> trianglePageReferences;
+    /// The number of triangle pages which have not been released yet while chunks are binned and voxelized.
+    std::atomic<u64> liveTrianglePages = 0;
+    /// Per-triangle face hashes computed during transformation, zero for degenerate triangles.
+    std::vector<uint64_t> faceHashes;
+    /// Triangle indices of every non-empty chunk, with one map per Morton range so that ranges can be binned
+    /// concurrently.
+    std::vector<std::unordered_map<uint64_t, std::vector<uint32_t>>> chunkRanges;
+    /// Ascending indices of the triangles whose chunk bounds overlap each Morton range, so that binning a range only
+    /// visits its own candidates.
+    std::vector<std::vector<uint32_t>> rangeTriangles;
+    /// Triggered once a range has been binned, so that its chunks can be voxelized while other ranges are binned.
+    std::unique_ptr<async::Event[]> chunkRangesBinned;
+    uint64_t chunkCount = 0;
+    uint64_t chunksPerRange = 0;
+    uint64_t degenerateTriangles = 0;
+    uint64_t duplicateTriangles = 0;
     AffineTransform meshTransform;
+    std::unique_ptr<DistanceGrid> distanceGrid = nullptr;
+    /// The axis along which TRANSFORM_DISTANCE_LINES commands operate.
+    usize distanceAxis = 0;
+    /// Holds voxelized chunks until all morphological steps are applied, if there are any.
+    std::unique_ptr<ChunkPostProcessor> postProcessor = nullptr;
 
     // threading
     CommandQueue queue;
@@ -170,6 +317,28 @@ struct obj2voxel_instance {
     bool workersStopped = false;
     bool sinkWritable = true;
     bool done = false;
+
+    // asynchronous voxelization
+    CallbackWithData<obj2voxel_completion_callback> completionCallback{nullptr, nullptr};
+    std::thread asyncThread;
+    async::Event asyncCompletion;
+    /// Guards the result and the lazily created notifier.
+    std::mutex asyncMutex;
+    std::unique_ptr<Notifier> completionNotifier = nullptr;
+    obj2voxel_error_t asyncResult = OBJ2VOXEL_ERR_OK;
+
+    // pushed input
+    /// Guards the map of buffers, but not the buffers themselves, which are only accessed by their thread.
+    std::mutex pushMutex;
+    std::unordered_map<std::thread::id, PushBuffer> pushBuffers;
+    bool inputFinished = false;
+
+    ~obj2voxel_instance() noexcept
+    {
+        if (asyncThread.joinable()) {
+            asyncThread.join();
+        }
+    }
 };
 
 // ALGORITHM ===========================================================================================================
@@ -199,47 +368,229 @@ void findMeshBounds(obj2voxel_instance &instance, u32 batchStartIndex)
     }
 }
 
+/// Transforms a triangle into voxel space and computes its chunk bounds.
+/// Returns the face hash of the transformed triangle or zero if it is degenerate.
+u64 transformTriangle(const obj2voxel_instance &instance, CachedTriangle &triangle)
+{
+    triangle.transform(instance.meshTransform);
+
+    if (instance.decimation != 0) {
+        // snapping to cell centers never moves a vertex into another voxel, so bounds remain valid
+        const auto cellsPerVoxel = static_cast<real_type>(instance.decimation);
+        for (Vec3 &vertex : triangle.v) {
+            vertex = (floor(vertex * cellsPerVoxel) + Vec3::filledWith(real_type{0.5})) / cellsPerVoxel;
+        }
+    }
+
+    const Vec3u32 voxelMin = triangle.voxelMin();
+    const Vec3u32 voxelMax = triangle.voxelMax();
+
+    // TODO does this min really work when a triangle is exactly on a chunk boundary?
+    // TODO investigate a model with a plane that halves it, see if plane is voxelized if it lies between chunks
+
+    // voxelMax() returns an exclusive bound which we need to make inclusive again
+    triangle.chunkMin = voxelMin / CHUNK_SIZE;
+    triangle.chunkMax = (voxelMax - Vec3u32::one()) / CHUNK_SIZE;
+
+    VXIO_IF_DEBUG(Vec3u32 chunkMaxInVoxelSpace = triangle.chunkMax * CHUNK_SIZE + Vec3u32::filledWith(CHUNK_SIZE));
+    VXIO_DEBUG_ASSERTM(obj2voxel::min(voxelMax, chunkMaxInVoxelSpace) == voxelMax, "Potentially lost voxels");
+
+    // hashing happens here so that the serial culling pass only needs to compare hashes
+    const bool degenerate = triangle.area() < DEGENERATE_TRIANGLE_AREA;
+    return degenerate ? 0 : faceHashOf(triangle);
+}
+
 void applyMeshTransform(obj2voxel_instance &instance, u32 batchStartIndex)
 {
     VXIO_DEBUG_ASSERT_LT(batchStartIndex, instance.triangles.size());
 
     const usize end = std::min(instance.triangles.size(), batchStartIndex + usize{BATCH_SIZE});
     for (usize i = batchStartIndex; i < end; ++i) {
-        CachedTriangle &triangle = instance.triangles[i];
-        triangle.transform(instance.meshTransform);
+        instance.faceHashes[i] = transformTriangle(instance, instance.triangles[i]);
+    }
+}
 
-        const Vec3u32 voxelMin = triangle.voxelMin();
-        const Vec3u32 voxelMax = triangle.voxelMax();
+/**
+ * @brief Removes degenerate and duplicate triangles using the face hashes computed during transformation.
+ * @param instance the instance
+ * @param counted whether each culled triangle is added to the culled triangle counts or nullptr to count all of them
+ */
+void cullTriangles(obj2voxel_instance &instance, const std::vector<bool> *counted = nullptr)
+{
+    VXIO_DEBUG_ASSERT_EQ(instance.faceHashes.size(), instance.triangles.size());
+    VXIO_DEBUG_ASSERT(counted == nullptr || counted->size() == instance.triangles.size());
+
+    std::unordered_map<u64, usize> firstFaceOfHash;
+    firstFaceOfHash.reserve(instance.triangles.size());
+
+    usize degenerateCount = 0;
+    usize duplicateCount = 0;
+    usize keptCount = 0;
+
+    for (usize i = 0; i < instance.triangles.size(); ++i) {
+        const u64 hash = instance.faceHashes[i];
+        const bool isCounted = counted == nullptr || (*counted)[i];
+        if (hash == 0) {
+            degenerateCount += isCounted;
+            continue;
+        }
+        // faces are compared against the kept copy; on a hash collision with a different face, both are kept
+        const auto [location, inserted] = firstFaceOfHash.emplace(hash, keptCount);
+        if (not inserted && isSameFace(instance.triangles[location->second], instance.triangles[i])) {
+            duplicateCount += isCounted;
+            continue;
+        }
+        instance.triangles[keptCount++] = instance.triangles[i];
+    }
+
+    instance.triangles.truncate(keptCount);
+    instance.faceHashes = {};
+    instance.degenerateTriangles += degenerateCount;
+    instance.duplicateTriangles += duplicateCount;
+
+    if (degenerateCount != 0 || duplicateCount != 0) {
+        VXIO_LOG(INFO,
+                 "Culled " + stringifyLargeInt(degenerateCount) + " degenerate and " +
+                     stringifyLargeInt(duplicateCount) + " duplicate triangles");
+    }
+}
 
-        // TODO does this min really work when a triangle is exactly on a chunk boundary?
-        // TODO investigate a model with a plane that halves it, see if plane is voxelized if it lies between chunks
+/**
+ * @brief Distributes the triangles among the candidate lists of the Morton ranges which their chunk bounds overlap.
+ * Each triangle is visited once, instead of once per range.
+ * @param instance the instance
+ * @param ranges the ascending indices of the ranges which will be binned
+ */
+void scatterTrianglesIntoRanges(obj2voxel_instance &instance, const std::vector<u32> &ranges)
+{
+    std::vector<bool> isBinned(instance.chunkRanges.size());
+    for (u32 range : ranges) {
+        isBinned[range] = true;
+        instance.rangeTriangles[range].clear();
+    }
 
-        // voxelMax() returns an exclusive bound which we need to make inclusive again
-        triangle.chunkMin = voxelMin / CHUNK_SIZE;
-        triangle.chunkMax = (voxelMax - Vec3u32::one()) / CHUNK_SIZE;
+    // ranges are aligned cubes, so the range of a chunk is the Morton index of its position divided by the range size
+    Vec3u32 rangeMax;
+    dileave3(instance.chunksPerRange - 1, rangeMax.data());
+    const u32 rangeSize = rangeMax.x() + 1;
 
-        VXIO_IF_DEBUG(Vec3u32 chunkMaxInVoxelSpace = triangle.chunkMax * CHUNK_SIZE + Vec3u32::filledWith(CHUNK_SIZE));
-        VXIO_DEBUG_ASSERTM(obj2voxel::min(voxelMax, chunkMaxInVoxelSpace) == voxelMax, "Potentially lost voxels");
+    for (u32 i = 0; i < instance.triangles.size(); ++i) {
+        const CachedTriangle &triangle = instance.triangles[i];
+        const Vec3u32 min = triangle.chunkMin / rangeSize;
+        const Vec3u32 max = triangle.chunkMax / rangeSize;
+        for (u32 z = min.z(); z <= max.z(); ++z) {
+            for (u32 y = min.y(); y <= max.y(); ++y) {
+                for (u32 x = min.x(); x <= max.x(); ++x) {
+                    const u64 range = ileave3(x, y, z);
+                    if (isBinned[range]) {
+                        instance.rangeTriangles[range].push_back(i);
+                    }
+                }
+            }
+        }
     }
 }
 
-void sortTriangleIntoChunks(obj2voxel_instance &instance, u32 triangleIndex)
+/**
+ * @brief Sorts the candidate triangles of one Morton range into its chunks.
+ * Ranges are aligned octree nodes of chunks, so each range is a cube and only writes to its own map.
+ * Candidates are visited in order, so every chunk lists its triangles in ascending order, regardless of the number of
+ * ranges.
+ * Triangles which span multiple chunks on more than one axis are only listed in the chunks they actually intersect,
+ * because large diagonal triangles would otherwise be listed in mostly empty chunks of their bounding box.
+ * @param instance the instance
+ * @param range the index of the range
+ */
+void binChunkRange(obj2voxel_instance &instance, u32 range)
 {
-    VXIO_DEBUG_ASSERT_LT(triangleIndex, instance.triangles.size());
+    VXIO_DEBUG_ASSERT_LT(range, instance.chunkRanges.size());
+
+    Vec3u32 rangeMin, rangeMax;
+    dileave3(range * instance.chunksPerRange, rangeMin.data());
+    dileave3((range + 1) * instance.chunksPerRange - 1, rangeMax.data());
+
+    // Chunks are tested with a margin of one output voxel, so that every triangle which is closer to the center of a
+    // surface voxel than the surface itself is still listed for distance seeding.
+    const auto margin = static_cast<f64>(instance.supersampling);
+
+    std::unordered_map<u64, std::vector<u32>> &chunks = instance.chunkRanges[range];
+    // references are counted locally and added once per page, so that ranges rarely contend for the same counter
+    u64 pageReferences = 0;
+    usize page = 0;
+    for (u32 i : instance.rangeTriangles[range]) {
+        if (i / TRIANGLE_PAGE_SIZE != page) {
+            if (pageReferences != 0) {
+                instance.trianglePageReferences[page] += pageReferences;
+                pageReferences = 0;
+            }
+            page = i / TRIANGLE_PAGE_SIZE;
+        }
 
-    const CachedTriangle &triangle = instance.triangles[triangleIndex];
-    const Vec3u32 min = triangle.chunkMin;
-    const Vec3u32 max = triangle.chunkMax;
+        const CachedTriangle &triangle = instance.triangles[i];
+        const Vec3u32 min = obj2voxel::max(triangle.chunkMin, rangeMin);
+        const Vec3u32 max = obj2voxel::min(triangle.chunkMax, rangeMax);
+        if (obj2voxel::min(min, max) != min) {
+            continue;
+        }
+
+        // a triangle whose bounding box spans multiple chunks on only one axis intersects all of them
+        const Vec3u32 span = triangle.chunkMax - triangle.chunkMin;
+        std::optional<TriangleCubeTest> test;
+        if ((span.x() != 0) + (span.y() != 0) + (span.z() != 0) > 1) {
+            test.emplace(triangle);
+        }
 
-    for (u32 z = min.z(); z <= max.z(); ++z) {
-        for (u32 y = min.y(); y <= max.y(); ++y) {
-            for (u32 x = min.x(); x <= max.x(); ++x) {
-                u64 morton = ileave3(x, y, z);
-                VXIO_DEBUG_ASSERT_LT(morton, instance.chunkCount);
-                instance.chunks[morton].push_back(triangleIndex);
+        for (u32 z = min.z(); z <= max.z(); ++z) {
+            for (u32 y = min.y(); y <= max.y(); ++y) {
+                for (u32 x = min.x(); x <= max.x(); ++x) {
+                    if (test.has_value()) {
+                        const Vec<f64, 3> cubeMin = (Vec3u32{x, y, z} * CHUNK_SIZE).cast<f64>() - margin;
+                        if (not test->intersects(cubeMin, CHUNK_SIZE + 2 * margin)) {
+                            continue;
+                        }
+                    }
+                    u64 morton = ileave3(x, y, z);
+                    VXIO_DEBUG_ASSERT_LT(morton, instance.chunkCount);
+                    chunks[morton].push_back(i);
+                    ++pageReferences;
+                }
             }
         }
     }
+    if (pageReferences != 0) {
+        instance.trianglePageReferences[page] += pageReferences;
+    }
+    instance.rangeTriangles[range] = {};
+}
+
+/// Removes references to the triangles of a page and frees the page once no chunk references it anymore.
+void releaseTrianglePage(obj2voxel_instance &instance, usize page, u64 references)
+{
+    if (instance.trianglePageReferences[page].fetch_sub(references) == references) {
+        instance.triangles.releasePage(page);
+        --instance.liveTrianglePages;
+    }
+}
+
+/// Frees the triangle list of a voxelized chunk and releases the references of its triangles.
+void releaseChunk(obj2voxel_instance &instance, std::vector<u32> &chunk)
+{
+    // chunks list their triangles in ascending order, so all references to one page are adjacent
+    for (usize begin = 0, end; begin < chunk.size(); begin = end) {
+        const usize page = chunk[begin] / TRIANGLE_PAGE_SIZE;
+        for (end = begin + 1; end < chunk.size() && chunk[end] / TRIANGLE_PAGE_SIZE == page; ++end) {
+        }
+        releaseTrianglePage(instance, page, end - begin);
+    }
+    chunk = {};
+}
+
+/// Returns the triangle indices of a chunk or nullptr if it has no triangles.
+std::vector<u32> *findChunk(obj2voxel_instance &instance, u64 chunkIndex)
+{
+    auto &chunks = instance.chunkRanges[chunkIndex / instance.chunksPerRange];
+    const auto location = chunks.find(chunkIndex);
+    return location == chunks.end() ? nullptr : &location->second;
 }
 
 void computeChunkBounds(u64 morton, Vec3u32 &outMin, Vec3u32 &outMax)
@@ -251,18 +602,47 @@ void computeChunkBounds(u64 morton, Vec3u32 &outMin, Vec3u32 &outMax)
     outMax = outMin + Vec3u32::filledWith(CHUNK_SIZE);
 }
 
-void voxelizeChunk(obj2voxel_instance &instance, Voxelizer &voxelizer, u32 chunkIndex)
+/// Seeds the distance grid with exact distances from the surface voxels of a chunk to the chunk's triangles.
+/// Only voxels within the chunk are touched, so chunks can be seeded concurrently.
+void seedDistances(obj2voxel_instance &instance, const std::vector<u32> &chunk, Vec3u32 chunkMin, Vec3u32 chunkMax)
+{
+    DistanceGrid &grid = *instance.distanceGrid;
+    const auto ss = static_cast<real_type>(instance.supersampling);
+    const Vec3u32 roundUp = Vec3u32::filledWith(instance.supersampling - 1);
+
+    for (u32 triangleIndex : chunk) {
+        const CachedTriangle &triangle = instance.triangles[triangleIndex];
+        const Vec3u32 min = obj2voxel::max(triangle.voxelMin() / instance.supersampling, chunkMin);
+        const Vec3u32 max = obj2voxel::min((triangle.voxelMax() + roundUp) / instance.supersampling, chunkMax);
+
+        for (u32 z = min.z(); z < max.z(); ++z) {
+            for (u32 y = min.y(); y < max.y(); ++y) {
+                for (u32 x = min.x(); x < max.x(); ++x) {
+                    const Vec3u32 pos{x, y, z};
+                    if (grid.isSurface(pos)) {
+                        const Vec3 center = (pos.cast<real_type>() + Vec3::filledWith(real_type{0.5})) * ss;
+                        grid.seed(pos, static_cast<float>(distanceToTriangle(center, triangle) / ss));
+                    }
+                }
+            }
+        }
+    }
+}
+
+void voxelizeChunk(obj2voxel_instance &instance, Voxelizer &voxelizer, u64 chunkIndex)
 {
-    VXIO_ASSERT(voxelizer.voxels().empty());
+    VXIO_ASSERT_EQ(voxelizer.voxelCount(), 0u);
+
+    std::vector<u32> &chunk = *findChunk(instance, chunkIndex);
 
     // it's okay that we don't use the mutex here, this is just an optional pre-emptive check
     if (not instance.sinkWritable) {
         VXIO_LOG(DEBUG, "Aborting chunk voxelization because sink is not writable");
+        // the triangles of this chunk must still be released, so that their pages can be freed
+        releaseChunk(instance, chunk);
         return;
     }
 
-    const std::vector<u32> &chunk = instance.chunks.at(chunkIndex);
-
     Vec3u32 chunkMin, chunkMax;
     computeChunkBounds(chunkIndex, chunkMin, chunkMax);
     VXIO_ASSERT(chunkMin != chunkMax);
@@ -270,37 +650,79 @@ void voxelizeChunk(obj2voxel_instance &instance, Voxelizer &voxelizer, u32 chunk
     for (u32 triangle : chunk) {
         voxelizer.voxelize(instance.triangles[triangle], chunkMin, chunkMax);
     }
+    voxelizer.resolveColors();
 
     if (instance.supersampling > 1) {
         VXIO_ASSERT_LT(instance.supersampling, 3u);
         voxelizer.downscale();
+        chunkMin /= instance.supersampling;
+        chunkMax /= instance.supersampling;
     }
 
-    const usize voxelCount = voxelizer.voxels().size();
+    const usize voxelCount = voxelizer.voxelCount();
     // TODO consider making this a member of worker thread instead
     const auto buffer = std::make_unique<Voxel32[]>(voxelCount);
 
     u32 i = 0;
-    for (auto [index, color] : voxelizer.voxels()) {
-        Vec3u32 pos32 = VoxelMap<WeightedColor>::posOf(index);
+    voxelizer.forEachVoxel([&](Vec3u32 pos32, u32 value) {
         if constexpr (build::DEBUG) {
-            VXIO_DEBUG_ASSERT_EQ(index / (CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE), chunkIndex);
             for (usize i = 0; i < 3; ++i) {
                 VXIO_DEBUG_ASSERT_GE(pos32[i], chunkMin[i]);
                 VXIO_DEBUG_ASSERT_LT(pos32[i], chunkMax[i]);
             }
         }
 
-        Color32 color32{color.value};
-        buffer[i++] = {pos32.cast<i32>(), {color32.argb()}};
-    }
+        if (instance.distanceGrid != nullptr) {
+            instance.distanceGrid->markSurface(pos32);
+        }
+
+        buffer[i++] = {pos32.cast<i32>(), {value}};
+    });
     VXIO_ASSERT_EQ(i, voxelCount);
-    {
+
+    if (instance.distanceGrid != nullptr) {
+        seedDistances(instance, chunk, chunkMin, chunkMax);
+    }
+    if (instance.postProcessor != nullptr) {
+        // the chunk and its normals are written once every morphological step has been applied,
+        // see applyPostProcessing()
+        std::unique_ptr<Voxel32[]> normals;
+        if (instance.normalSink != nullptr) {
+            normals = std::make_unique<Voxel32[]>(voxelCount);
+            i = 0;
+            voxelizer.forEachNormal([&](Vec3u32 pos32, u32 normal) {
+                normals[i++] = {pos32.cast<i32>(), {normal}};
+            });
+            VXIO_ASSERT_EQ(i, voxelCount);
+        }
+        instance.postProcessor->insert(chunkIndex, buffer.get(), normals.get(), voxelCount);
+    }
+    else if (instance.tiledOutput != nullptr) {
+        // tiles have their own sinks, so chunks of different tiles are written without holding the sink mutex
+        if (not instance.tiledOutput->completeChunk(chunkMin, buffer.get(), voxelCount)) {
+            std::lock_guard<std::mutex> lock{instance.sinkMutex};
+            instance.sinkWritable = false;
+        }
+    }
+    else {
         std::lock_guard<std::mutex> lock{instance.sinkMutex};
         if (instance.sinkWritable &= instance.voxelSink->canWrite()) {
             instance.voxelSink->write(buffer.get(), voxelCount);
         }
     }
+    if (instance.normalSink != nullptr && instance.postProcessor == nullptr) {
+        // normals exist for exactly the same voxels, so the buffer can be reused
+        i = 0;
+        voxelizer.forEachNormal([&](Vec3u32 pos32, u32 normal) {
+            buffer[i++] = {pos32.cast<i32>(), {normal}};
+        });
+        VXIO_ASSERT_EQ(i, voxelCount);
+
+        std::lock_guard<std::mutex> lock{instance.sinkMutex};
+        if (instance.sinkWritable &= instance.normalSink->canWrite()) {
+            instance.normalSink->write(buffer.get(), voxelCount);
+        }
+    }
     if (instance.sinkWritable) {
         VXIO_LOG(SPAM,
                  "Voxelized chunk " + stringifyOct(chunkIndex) + " t:" + stringifyDec(chunk.size()) + " -> " +
@@ -310,7 +732,49 @@ void voxelizeChunk(obj2voxel_instance &instance, Voxelizer &voxelizer, u32 chunk
         VXIO_LOG(ERROR, "Can't write voxels because sink has failed (IO error?)");
     }
 
-    voxelizer.voxels().clear();
+    voxelizer.clearVoxels();
+    releaseChunk(instance, chunk);
+}
+
+/// Completes a chunk of the tiled output with the given voxels.
+void completeTiledChunk(obj2voxel_instance &instance, u64 chunkIndex, const Voxel32 *voxels, usize voxelCount)
+{
+    Vec3u32 chunkMin, chunkMax;
+    computeChunkBounds(chunkIndex, chunkMin, chunkMax);
+    if (not instance.tiledOutput->completeChunk(chunkMin / instance.supersampling, voxels, voxelCount)) {
+        std::lock_guard<std::mutex> lock{instance.sinkMutex};
+        instance.sinkWritable = false;
+    }
+}
+
+/**
+ * @brief Completes all chunks of the tiled output inside of a box of chunks at once, except for the given chunks.
+ * Those are completed one by one when they are written, so that tiled output knows when all chunks of a tile are done.
+ * @param instance the instance
+ * @param chunkMin the inclusive minimum chunk position of the box
+ * @param chunkMax the inclusive maximum chunk position of the box
+ * @param completedChunks the Morton indices of the chunks which are completed one by one
+ */
+void completeEmptyTiledChunks(obj2voxel_instance &instance,
+                              Vec3u32 chunkMin,
+                              Vec3u32 chunkMax,
+                              const std::vector<u64> &completedChunks)
+{
+    const u32 outputChunkSize = CHUNK_SIZE / instance.supersampling;
+    std::vector<Vec3u32> completedChunkMins;
+    completedChunkMins.reserve(completedChunks.size());
+    for (u64 chunkIndex : completedChunks) {
+        Vec3u32 chunkPos;
+        dileave3(chunkIndex, chunkPos.data());
+        completedChunkMins.push_back(chunkPos * outputChunkSize);
+    }
+
+    const Vec3u32 boxMin = chunkMin * outputChunkSize;
+    const Vec3u32 boxMax = (chunkMax + Vec3u32::one()) * outputChunkSize;
+    if (not instance.tiledOutput->completeEmptyChunks(boxMin, boxMax, completedChunkMins)) {
+        std::lock_guard<std::mutex> lock{instance.sinkMutex};
+        instance.sinkWritable = false;
+    }
 }
 
 // MAIN THREAD UTILITY =================================================================================================
@@ -335,6 +799,57 @@ voxelio::FileType detectFileType(const char *file, const char *type)
     return *fileType;
 }
 
+std::string extensionOfPath(const std::string &path)
+{
+    const usize dot = path.find_last_of('.');
+    return dot == std::string::npos ? std::string{} : path.substr(dot + 1);
+}
+
+/// Returns the input format of a non-voxelio format with the given extension.
+/// voxelio doesn't know about glTF or tile manifests, so they must be recognized before deferring to its detection.
+std::optional<InputFormat> nonVoxelioInputFormatOf(std::string extension)
+{
+    voxelio::toLowerCase(extension);
+    if (extension == "glb") {
+        return InputFormat::GLTF_BINARY;
+    }
+    if (extension == "tiles") {
+        return InputFormat::TILE_MANIFEST;
+    }
+    return std::nullopt;
+}
+
+/// Returns the format of a tile based on its extension or std::nullopt if it is not a supported mesh format.
+std::optional<InputFormat> tileFormatOf(const std::string &path)
+{
+    const std::string extension = extensionOfPath(path);
+    if (std::optional<InputFormat> format = nonVoxelioInputFormatOf(extension); format.has_value()) {
+        return format == InputFormat::TILE_MANIFEST ? std::nullopt : format;
+    }
+    const std::optional<voxelio::FileType> type = voxelio::fileTypeOfExtension(extension);
+    if (type == voxelio::FileType::WAVEFRONT_OBJ) return InputFormat::WAVEFRONT_OBJ;
+    if (type == voxelio::FileType::STEREOLITHOGRAPHY) return InputFormat::STEREOLITHOGRAPHY;
+    if (type == voxelio::FileType::STANFORD_TRIANGLE) return InputFormat::STANFORD_TRIANGLE;
+    return std::nullopt;
+}
+
+InputFormat detectInputFormat(const char *file, const char *type)
+{
+    const std::optional<InputFormat> nonVoxelioFormat =
+        nonVoxelioInputFormatOf(type != nullptr ? type : file != nullptr ? extensionOfPath(file) : std::string{});
+    if (nonVoxelioFormat.has_value()) {
+        return *nonVoxelioFormat;
+    }
+
+    switch (detectFileType(file, type)) {
+    case voxelio::FileType::WAVEFRONT_OBJ: return InputFormat::WAVEFRONT_OBJ;
+    case voxelio::FileType::STEREOLITHOGRAPHY: return InputFormat::STEREOLITHOGRAPHY;
+    case voxelio::FileType::STANFORD_TRIANGLE: return InputFormat::STANFORD_TRIANGLE;
+    default: VXIO_ASSERTM(false, std::string{file != nullptr ? file : type} + " is not a supported input format");
+    }
+    VXIO_ASSERT_UNREACHABLE();
+}
+
 constexpr ColorFormat colorFormatOfChannelCount(size_t channels)
 {
     switch (channels) {
@@ -406,21 +921,36 @@ AffineTransform computeMeshTransform(obj2voxel_instance &instance)
 /// A specialized class that implements stages of the voxelization pipeline in either parallel or single-threaded way.
 template <bool PARALLEL>
 struct VoxelizationHelper {
-    void voxelizeChunk(u32 chunkIndex);
+    // every specialization also defines the number of Morton ranges per axis into which chunks are divided for binning
+    void binChunkRange(u32 range);
+    void waitForChunkRange(u32 range);
+    void voxelizeChunk(u64 chunkIndex);
     void findMeshBounds(u32 batchStartIndex);
     void transformTriangles(u32 batchStartIndex);
+    void transformDistanceLines(u32 firstLine);
+    void postProcessChunk(usize index);
     void waitForCompletion();
 };
 
 template <>
 struct VoxelizationHelper<true> {
+    static constexpr u32 chunkRangesPerAxis = CHUNK_RANGES_PER_AXIS;
+
     obj2voxel_instance &instance;
 
-    void voxelizeChunk(u32 chunkIndex)
+    void binChunkRange(u32 range)
     {
-        if (instance.chunks.find(chunkIndex) != instance.chunks.end()) {
-            instance.queue.issue({CommandType::VOXELIZE_CHUNK, chunkIndex});
-        }
+        instance.queue.issue({CommandType::BIN_CHUNK_RANGE, range});
+    }
+
+    void waitForChunkRange(u32 range)
+    {
+        instance.chunkRangesBinned[range].waitUntilTriggered();
+    }
+
+    void voxelizeChunk(u64 chunkIndex)
+    {
+        instance.queue.issue({CommandType::VOXELIZE_CHUNK, chunkIndex});
     }
 
     void findMeshBounds(u32 batchStartIndex)
@@ -433,6 +963,16 @@ struct VoxelizationHelper<true> {
         instance.queue.issue({CommandType::TRANSFORM_TRIANGLES, batchStartIndex});
     }
 
+    void transformDistanceLines(u32 firstLine)
+    {
+        instance.queue.issue({CommandType::TRANSFORM_DISTANCE_LINES, firstLine});
+    }
+
+    void postProcessChunk(usize index)
+    {
+        instance.queue.issue({CommandType::POST_PROCESS_CHUNK, index});
+    }
+
     void waitForCompletion()
     {
         instance.queue.waitForCompletion();
@@ -441,14 +981,26 @@ struct VoxelizationHelper<true> {
 
 template <>
 struct VoxelizationHelper<false> {
+    // binning in several ranges only pays off when they are binned concurrently
+    static constexpr u32 chunkRangesPerAxis = 1;
+
     obj2voxel_instance &instance;
-    Voxelizer voxelizer{instance.colorStrategy};
+    Voxelizer voxelizer{instance.colorStrategy,
+                        instance.topology,
+                        instance.attribute,
+                        instance.normalSink != nullptr,
+                        instance.alphaCutoff};
 
-    void voxelizeChunk(u32 chunkIndex)
+    void binChunkRange(u32 range)
     {
-        if (instance.chunks.find(chunkIndex) != instance.chunks.end()) {
-            obj2voxel::voxelizeChunk(instance, voxelizer, chunkIndex);
-        }
+        obj2voxel::binChunkRange(instance, range);
+    }
+
+    void waitForChunkRange(u32) {}
+
+    void voxelizeChunk(u64 chunkIndex)
+    {
+        obj2voxel::voxelizeChunk(instance, voxelizer, chunkIndex);
     }
 
     void findMeshBounds(u32 batchStartIndex)
@@ -461,9 +1013,276 @@ struct VoxelizationHelper<false> {
         obj2voxel::applyMeshTransform(instance, batchStartIndex);
     }
 
+    void transformDistanceLines(u32 firstLine)
+    {
+        instance.distanceGrid->transformLines(instance.distanceAxis, firstLine, SDF_LINE_BATCH_SIZE);
+    }
+
+    void postProcessChunk(usize index)
+    {
+        instance.postProcessor->processChunk(index);
+    }
+
     void waitForCompletion() {}
 };
 
+/// Divides the chunks into Morton ranges for binning, using as many ranges as the helper supports.
+template <bool PARALLEL>
+void initChunkRanges(obj2voxel_instance &instance)
+{
+    constexpr u32 maxRangeCount = VoxelizationHelper<PARALLEL>::chunkRangesPerAxis *
+                                  VoxelizationHelper<PARALLEL>::chunkRangesPerAxis *
+                                  VoxelizationHelper<PARALLEL>::chunkRangesPerAxis;
+    // both counts are powers of eight, so ranges are always whole octree nodes
+    const u64 rangeCount = std::min(instance.chunkCount, u64{maxRangeCount});
+    instance.chunksPerRange = instance.chunkCount / rangeCount;
+    instance.chunkRanges.clear();
+    instance.chunkRanges.resize(rangeCount);
+    instance.rangeTriangles.clear();
+    instance.rangeTriangles.resize(rangeCount);
+    instance.chunkRangesBinned = std::make_unique<async::Event[]>(rangeCount);
+}
+
+/**
+ * @brief Bins the triangles into chunks and voxelizes all chunks within the given bounds.
+ * Instead of waiting until all triangles are binned, the chunks of each Morton range are voxelized as soon as that
+ * range is binned, so binning of later ranges overlaps with voxelization and output of earlier ones.
+ * @param instance the instance
+ * @param helper the helper
+ * @param chunkMin the inclusive minimum chunk position
+ * @param chunkMax the inclusive maximum chunk position
+ */
+template <bool PARALLEL>
+void binAndVoxelizeChunks(obj2voxel_instance &instance,
+                          VoxelizationHelper<PARALLEL> &helper,
+                          Vec3u32 chunkMin,
+                          Vec3u32 chunkMax)
+{
+    const auto isInBounds = [chunkMin, chunkMax](u64 morton) -> bool {
+        Vec3u32 chunkPos;
+        dileave3(morton, chunkPos.data());
+        return obj2voxel::max(chunkPos, chunkMin) == chunkPos && obj2voxel::min(chunkPos, chunkMax) == chunkPos;
+    };
+
+    std::vector<u32> ranges;
+    for (u32 range = 0; range < instance.chunkRanges.size(); ++range) {
+        Vec3u32 rangeMin, rangeMax;
+        dileave3(range * instance.chunksPerRange, rangeMin.data());
+        dileave3((range + 1) * instance.chunksPerRange - 1, rangeMax.data());
+        if (obj2voxel::min(obj2voxel::max(rangeMin, chunkMin), obj2voxel::min(rangeMax, chunkMax)) ==
+            obj2voxel::max(rangeMin, chunkMin)) {
+            ranges.push_back(range);
+        }
+    }
+    VXIO_DEBUG_ASSERT(not ranges.empty());
+
+    // Every page holds one extra reference until all ranges are binned.
+    // Otherwise, a page could be released by the chunks of one range before another range has counted its references.
+    const usize pageCount = instance.triangles.pageCount();
+    instance.trianglePageReferences = std::make_unique<std::atomic<u64>[]>(pageCount);
+    for (usize page = 0; page < pageCount; ++page) {
+        instance.trianglePageReferences[page] = 1;
+    }
+    instance.liveTrianglePages = pageCount;
+
+    scatterTrianglesIntoRanges(instance, ranges);
+    for (u32 range : ranges) {
+        instance.chunkRanges[range].clear();
+        instance.chunkRangesBinned[range].reset();
+        helper.binChunkRange(range);
+    }
+    std::vector<u64> chunks;
+    for (u32 range : ranges) {
+        helper.waitForChunkRange(range);
+        if (range == ranges.back()) {
+            // All references are counted once the last range is binned, so pages can be freed during voxelization.
+            for (usize page = 0; page < pageCount; ++page) {
+                releaseTrianglePage(instance, page, 1);
+            }
+        }
+
+        // Only non-empty chunks are visited because huge grids have far more chunk indices than could be iterated.
+        // They are sorted so that chunks are still voxelized in Morton order.
+        chunks.clear();
+        for (const auto &[chunkIndex, triangles] : instance.chunkRanges[range]) {
+            if (isInBounds(chunkIndex)) {
+                chunks.push_back(chunkIndex);
+            }
+        }
+        std::sort(chunks.begin(), chunks.end());
+
+        // Tiled output must be told about the remaining empty chunks of the range as well, so that every tile can be
+        // completed. Post-processed chunks are completed afterwards, since morphology can grow into empty chunks.
+        if (instance.tiledOutput != nullptr && instance.postProcessor == nullptr) {
+            Vec3u32 rangeMin, rangeMax;
+            dileave3(range * instance.chunksPerRange, rangeMin.data());
+            dileave3((range + 1) * instance.chunksPerRange - 1, rangeMax.data());
+            completeEmptyTiledChunks(
+                instance, obj2voxel::max(rangeMin, chunkMin), obj2voxel::min(rangeMax, chunkMax), chunks);
+        }
+        for (u64 chunkIndex : chunks) {
+            helper.voxelizeChunk(chunkIndex);
+        }
+    }
+    helper.waitForCompletion();
+
+    for (u32 range : ranges) {
+        instance.chunkRanges[range].clear();
+    }
+}
+
+/// Writes the post-processed chunks in Morton order and frees them.
+void writePostProcessedChunks(obj2voxel_instance &instance)
+{
+    if (instance.tiledOutput != nullptr) {
+        // tiled output must be told about empty chunks as well, so that every tile can be completed
+        const u32 chunksPerAxis = divCeil(instance.sampleResolution, CHUNK_SIZE);
+        completeEmptyTiledChunks(instance,
+                                 Vec3u32::zero(),
+                                 Vec3u32::filledWith(chunksPerAxis - 1),
+                                 instance.postProcessor->sortedChunkIndices());
+    }
+    instance.postProcessor->forEachChunk([&](u64 chunkIndex, Voxel32 *voxels, Voxel32 *normals, usize voxelCount) {
+        if (instance.tiledOutput != nullptr) {
+            completeTiledChunk(instance, chunkIndex, voxels, voxelCount);
+        }
+        else if (instance.sinkWritable &= instance.voxelSink->canWrite()) {
+            instance.voxelSink->write(voxels, voxelCount);
+        }
+        if (instance.normalSink != nullptr && (instance.sinkWritable &= instance.normalSink->canWrite())) {
+            instance.normalSink->write(normals, voxelCount);
+        }
+    });
+    instance.postProcessor.reset();
+}
+
+/**
+ * @brief Applies all morphological steps and island removal to the voxelized chunks and writes them afterwards.
+ * Every step consists of passes over all chunks, which are processed in parallel.
+ * Each pass has to complete before the next one starts because chunks read the previous state of their neighbors.
+ */
+template <bool PARALLEL>
+void applyPostProcessing(obj2voxel_instance &instance, VoxelizationHelper<PARALLEL> &helper)
+{
+    if (instance.postProcessor == nullptr || not instance.sinkWritable) {
+        return;
+    }
+    ChunkPostProcessor &processor = *instance.postProcessor;
+
+    const auto runPasses = [&](ChunkPostProcessor::Pass pass, u32 count = 1) {
+        for (u32 i = 0; i < count; ++i) {
+            const usize chunkCount = processor.beginPass(pass);
+            for (usize chunk = 0; chunk < chunkCount; ++chunk) {
+                helper.postProcessChunk(chunk);
+            }
+            helper.waitForCompletion();
+            processor.endPass();
+        }
+    };
+
+    for (const MorphologyStep &step : instance.morphology) {
+        VXIO_LOG(DEBUG,
+                 "Applying " + std::string{nameOf(step.operation)} + " with radius " + stringify(step.radius) + " to " +
+                     stringifyLargeInt(processor.chunkCount()) + " chunks ...");
+        switch (step.operation) {
+        case Morphology::DILATE: runPasses(ChunkPostProcessor::Pass::DILATE, step.radius); break;
+        case Morphology::ERODE: runPasses(ChunkPostProcessor::Pass::ERODE, step.radius); break;
+        case Morphology::CLOSE:
+            // the grid boundary must not erode because the dilation couldn't grow beyond it
+            runPasses(ChunkPostProcessor::Pass::DILATE, step.radius);
+            runPasses(ChunkPostProcessor::Pass::ERODE_CLAMPED, step.radius);
+            break;
+        case Morphology::HOLLOW:
+            processor.snapshot();
+            runPasses(ChunkPostProcessor::Pass::ERODE, step.radius);
+            processor.subtractFromSnapshot();
+            break;
+        }
+    }
+
+    if (instance.minIslandVoxels > 1 || instance.maxIslands != 0) {
+        VXIO_LOG(DEBUG,
+                 "Labeling connected components of " + stringifyLargeInt(processor.chunkCount()) + " chunks ...");
+        runPasses(ChunkPostProcessor::Pass::LABEL_RUNS);
+        runPasses(ChunkPostProcessor::Pass::MERGE_RUNS);
+        runPasses(ChunkPostProcessor::Pass::MEASURE_COMPONENTS);
+
+        const ComponentSelection selection = processor.selectComponents(instance.minIslandVoxels, instance.maxIslands);
+        VXIO_LOG(INFO,
+                 "Removing " + stringifyLargeInt(selection.removedComponents) + " of " +
+                     stringifyLargeInt(selection.componentCount) + " connected components with " +
+                     stringifyLargeInt(selection.removedVoxels) + " voxels ...");
+        runPasses(ChunkPostProcessor::Pass::REMOVE_COMPONENTS);
+    }
+
+    writePostProcessedChunks(instance);
+}
+
+/// Computes the signed distance field from the seeded distance grid and writes it to the SDF callback.
+template <bool PARALLEL>
+[[nodiscard]] obj2voxel_error_t computeDistanceField(obj2voxel_instance &instance, VoxelizationHelper<PARALLEL> &helper)
+{
+    DistanceGrid &grid = *instance.distanceGrid;
+
+    VXIO_LOG(DEBUG, "Classifying inside and outside of mesh ...");
+    grid.classifyOutside();
+
+    VXIO_LOG(DEBUG, "Computing distance transform ...");
+    for (instance.distanceAxis = 0; instance.distanceAxis < 3; ++instance.distanceAxis) {
+        for (usize i = 0; i < grid.lineCount(); i += SDF_LINE_BATCH_SIZE) {
+            helper.transformDistanceLines(static_cast<u32>(i));
+        }
+        helper.waitForCompletion();
+    }
+    grid.finalize(instance.sdfBand);
+
+    const usize sliceSize = grid.lineCount();
+    for (u32 z = 0; z < grid.size(); ++z) {
+        if (not instance.sdfOutput.callback(instance.sdfOutput.data, z, grid.slice(z), sliceSize)) {
+            VXIO_LOG(ERROR, "Can't write distance field because callback has failed (IO error?)");
+            return OBJ2VOXEL_ERR_IO_ERROR_DURING_VOXEL_WRITE;
+        }
+    }
+
+    VXIO_LOG(INFO, "Distance field with resolution " + stringifyLargeInt(grid.size()) + " written");
+    return OBJ2VOXEL_ERR_OK;
+}
+
+/// Computes the distance field if requested and finalizes all sinks once every chunk has been voxelized.
+template <bool PARALLEL>
+[[nodiscard]] obj2voxel_error_t finishVoxelization(obj2voxel_instance &instance,
+                                                   VoxelizationHelper<PARALLEL> &helper,
+                                                   usize triangleCount)
+{
+    // the normal sink can also fail, which is only tracked through sinkWritable
+    if (not instance.voxelSink->canWrite() || not instance.sinkWritable) {
+        VXIO_LOG(ERROR, "Voxelization failed because of IO error");
+        return OBJ2VOXEL_ERR_IO_ERROR_DURING_VOXEL_WRITE;
+    }
+
+    if (instance.distanceGrid != nullptr) {
+        obj2voxel_error_t result = computeDistanceField(instance, helper);
+        if (result != OBJ2VOXEL_ERR_OK) {
+            return result;
+        }
+    }
+
+    VXIO_LOG(INFO, "Voxelized " + stringifyLargeInt(triangleCount) + " triangles, writing any buffered voxels ...");
+
+    instance.voxelSink->finalize();
+    if (instance.normalSink != nullptr) {
+        instance.normalSink->finalize();
+    }
+    if (instance.tiledOutput != nullptr && not instance.tiledOutput->finalize()) {
+        return OBJ2VOXEL_ERR_IO_ERROR_DURING_VOXEL_WRITE;
+    }
+
+    const usize voxelsWritten = instance.tiledOutput != nullptr ? instance.tiledOutput->voxelsWritten()
+                                                                : instance.voxelSink->voxelsWritten();
+    VXIO_LOG(INFO, "All " + stringifyLargeInt(voxelsWritten) + " voxels written");
+    return OBJ2VOXEL_ERR_OK;
+}
+
 template <bool PARALLEL>
 [[nodiscard]] obj2voxel_error_t voxelize_specialized(obj2voxel_instance &instance)
 {
@@ -479,106 +1298,407 @@ template <bool PARALLEL>
         helper.waitForCompletion();
     }
 
-    instance.meshTransform = computeMeshTransform(instance);
+    instance.meshTransform = computeMeshTransform(instance);
+    instance.faceHashes.resize(triangleCount);
+
+    if (instance.decimation != 0) {
+        VXIO_LOG(DEBUG, "Decimating mesh with " + stringify(instance.decimation) + " vertex clusters per voxel ...");
+    }
+
+    for (u32 i = 0; i < triangleCount; i += BATCH_SIZE) {
+        helper.transformTriangles(i);
+    }
+    helper.waitForCompletion();
+
+    cullTriangles(instance);
+    const usize culledTriangleCount = instance.triangles.size();
+
+    if (instance.supersampling > 1) {
+        VXIO_LOG(INFO,
+                 "Chunks will be downscaled from " + stringifyLargeInt(instance.sampleResolution) +
+                     " to output resolution " + stringifyLargeInt(instance.outputResolution) + " ...");
+    }
+
+    VXIO_LOG(DEBUG, "Voxelizing ...");
+    initChunkRanges<PARALLEL>(instance);
+    binAndVoxelizeChunks(instance, helper, Vec3u32::zero(), Vec3u32::filledWith(~u32{0}));
+    applyPostProcessing(instance, helper);
+
+    return finishVoxelization(instance, helper, culledTriangleCount);
+}
+
+std::unique_ptr<ITriangleStream> openMeshFile(const obj2voxel_instance &instance,
+                                              const std::string &path,
+                                              InputFormat format)
+{
+    // these formats are mapped into memory, which isn't possible for pipes
+    if (isStdioPath(path) && (format == InputFormat::STANFORD_TRIANGLE || format == InputFormat::GLTF_BINARY)) {
+        VXIO_LOG(ERROR, "Only OBJ and STL files can be read from standard input");
+        return nullptr;
+    }
+
+    switch (format) {
+    case InputFormat::WAVEFRONT_OBJ: return ITriangleStream::fromObjFile(path, instance.defaultTexture);
+    case InputFormat::STEREOLITHOGRAPHY: return ITriangleStream::fromStlFile(path);
+    case InputFormat::STANFORD_TRIANGLE: return ITriangleStream::fromPlyFile(path);
+    case InputFormat::GLTF_BINARY: return ITriangleStream::fromGlbFile(path);
+    // a manifest is not a single mesh, its tiles are opened by voxelizeTiles()
+    case InputFormat::TILE_MANIFEST: break;
+    }
+    VXIO_ASSERT_UNREACHABLE();
+}
+
+std::unique_ptr<ITriangleStream> openInput(obj2voxel_instance &instance)
+{
+    FileOrCallback<obj2voxel_triangle_callback, InputFormat> &input = instance.input;
+
+    VXIO_ASSERT(input.isPresent());
+
+    switch (input.type) {
+    case IoType::CALLBACK: {
+        return ITriangleStream::fromCallback(input.callbackWithData.callback, input.callbackWithData.data);
+    }
+    case IoType::FILE: {
+        return openMeshFile(instance, input.file.path, input.file.type);
+    }
+    case IoType::PUSHED: {
+        std::vector<std::vector<VisualTriangle>> buffers;
+        buffers.reserve(instance.pushBuffers.size());
+        for (auto &[thread, buffer] : instance.pushBuffers) {
+            buffers.push_back(std::move(buffer.triangles));
+        }
+        instance.pushBuffers.clear();
+        return ITriangleStream::fromBuffers(std::move(buffers));
+    }
+    default: VXIO_ASSERT_UNREACHABLE();
+    }
+}
+
+std::unique_ptr<IVoxelSink> openDiscardingSink()
+{
+    return IVoxelSink::fromCallback([](void *, uint32_t *, size_t) { return true; }, nullptr);
+}
+
+std::unique_ptr<IVoxelSink> openOutput(obj2voxel_instance &instance)
+{
+    FileOrCallback<obj2voxel_voxel_callback, voxelio::FileType> &output = instance.output;
+
+    if (instance.outputTiles != 0 && (output.type != IoType::FILE || isStdioPath(output.file.path))) {
+        VXIO_LOG(ERROR, "Tiled output requires an output file");
+        return nullptr;
+    }
+
+    switch (output.type) {
+    case IoType::MISSING: {
+        // only the distance field is written, so voxels are discarded
+        VXIO_ASSERT_NOTNULL(instance.sdfOutput.callback);
+        return openDiscardingSink();
+    }
+
+    case IoType::CALLBACK: {
+        return IVoxelSink::fromCallback(output.callbackWithData.callback, output.callbackWithData.data);
+    }
+
+    case IoType::FILE: {
+        if (instance.outputTiles != 0) {
+            instance.tiledOutput = std::make_unique<TiledVoxelOutput>(output.file.path,
+                                                                      output.file.type,
+                                                                      instance.outputResolution,
+                                                                      instance.outputTiles,
+                                                                      CHUNK_SIZE / instance.supersampling);
+            instance.tiledOutput->useDirectIo(instance.directIo);
+            // voxels bypass the regular sink and are written to the tiles instead
+            return openDiscardingSink();
+        }
+
+        std::unique_ptr<OutputStream> stream = openAsyncFileOutput(output.file.path, instance.directIo);
+        if (stream == nullptr) {
+            return nullptr;
+        }
+
+        return IVoxelSink::fromVoxelio(std::move(stream), output.file.type, instance.outputResolution);
+    }
+
+    case IoType::MEMORY_FILE: {
+        std::unique_ptr<ByteArrayOutputStream> streamPtr{new ByteArrayOutputStream};
+
+        return IVoxelSink::fromVoxelio(std::move(streamPtr), output.file.type, instance.outputResolution);
+    }
+
+    // triangles can be pushed, but voxels can't
+    case IoType::PUSHED: break;
+    }
+    VXIO_ASSERT_UNREACHABLE();
+}
+
+/// Returns the number of chunk indices which are needed to address every chunk of the grid.
+/// Chunk indices are Morton codes, so the grid must be padded to a power of two chunks on each axis.
+u64 chunkIndexCountOf(u32 sampleResolution)
+{
+    VXIO_DEBUG_ASSERT_LE(sampleResolution, MAX_SAMPLE_RESOLUTION);
+    u64 mortonChunksPerAxis = 1;
+    while (mortonChunksPerAxis < divCeil(sampleResolution, CHUNK_SIZE)) {
+        mortonChunksPerAxis *= 2;
+    }
+    return mortonChunksPerAxis * mortonChunksPerAxis * mortonChunksPerAxis;
+}
+
+// TILED VOXELIZATION ==================================================================================================
+
+/// The triangles of a tile, transformed into voxel space.
+struct LoadedTile {
+    /// Triangles can point to textures owned by the stream, so the stream lives as long as the triangles.
+    std::unique_ptr<ITriangleStream> stream;
+    std::vector<CachedTriangle> triangles;
+    std::vector<u64> faceHashes;
+};
+
+/**
+ * @brief Loads and transforms all triangles of a tile. Returns std::nullopt if the tile couldn't be opened.
+ * Triangles are only voxelized in the regions which the tile bounds overlap, and vertices outside of the grid would
+ * have negative voxel coordinates. Therefore, vertices are clamped into the tile bounds and the mesh bounds.
+ */
+std::optional<LoadedTile> loadTile(const obj2voxel_instance &instance, const TileInfo &tile)
+{
+    LoadedTile result;
+    result.stream = openMeshFile(instance, tile.path, *tileFormatOf(tile.path));
+    if (result.stream == nullptr) {
+        return std::nullopt;
+    }
+
+    // the bounds only differ from the tile bounds if the mesh bounds were set by the user
+    const Vec3 lower = obj2voxel::max(tile.min, instance.meshMin);
+    const Vec3 upper = obj2voxel::min(tile.max, instance.meshMax);
 
-    for (u32 i = 0; i < triangleCount; i += BATCH_SIZE) {
-        helper.transformTriangles(i);
+    usize clampedCount = 0;
+    CachedTriangle triangle{};
+    while (result.stream->next(triangle)) {
+        if (obj2voxel::min(triangle.min(), lower) != lower || obj2voxel::max(triangle.max(), upper) != upper) {
+            for (Vec3 &vertex : triangle.v) {
+                vertex = obj2voxel::min(obj2voxel::max(vertex, tile.min), tile.max);
+                vertex = obj2voxel::min(obj2voxel::max(vertex, instance.meshMin), instance.meshMax);
+            }
+            ++clampedCount;
+        }
+        result.faceHashes.push_back(transformTriangle(instance, triangle));
+        result.triangles.push_back(triangle);
     }
-    helper.waitForCompletion();
-
-    for (u32 i = 0; i < triangleCount; ++i) {
-        sortTriangleIntoChunks(instance, i);
+    if (clampedCount != 0) {
+        VXIO_LOG(WARNING,
+                 "Clamped " + stringifyLargeInt(clampedCount) + " triangles of tile \"" + tile.path +
+                     "\" which exceed its bounds");
     }
+    return result;
+}
 
-    if (instance.supersampling > 1) {
-        VXIO_LOG(INFO,
-                 "Chunks will be downscaled from " + stringifyLargeInt(instance.sampleResolution) +
-                     " to output resolution " + stringifyLargeInt(instance.outputResolution) + " ...");
+/// Computes the inclusive range of chunks which the bounds of a tile overlap after the mesh transform.
+void computeTileChunks(const obj2voxel_instance &instance, const TileInfo &tile, Vec3u32 &outMin, Vec3u32 &outMax)
+{
+    auto min = Vec3::filledWith(std::numeric_limits<real_type>::infinity());
+    auto max = -min;
+    for (usize corner = 0; corner < 8; ++corner) {
+        const Vec3 cornerPos{corner & 1 ? tile.max.x() : tile.min.x(),
+                             corner & 2 ? tile.max.y() : tile.min.y(),
+                             corner & 4 ? tile.max.z() : tile.min.z()};
+        const Vec3 transformed = instance.meshTransform * cornerPos;
+        min = obj2voxel::min(min, transformed);
+        max = obj2voxel::max(max, transformed);
     }
 
-    helper.waitForCompletion();
+    const auto lastChunk = static_cast<real_type>(divCeil(instance.sampleResolution, CHUNK_SIZE) - 1);
+    for (usize i = 0; i < 3; ++i) {
+        outMin[i] = static_cast<u32>(std::clamp(std::floor(min[i] / CHUNK_SIZE), real_type{0}, lastChunk));
+        outMax[i] = static_cast<u32>(std::clamp(std::floor(max[i] / CHUNK_SIZE), real_type{0}, lastChunk));
+    }
+}
 
-    VXIO_LOG(DEBUG, "Voxelizing ...");
-    // TODO consider simply iterating over pairs instead
-    for (u32 i = 0; i < instance.chunkCount; ++i) {
-        helper.voxelizeChunk(i);
+/**
+ * @brief Voxelizes a model which is split into tiles without ever loading all tiles at once.
+ * The grid is divided into cubic regions of chunks and each tile is binned into every region that its bounds overlap.
+ * Regions are then voxelized one after another using only the tiles which overlap them.
+ * A tile is evicted as soon as its last region has been voxelized, and the tiles of the next region are loaded in the
+ * background while the current region is being voxelized.
+ */
+template <bool PARALLEL>
+[[nodiscard]] obj2voxel_error_t voxelize_tiled(obj2voxel_instance &instance, const std::vector<TileInfo> &tiles)
+{
+    VoxelizationHelper<PARALLEL> helper{instance};
+    instance.meshTransform = computeMeshTransform(instance);
+    initChunkRanges<PARALLEL>(instance);
+
+    const u32 chunksPerAxis = divCeil(instance.sampleResolution, CHUNK_SIZE);
+    const u32 regionsPerAxis = divCeil(chunksPerAxis, TILE_REGION_SIZE);
+
+    // Regions are stored sparsely because huge grids have far more regions than could be allocated or visited.
+    std::map<u64, std::vector<usize>> regionTiles;
+    std::vector<usize> remainingRegionsOfTile(tiles.size());
+    for (usize tile = 0; tile < tiles.size(); ++tile) {
+        Vec3u32 chunkMin, chunkMax;
+        computeTileChunks(instance, tiles[tile], chunkMin, chunkMax);
+        const Vec3u32 regionMin = chunkMin / TILE_REGION_SIZE;
+        const Vec3u32 regionMax = chunkMax / TILE_REGION_SIZE;
+
+        for (u32 z = regionMin.z(); z <= regionMax.z(); ++z) {
+            for (u32 y = regionMin.y(); y <= regionMax.y(); ++y) {
+                for (u32 x = regionMin.x(); x <= regionMax.x(); ++x) {
+                    regionTiles[(u64{z} * regionsPerAxis + y) * regionsPerAxis + x].push_back(tile);
+                    ++remainingRegionsOfTile[tile];
+                }
+            }
+        }
     }
 
-    helper.waitForCompletion();
+    const auto boundsOfRegion = [&](u64 region, Vec3u32 &outMin, Vec3u32 &outMax) {
+        const auto regionPos = Vec3u32{static_cast<u32>(region % regionsPerAxis),
+                                       static_cast<u32>(region / regionsPerAxis % regionsPerAxis),
+                                       static_cast<u32>(region / regionsPerAxis / regionsPerAxis)};
+        outMin = regionPos * TILE_REGION_SIZE;
+        outMax = obj2voxel::min(outMin + Vec3u32::filledWith(TILE_REGION_SIZE), Vec3u32::filledWith(chunksPerAxis)) -
+                 Vec3u32::one();
+    };
 
-    if (not instance.voxelSink->canWrite()) {
-        VXIO_LOG(ERROR, "Voxelization failed because of IO error");
-        return OBJ2VOXEL_ERR_IO_ERROR_DURING_VOXEL_WRITE;
+    // Every visited region completes the empty chunks of its own box.
+    // The empty chunks of all other regions are completed at once, so that regions without tiles are never visited.
+    // Post-processed chunks are completed afterwards, since morphology can grow into empty chunks.
+    if (instance.tiledOutput != nullptr && instance.postProcessor == nullptr) {
+        std::vector<u64> visitedChunks;
+        for (const auto &[region, tilesOfRegion] : regionTiles) {
+            Vec3u32 regionMin, regionMax;
+            boundsOfRegion(region, regionMin, regionMax);
+            for (u32 z = regionMin.z(); z <= regionMax.z(); ++z) {
+                for (u32 y = regionMin.y(); y <= regionMax.y(); ++y) {
+                    for (u32 x = regionMin.x(); x <= regionMax.x(); ++x) {
+                        visitedChunks.push_back(ileave3(x, y, z));
+                    }
+                }
+            }
+        }
+        completeEmptyTiledChunks(instance, Vec3u32::zero(), Vec3u32::filledWith(chunksPerAxis - 1), visitedChunks);
     }
 
-    VXIO_LOG(INFO, "Voxelized " + stringifyLargeInt(triangleCount) + " triangles, writing any buffered voxels ...");
+    std::unordered_map<usize, LoadedTile> loadedTiles;
+    std::vector<bool> startsInRegion;
+    std::vector<usize> prefetchedTiles;
+    std::future<std::vector<std::optional<LoadedTile>>> prefetch;
+    usize loadedTriangleCount = 0;
 
-    instance.voxelSink->finalize();
+    const auto storeTile = [&](usize tile, std::optional<LoadedTile> loaded) -> bool {
+        if (not loaded.has_value()) {
+            VXIO_LOG(ERROR, "Failed to load tile \"" + tiles[tile].path + '"');
+            return false;
+        }
+        loadedTriangleCount += loaded->triangles.size();
+        loadedTiles.emplace(tile, std::move(*loaded));
+        return true;
+    };
 
-    VXIO_LOG(INFO, "All " + stringifyLargeInt(instance.voxelSink->voxelsWritten()) + " voxels written");
-    return OBJ2VOXEL_ERR_OK;
-}
+    for (auto regionIt = regionTiles.begin(); regionIt != regionTiles.end(); ++regionIt) {
+        const auto &[region, tilesOfRegion] = *regionIt;
+        Vec3u32 regionMin, regionMax;
+        boundsOfRegion(region, regionMin, regionMax);
+
+        if (prefetch.valid()) {
+            std::vector<std::optional<LoadedTile>> prefetched = prefetch.get();
+            for (usize i = 0; i < prefetchedTiles.size(); ++i) {
+                if (not storeTile(prefetchedTiles[i], std::move(prefetched[i]))) {
+                    return OBJ2VOXEL_ERR_IO_ERROR_ON_OPEN_INPUT_FILE;
+                }
+            }
+        }
+        for (usize tile : tilesOfRegion) {
+            if (loadedTiles.count(tile) == 0 && not storeTile(tile, loadTile(instance, tiles[tile]))) {
+                return OBJ2VOXEL_ERR_IO_ERROR_ON_OPEN_INPUT_FILE;
+            }
+        }
 
-std::unique_ptr<ITriangleStream> openInput(obj2voxel_instance &instance)
-{
-    FileOrCallback<obj2voxel_triangle_callback> &input = instance.input;
+        // the tiles of the next region are loaded while this region is being voxelized
+        prefetchedTiles.clear();
+        for (auto next = std::next(regionIt); next != regionTiles.end() && prefetchedTiles.empty(); ++next) {
+            for (usize tile : next->second) {
+                if (loadedTiles.count(tile) == 0) {
+                    prefetchedTiles.push_back(tile);
+                }
+            }
+        }
+        if (not prefetchedTiles.empty()) {
+            prefetch = std::async(std::launch::async, [&instance, &tiles, indices = prefetchedTiles] {
+                std::vector<std::optional<LoadedTile>> result;
+                for (usize tile : indices) {
+                    result.push_back(loadTile(instance, tiles[tile]));
+                }
+                return result;
+            });
+        }
 
-    VXIO_ASSERT(input.isPresent());
+        // Triangles are copied so that their chunk bounds can be clipped to the region.
+        // A triangle is culled in every region it overlaps, but only counted in the region of its minimum chunk.
+        instance.triangles.clear();
+        instance.faceHashes.clear();
+        startsInRegion.clear();
+        for (usize tile : tilesOfRegion) {
+            const LoadedTile &loaded = loadedTiles.at(tile);
+            for (usize i = 0; i < loaded.triangles.size(); ++i) {
+                CachedTriangle triangle = loaded.triangles[i];
+                const bool startsInThisRegion = obj2voxel::max(triangle.chunkMin, regionMin) == triangle.chunkMin;
+                triangle.chunkMin = obj2voxel::max(triangle.chunkMin, regionMin);
+                triangle.chunkMax = obj2voxel::min(triangle.chunkMax, regionMax);
+                if (obj2voxel::min(triangle.chunkMin, triangle.chunkMax) == triangle.chunkMin) {
+                    instance.triangles.push_back(triangle);
+                    instance.faceHashes.push_back(loaded.faceHashes[i]);
+                    startsInRegion.push_back(startsInThisRegion);
+                }
+            }
+        }
 
-    switch (input.type) {
-    case IoType::CALLBACK: {
-        return ITriangleStream::fromCallback(input.callbackWithData.callback, input.callbackWithData.data);
-    }
-    case IoType::FILE: {
-        switch (input.file.type) {
-        case FileType::WAVEFRONT_OBJ: return ITriangleStream::fromObjFile(input.file.path, instance.defaultTexture);
-        case FileType::STEREOLITHOGRAPHY: return ITriangleStream::fromStlFile(input.file.path);
-        default: return nullptr;
+        cullTriangles(instance, &startsInRegion);
+        binAndVoxelizeChunks(instance, helper, regionMin, regionMax);
+
+        for (usize tile : tilesOfRegion) {
+            if (--remainingRegionsOfTile[tile] == 0) {
+                loadedTiles.erase(tile);
+            }
+        }
+        if (not instance.sinkWritable) {
+            break;
         }
     }
-    default: VXIO_ASSERT_UNREACHABLE();
-    }
+
+    instance.triangles = {};
+    applyPostProcessing(instance, helper);
+    return finishVoxelization(instance, helper, loadedTriangleCount);
 }
 
-std::unique_ptr<IVoxelSink> openOutput(obj2voxel_instance &instance)
+[[nodiscard]] obj2voxel_error_t voxelizeTiles(obj2voxel_instance &instance, const std::vector<TileInfo> &tiles)
 {
-    FileOrCallback<obj2voxel_voxel_callback> &output = instance.output;
+    instance.chunkCount = chunkIndexCountOf(instance.sampleResolution);
 
-    VXIO_ASSERT(output.isPresent());
-
-    switch (output.type) {
-    case IoType::MISSING: {
-        VXIO_ASSERT_UNREACHABLE();
+    for (const TileInfo &tile : tiles) {
+        if (not tileFormatOf(tile.path).has_value()) {
+            VXIO_LOG(ERROR, "Tile \"" + tile.path + "\" is not in a supported mesh format");
+            return OBJ2VOXEL_ERR_IO_ERROR_ON_OPEN_INPUT_FILE;
+        }
     }
 
-    case IoType::CALLBACK: {
-        return IVoxelSink::fromCallback(output.callbackWithData.callback, output.callbackWithData.data);
+    if (tiles.empty()) {
+        VXIO_LOG(WARNING, "Tile manifest has no tiles, aborting and writing empty voxel model");
+        instance.voxelSink->finalize();
+        return instance.voxelSink->canWrite() ? OBJ2VOXEL_ERR_OK : OBJ2VOXEL_ERR_IO_ERROR_DURING_VOXEL_WRITE;
     }
 
-    case IoType::FILE: {
-        std::optional<FileOutputStream> stream = FileOutputStream::open(output.file.path, OpenMode::BINARY);
-        if (not stream.has_value()) {
-            return nullptr;
+    // the manifest bounds replace the search for mesh bounds, which would require loading every tile
+    if (not instance.boundsKnown) {
+        for (const TileInfo &tile : tiles) {
+            instance.meshMin = obj2voxel::min(instance.meshMin, tile.min);
+            instance.meshMax = obj2voxel::max(instance.meshMax, tile.max);
         }
-
-        std::unique_ptr<OutputStream> streamPtr{new FileOutputStream{std::move(*stream)}};
-
-        return IVoxelSink::fromVoxelio(std::move(streamPtr), output.file.type, instance.outputResolution);
     }
 
-    case IoType::MEMORY_FILE: {
-        std::unique_ptr<ByteArrayOutputStream> streamPtr{new ByteArrayOutputStream};
-
-        return IVoxelSink::fromVoxelio(std::move(streamPtr), output.file.type, instance.outputResolution);
-    }
-    }
-    VXIO_ASSERT_UNREACHABLE();
+    return instance.parallel ? voxelize_tiled<true>(instance, tiles) : voxelize_tiled<false>(instance, tiles);
 }
 
 [[nodiscard]] obj2voxel_error_t voxelize(obj2voxel_instance &instance, ITriangleStream &stream)
 {
-    u32 chunkCountCbrt = divCeil(instance.sampleResolution, CHUNK_SIZE);
-    instance.chunkCount = chunkCountCbrt * chunkCountCbrt * chunkCountCbrt;
+    instance.chunkCount = chunkIndexCountOf(instance.sampleResolution);
 
     VXIO_LOG(DEBUG, "Caching triangles ...");
 
@@ -586,6 +1706,9 @@ std::unique_ptr<IVoxelSink> openOutput(obj2voxel_instance &instance)
     while (stream.next(triangle)) {
         instance.triangles.push_back(triangle);
     }
+    if (stream.failed()) {
+        return OBJ2VOXEL_ERR_IO_ERROR_ON_OPEN_INPUT_FILE;
+    }
 
     if (instance.triangles.empty()) {
         VXIO_LOG(WARNING, "Model has no triangles, aborting and writing empty voxel model");
@@ -608,7 +1731,11 @@ std::unique_ptr<IVoxelSink> openOutput(obj2voxel_instance &instance)
         VXIO_LOG(ERROR, "No input was specified");
         return OBJ2VOXEL_ERR_NO_INPUT;
     }
-    if (not instance.output.isPresent()) {
+    if (instance.input.type == IoType::PUSHED && not instance.inputFinished) {
+        VXIO_LOG(ERROR, "Triangles were pushed, but the input was never finished");
+        return OBJ2VOXEL_ERR_NO_INPUT;
+    }
+    if (not instance.output.isPresent() && instance.sdfOutput.callback == nullptr) {
         VXIO_LOG(ERROR, "No output was specified");
         return OBJ2VOXEL_ERR_NO_OUTPUT;
     }
@@ -616,18 +1743,62 @@ std::unique_ptr<IVoxelSink> openOutput(obj2voxel_instance &instance)
         VXIO_LOG(ERROR, "No resolution was specified");
         return OBJ2VOXEL_ERR_NO_RESOLUTION;
     }
+    if (u64{instance.outputResolution} * instance.supersampling > MAX_SAMPLE_RESOLUTION) {
+        VXIO_LOG(ERROR,
+                 "Resolution " + stringifyLargeInt(instance.outputResolution) + " with supersampling exceeds the "
+                 "maximum of " + stringifyLargeInt(MAX_SAMPLE_RESOLUTION));
+        return OBJ2VOXEL_ERR_NO_RESOLUTION;
+    }
+    if (instance.sdfOutput.callback != nullptr && instance.outputResolution > MAX_SDF_RESOLUTION) {
+        VXIO_LOG(ERROR,
+                 "Resolution " + stringifyLargeInt(instance.outputResolution) + " exceeds the maximum of " +
+                     stringifyLargeInt(MAX_SDF_RESOLUTION) + " for distance fields");
+        return OBJ2VOXEL_ERR_NO_RESOLUTION;
+    }
 
-    std::unique_ptr<ITriangleStream> input = openInput(instance);
-    if (input == nullptr) {
-        return OBJ2VOXEL_ERR_IO_ERROR_ON_OPEN_INPUT_FILE;
+    const bool tiled = instance.input.type == IoType::FILE && instance.input.file.type == InputFormat::TILE_MANIFEST;
+    std::unique_ptr<ITriangleStream> input;
+    std::optional<std::vector<TileInfo>> tiles;
+    if (tiled) {
+        tiles = parseTileManifest(instance.input.file.path);
+        if (not tiles.has_value()) {
+            return OBJ2VOXEL_ERR_IO_ERROR_ON_OPEN_INPUT_FILE;
+        }
+    }
+    else {
+        input = openInput(instance);
+        if (input == nullptr) {
+            return OBJ2VOXEL_ERR_IO_ERROR_ON_OPEN_INPUT_FILE;
+        }
     }
 
     instance.voxelSink = openOutput(instance);
     if (instance.voxelSink == nullptr) {
         return OBJ2VOXEL_ERR_IO_ERROR_ON_OPEN_OUTPUT_FILE;
     }
+    if (instance.normalOutput.callback != nullptr) {
+        instance.normalSink = IVoxelSink::fromCallback(instance.normalOutput.callback, instance.normalOutput.data);
+    }
+    if (instance.attribute == VoxelAttribute::MATERIAL) {
+        if (tiled) {
+            VXIO_LOG(WARNING, "Material indices of different tiles are not merged, so material colors are unknown");
+        }
+        std::vector<u32> materialColors = tiled ? std::vector<u32>{} : input->materialColors();
+        if (instance.tiledOutput != nullptr) {
+            instance.tiledOutput->useMaterials(materialColors);
+        }
+        instance.voxelSink->useMaterials(std::move(materialColors));
+    }
+    if (instance.sdfOutput.callback != nullptr) {
+        instance.distanceGrid = std::make_unique<DistanceGrid>(instance.outputResolution);
+    }
+    const bool removesIslands = instance.minIslandVoxels > 1 || instance.maxIslands != 0;
+    if ((not instance.morphology.empty() || removesIslands) && instance.output.isPresent()) {
+        instance.postProcessor =
+            std::make_unique<ChunkPostProcessor>(instance.outputResolution, CHUNK_SIZE / instance.supersampling);
+    }
 
-    obj2voxel_error_t result = voxelize(instance, *input);
+    obj2voxel_error_t result = tiled ? voxelizeTiles(instance, *tiles) : voxelize(instance, *input);
     if (instance.output.type != IoType::MEMORY_FILE) {
         instance.voxelSink.reset();
     }
@@ -704,6 +1875,50 @@ void obj2voxel_set_color_strategy(obj2voxel_instance *instance, obj2voxel_enum_t
     instance->colorStrategy = strategy == OBJ2VOXEL_MAX_STRATEGY ? ColorStrategy::MAX : ColorStrategy::BLEND;
 }
 
+void obj2voxel_set_alpha_cutoff(obj2voxel_instance *instance, float cutoff)
+{
+    VXIO_ASSERT_NOTNULL(instance);
+    VXIO_ASSERT_GE(cutoff, 0.f);
+    VXIO_ASSERT_LE(cutoff, 1.f);
+    instance->alphaCutoff = cutoff;
+}
+
+void obj2voxel_set_voxel_attribute(obj2voxel_instance *instance, obj2voxel_enum_t attribute)
+{
+    VXIO_ASSERT_NOTNULL(instance);
+    VXIO_ASSERT_LT(attribute, 2);
+    instance->attribute = attribute == OBJ2VOXEL_ATTRIBUTE_COLOR ? VoxelAttribute::COLOR : VoxelAttribute::MATERIAL;
+}
+
+void obj2voxel_set_topology(obj2voxel_instance *instance, obj2voxel_enum_t topology)
+{
+    VXIO_ASSERT_NOTNULL(instance);
+    VXIO_ASSERT_LT(topology, 2);
+    instance->topology = topology == OBJ2VOXEL_CONSERVATIVE_TOPOLOGY ? Topology::CONSERVATIVE : Topology::THIN;
+}
+
+void obj2voxel_set_decimation(obj2voxel_instance *instance, uint32_t cells_per_voxel)
+{
+    VXIO_ASSERT_NOTNULL(instance);
+    instance->decimation = cells_per_voxel;
+}
+
+void obj2voxel_add_morphology(obj2voxel_instance *instance, obj2voxel_enum_t operation, uint32_t radius)
+{
+    VXIO_ASSERT_NOTNULL(instance);
+    VXIO_ASSERT_LT(operation, 4);
+    if (radius != 0) {
+        instance->morphology.push_back({static_cast<Morphology>(operation), radius});
+    }
+}
+
+void obj2voxel_set_island_removal(obj2voxel_instance *instance, uint64_t min_voxels, uint32_t max_islands)
+{
+    VXIO_ASSERT_NOTNULL(instance);
+    instance->minIslandVoxels = min_voxels;
+    instance->maxIslands = max_islands;
+}
+
 void obj2voxel_set_texture(obj2voxel_instance *instance, obj2voxel_texture *texture)
 {
     VXIO_ASSERT_NOTNULL(instance);
@@ -716,7 +1931,7 @@ void obj2voxel_set_input_file(obj2voxel_instance *instance, const char *file, co
     VXIO_ASSERT_NOTNULL(instance);
     VXIO_ASSERT_NOTNULL(file);
 
-    instance->input = TypedFile{file, detectFileType(file, type)};
+    instance->input = TypedFile<InputFormat>{file, detectInputFormat(file, type)};
 }
 
 void obj2voxel_set_input_callback(obj2voxel_instance *instance,
@@ -729,12 +1944,78 @@ void obj2voxel_set_input_callback(obj2voxel_instance *instance,
     instance->input = CallbackWithData<obj2voxel_triangle_callback>{callback, callback_data};
 }
 
+void obj2voxel_push_triangles(obj2voxel_instance *instance,
+                              const float vertices[],
+                              const float colors[],
+                              size_t count)
+{
+    VXIO_ASSERT_NOTNULL(instance);
+    VXIO_ASSERT_NOTNULL(vertices);
+
+    PushBuffer *buffer;
+    {
+        std::lock_guard<std::mutex> lock{instance->pushMutex};
+        VXIO_ASSERTM(not instance->inputFinished, "Triangles were pushed after the input was finished");
+        if (instance->input.type != IoType::PUSHED) {
+            instance->input = {};
+            instance->input.type = IoType::PUSHED;
+        }
+        // references to elements of unordered maps remain valid when other threads insert their buffers
+        buffer = &instance->pushBuffers[std::this_thread::get_id()];
+    }
+
+    buffer->triangles.reserve(buffer->triangles.size() + count);
+    for (size_t i = 0; i < count; ++i) {
+        VisualTriangle triangle;
+        if (colors == nullptr) {
+            obj2voxel_set_triangle_basic(&triangle, vertices + i * 9);
+        }
+        else {
+            obj2voxel_set_triangle_colored(&triangle, vertices + i * 9, colors + i * 3);
+        }
+        buffer->min = obj2voxel::min(triangle.min(), buffer->min);
+        buffer->max = obj2voxel::max(triangle.max(), buffer->max);
+        buffer->triangles.push_back(triangle);
+    }
+}
+
+void obj2voxel_finish_input(obj2voxel_instance *instance)
+{
+    VXIO_ASSERT_NOTNULL(instance);
+
+    std::lock_guard<std::mutex> lock{instance->pushMutex};
+    VXIO_ASSERTM(not instance->inputFinished, "The input was finished twice");
+    instance->inputFinished = true;
+
+    // merging the bounds of each thread replaces the search for mesh bounds, unless they were set by the user
+    if (instance->boundsKnown || instance->pushBuffers.empty()) {
+        return;
+    }
+    for (const auto &[thread, buffer] : instance->pushBuffers) {
+        instance->meshMin = obj2voxel::min(instance->meshMin, buffer.min);
+        instance->meshMax = obj2voxel::max(instance->meshMax, buffer.max);
+    }
+    instance->boundsKnown = true;
+}
+
 void obj2voxel_set_output_file(obj2voxel_instance *instance, const char *file, const char *type)
 {
     VXIO_ASSERT_NOTNULL(instance);
     VXIO_ASSERT_NOTNULL(file);
 
-    instance->output = TypedFile{file, detectFileType(file, type)};
+    instance->output = TypedFile<voxelio::FileType>{file, detectFileType(file, type)};
+}
+
+void obj2voxel_set_output_tiles(obj2voxel_instance *instance, uint32_t tiles_per_axis)
+{
+    VXIO_ASSERT_NOTNULL(instance);
+    instance->outputTiles = tiles_per_axis;
+}
+
+void obj2voxel_set_direct_io(obj2voxel_instance *instance, bool enabled)
+{
+    VXIO_ASSERT_NOTNULL(instance);
+    instance->directIo = enabled;
 }
 
 void obj2voxel_set_output_memory(obj2voxel_instance *instance, const char *type)
@@ -742,7 +2023,7 @@ void obj2voxel_set_output_memory(obj2voxel_instance *instance, const char *type)
     VXIO_ASSERT_NOTNULL(instance);
     VXIO_ASSERT_NOTNULL(type);
 
-    instance->output = TypedFile{nullptr, detectFileType(nullptr, type)};
+    instance->output = TypedFile<voxelio::FileType>{nullptr, detectFileType(nullptr, type)};
 }
 
 uint32_t obj2voxel_get_resolution(obj2voxel_instance *instance)
@@ -778,6 +2059,25 @@ const obj2voxel_byte_t *obj2voxel_get_output_memory(obj2voxel_instance *instance
     return byteStream->data();
 }
 
+uint64_t obj2voxel_get_live_triangle_pages(obj2voxel_instance *instance)
+{
+    VXIO_ASSERT_NOTNULL(instance);
+    return instance->liveTrianglePages;
+}
+
+void obj2voxel_get_culled_triangle_counts(obj2voxel_instance *instance,
+                                          uint64_t *out_degenerate,
+                                          uint64_t *out_duplicate)
+{
+    VXIO_ASSERT_NOTNULL(instance);
+    if (out_degenerate != nullptr) {
+        *out_degenerate = instance->degenerateTriangles;
+    }
+    if (out_duplicate != nullptr) {
+        *out_duplicate = instance->duplicateTriangles;
+    }
+}
+
 void obj2voxel_set_output_callback(obj2voxel_instance *instance,
                                    obj2voxel_voxel_callback *callback,
                                    void *callback_data)
@@ -788,6 +2088,27 @@ void obj2voxel_set_output_callback(obj2voxel_instance *instance,
     instance->output = CallbackWithData<obj2voxel_voxel_callback>{callback, callback_data};
 }
 
+void obj2voxel_set_sdf_output(obj2voxel_instance *instance,
+                              float band,
+                              obj2voxel_sdf_callback *callback,
+                              void *callback_data)
+{
+    VXIO_ASSERT_NOTNULL(instance);
+    VXIO_ASSERT_NOTNULL(callback);
+    VXIO_ASSERT_GE(band, 0.f);
+    instance->sdfOutput = {callback, callback_data};
+    instance->sdfBand = band;
+}
+
+void obj2voxel_set_normal_output_callback(obj2voxel_instance *instance,
+                                          obj2voxel_voxel_callback *callback,
+                                          void *callback_data)
+{
+    VXIO_ASSERT_NOTNULL(instance);
+    VXIO_ASSERT_NOTNULL(callback);
+    instance->normalOutput = {callback, callback_data};
+}
+
 void obj2voxel_set_parallel(obj2voxel_instance *instance, bool enabled)
 {
     VXIO_ASSERT_NOTNULL(instance);
@@ -823,6 +2144,7 @@ void obj2voxel_set_triangle_basic(obj2voxel_triangle *triangle, const float vert
     triangle->v[0] = obj2voxel::Vec3{vertices + 0};
     triangle->v[1] = obj2voxel::Vec3{vertices + 3};
     triangle->v[2] = obj2voxel::Vec3{vertices + 6};
+    triangle->material = 0;
 }
 
 void obj2voxel_set_triangle_colored(obj2voxel_triangle *triangle, const float vertices[9], const float color[3])
@@ -834,6 +2156,7 @@ void obj2voxel_set_triangle_colored(obj2voxel_triangle *triangle, const float ve
     triangle->v[1] = obj2voxel::Vec3{vertices + 3};
     triangle->v[2] = obj2voxel::Vec3{vertices + 6};
     triangle->color = obj2voxel::Vec3f{color};
+    triangle->material = 0;
 }
 
 void obj2voxel_set_triangle_textured(obj2voxel_triangle *triangle,
@@ -851,6 +2174,13 @@ void obj2voxel_set_triangle_textured(obj2voxel_triangle *triangle,
     triangle->t[1] = obj2voxel::Vec2f{textures + 2};
     triangle->t[2] = obj2voxel::Vec2f{textures + 4};
     triangle->texture = texture;
+    triangle->material = 0;
+}
+
+void obj2voxel_set_triangle_material(obj2voxel_triangle *triangle, uint32_t material)
+{
+    VXIO_DEBUG_ASSERT_NOTNULL(triangle);
+    triangle->material = material;
 }
 
 obj2voxel_texture *obj2voxel_texture_alloc(void)
@@ -883,6 +2213,7 @@ bool obj2voxel_texture_load_from_file(obj2voxel_texture *texture, const char *fi
         return false;
     }
     texture->image = std::move(image);
+    texture->borrowed = std::nullopt;
 
     return true;
 }
@@ -905,6 +2236,7 @@ bool obj2voxel_texture_load_from_memory(obj2voxel_texture *texture,
         return false;
     }
     texture->image = std::move(image);
+    texture->borrowed = std::nullopt;
 
     return true;
 }
@@ -921,20 +2253,57 @@ bool obj2voxel_texture_load_pixels(
     auto data = std::make_unique<uint8_t[]>(size);
     std::memcpy(data.get(), pixels, size);
     texture->image = voxelio::Image{width, height, colorFormatOfChannelCount(channels), std::move(data)};
+    texture->borrowed = std::nullopt;
+    return true;
+}
+
+bool obj2voxel_texture_borrow_pixels(obj2voxel_texture *texture,
+                                     const obj2voxel_byte_t *pixels,
+                                     size_t width,
+                                     size_t height,
+                                     size_t stride,
+                                     obj2voxel_enum_t channel_order)
+{
+    VXIO_ASSERT_NOTNULL(texture);
+    VXIO_ASSERT_NOTNULL(pixels);
+    VXIO_ASSERT_LE(channel_order, OBJ2VOXEL_CHANNELS_ARGB);
+
+    // offsets of red, green, blue and alpha for each channel order
+    constexpr u8 offsetsOfOrder[5][4]{{0, 1, 2, 3}, {2, 1, 0, 3}, {0, 1, 2, 3}, {2, 1, 0, 3}, {1, 2, 3, 0}};
+    const usize channels = channel_order <= OBJ2VOXEL_CHANNELS_BGR ? 3 : 4;
+    if (width == 0 || height == 0 || stride < width * channels) {
+        return false;
+    }
+
+    const u8 *offsets = offsetsOfOrder[channel_order];
+    texture->borrowed = BorrowedPixels{
+        pixels, width, height, stride, channels, {offsets[0], offsets[1], offsets[2]}, offsets[3], WrapMode::REPEAT};
+    texture->image = std::nullopt;
     return true;
 }
 
 void obj2voxel_teture_set_uv_mode(obj2voxel_texture *texture, obj2voxel_enum_t mode)
 {
-    VXIO_ASSERTM(texture->image.has_value(), "Can't set UV mode of empty texture");
+    VXIO_ASSERTM(texture->isLoaded(), "Can't set UV mode of empty texture");
     auto wrapMode = mode == OBJ2VOXEL_UV_CLAMP ? voxelio::WrapMode::CLAMP : voxelio::WrapMode::REPEAT;
-    texture->image->setWrapMode(wrapMode);
+    if (texture->borrowed.has_value()) {
+        texture->borrowed->wrapMode = wrapMode;
+    }
+    else {
+        texture->image->setWrapMode(wrapMode);
+    }
 }
 
 void obj2voxel_texture_get_meta(obj2voxel_texture *texture, size_t *out_width, size_t *out_height, size_t *out_channels)
 {
     VXIO_ASSERT_NOTNULL(texture);
-    VXIO_ASSERTM(texture->image.has_value(), "Can't get metadata of empty image");
+    VXIO_ASSERTM(texture->isLoaded(), "Can't get metadata of empty image");
+    if (texture->borrowed.has_value()) {
+        *out_width = texture->borrowed->width;
+        *out_height = texture->borrowed->height;
+        *out_channels = texture->borrowed->channels;
+        return;
+    }
     *out_width = texture->image->width();
     *out_height = texture->image->height();
     *out_channels = voxelio::channelCountOf(texture->image->format());
@@ -944,16 +2313,127 @@ void obj2voxel_texture_get_pixels(obj2voxel_texture *texture, obj2voxel_byte_t *
 {
     VXIO_ASSERT_NOTNULL(texture);
     VXIO_ASSERT_NOTNULL(out_pixels);
-    VXIO_ASSERTM(texture->image.has_value(), "Can't get pixels of empty image");
-    std::memcpy(out_pixels, texture->image->data(), texture->image->dataSize());
+    VXIO_ASSERTM(texture->isLoaded(), "Can't get pixels of empty image");
+    if (not texture->borrowed.has_value()) {
+        std::memcpy(out_pixels, texture->image->data(), texture->image->dataSize());
+        return;
+    }
+
+    const BorrowedPixels &pixels = *texture->borrowed;
+    for (usize y = 0; y < pixels.height; ++y) {
+        for (usize x = 0; x < pixels.width; ++x) {
+            const Color32 color = pixels.getPixel(x, y);
+            if (pixels.channels == 4) {
+                *out_pixels++ = color.a;
+            }
+            *out_pixels++ = color.r;
+            *out_pixels++ = color.g;
+            *out_pixels++ = color.b;
+        }
+    }
+}
+
+const obj2voxel_byte_t *obj2voxel_texture_peek_pixels(obj2voxel_texture *texture, size_t *out_stride)
+{
+    VXIO_ASSERT_NOTNULL(texture);
+    VXIO_ASSERTM(texture->isLoaded(), "Can't get pixels of empty image");
+    if (texture->borrowed.has_value()) {
+        if (out_stride != nullptr) {
+            *out_stride = texture->borrowed->stride;
+        }
+        return texture->borrowed->data;
+    }
+    if (out_stride != nullptr) {
+        *out_stride = texture->image->width() * voxelio::channelCountOf(texture->image->format());
+    }
+    return texture->image->data();
 }
 
 obj2voxel_error_t obj2voxel_voxelize(obj2voxel_instance *instance)
 {
     VXIO_ASSERT_NOTNULL(instance);
+    if (instance->asyncThread.joinable()) {
+        return OBJ2VOXEL_ERR_DOUBLE_VOXELIZATION;
+    }
     return obj2voxel::voxelize(*instance);
 }
 
+obj2voxel_error_t obj2voxel_voxelize_async(obj2voxel_instance *instance)
+{
+    VXIO_ASSERT_NOTNULL(instance);
+    if (instance->done || instance->asyncThread.joinable()) {
+        return OBJ2VOXEL_ERR_DOUBLE_VOXELIZATION;
+    }
+
+    instance->asyncThread = std::thread{[instance] {
+        const obj2voxel_error_t result = obj2voxel::voxelize(*instance);
+        {
+            std::lock_guard<std::mutex> lock{instance->asyncMutex};
+            instance->asyncResult = result;
+            instance->asyncCompletion.trigger();
+            if (instance->completionNotifier != nullptr) {
+                instance->completionNotifier->notify();
+            }
+        }
+
+        const auto [callback, data] = instance->completionCallback;
+        if (callback != nullptr) {
+            callback(data, result);
+        }
+    }};
+    return OBJ2VOXEL_ERR_OK;
+}
+
+bool obj2voxel_poll(obj2voxel_instance *instance, obj2voxel_error_t *out_result)
+{
+    VXIO_ASSERT_NOTNULL(instance);
+    if (not instance->asyncCompletion.isTriggered()) {
+        return false;
+    }
+    if (out_result != nullptr) {
+        std::lock_guard<std::mutex> lock{instance->asyncMutex};
+        *out_result = instance->asyncResult;
+    }
+    return true;
+}
+
+bool obj2voxel_wait(obj2voxel_instance *instance, int64_t timeout_ms, obj2voxel_error_t *out_result)
+{
+    VXIO_ASSERT_NOTNULL(instance);
+    if (not instance->asyncThread.joinable()) {
+        return false;
+    }
+    if (timeout_ms < 0) {
+        instance->asyncCompletion.waitUntilTriggered();
+    }
+    else if (not instance->asyncCompletion.waitFor(std::chrono::milliseconds{timeout_ms})) {
+        return false;
+    }
+    return obj2voxel_poll(instance, out_result);
+}
+
+void obj2voxel_set_completion_callback(obj2voxel_instance *instance,
+                                       obj2voxel_completion_callback *callback,
+                                       void *callback_data)
+{
+    VXIO_ASSERT_NOTNULL(instance);
+    instance->completionCallback = {callback, callback_data};
+}
+
+int obj2voxel_get_completion_fd(obj2voxel_instance *instance)
+{
+    VXIO_ASSERT_NOTNULL(instance);
+    std::lock_guard<std::mutex> lock{instance->asyncMutex};
+    if (instance->completionNotifier == nullptr) {
+        instance->completionNotifier = std::make_unique<obj2voxel::Notifier>();
+        // the voxelization may have completed before anyone asked for the descriptor
+        if (instance->asyncCompletion.isTriggered()) {
+            instance->completionNotifier->notify();
+        }
+    }
+    return instance->completionNotifier->fd();
+}
+
 void obj2voxel_run_worker(obj2voxel_instance *instance)
 {
     VXIO_ASSERT_NOTNULL(instance);
@@ -967,17 +2447,35 @@ void obj2voxel_run_worker(obj2voxel_instance *instance)
         ++instance->workerCount;
     }
 
-    Voxelizer voxelizer{instance->colorStrategy};
+    // Workers are usually started before the instance is configured, so the voxelizer is created on the first chunk.
+    std::optional<Voxelizer> voxelizer;
 
     VXIO_LOG(DEBUG, "VoxelizerThread " + voxelio::stringify(std::this_thread::get_id()) + " started");
     bool looping = true;
     do {
         WorkerCommand command = instance->queue.receive();
         switch (command.type) {
-        case CommandType::FIND_MESH_BOUNDS: findMeshBounds(*instance, command.index); break;
-        case CommandType::TRANSFORM_TRIANGLES: applyMeshTransform(*instance, command.index); break;
-        case CommandType::VOXELIZE_CHUNK: voxelizeChunk(*instance, voxelizer, command.index); break;
-        case CommandType::SORT_TRIANGLE_INTO_CHUNKS: sortTriangleIntoChunks(*instance, command.index); break;
+        case CommandType::FIND_MESH_BOUNDS: findMeshBounds(*instance, static_cast<u32>(command.index)); break;
+        case CommandType::TRANSFORM_TRIANGLES: applyMeshTransform(*instance, static_cast<u32>(command.index)); break;
+        case CommandType::VOXELIZE_CHUNK: {
+            if (not voxelizer.has_value()) {
+                voxelizer.emplace(instance->colorStrategy,
+                                  instance->topology,
+                                  instance->attribute,
+                                  instance->normalSink != nullptr,
+                                  instance->alphaCutoff);
+            }
+            voxelizeChunk(*instance, *voxelizer, command.index);
+            break;
+        }
+        case CommandType::TRANSFORM_DISTANCE_LINES:
+            instance->distanceGrid->transformLines(instance->distanceAxis, command.index, SDF_LINE_BATCH_SIZE);
+            break;
+        case CommandType::POST_PROCESS_CHUNK: instance->postProcessor->processChunk(command.index); break;
+        case CommandType::BIN_CHUNK_RANGE:
+            binChunkRange(*instance, static_cast<u32>(command.index));
+            instance->chunkRangesBinned[command.index].trigger();
+            break;
         case CommandType::EXIT: looping = false; break;
         }
         instance->queue.complete();
@@ -0,0 +1,90 @@
+#ifndef OBJ2VOXEL_PAGEDVECTOR_HPP
+#define OBJ2VOXEL_PAGEDVECTOR_HPP
+
+#include "voxelio/assert.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace obj2voxel {
+
+/**
+ * @brief A vector which stores its elements in fixed-size pages instead of one contiguous allocation.
+ * Elements never move once they are pushed, growing never copies existing elements and single pages can be released
+ * while the rest of the vector remains accessible.
+ * Accessing an element of a released page is undefined behavior.
+ */
+template <typename T, std::size_t PAGE_SIZE>
+class PagedVector {
+public:
+    static constexpr std::size_t pageSize = PAGE_SIZE;
+
+private:
+    std::vector<std::unique_ptr<T[]>> pages;
+    std::size_t size_ = 0;
+
+public:
+    T &operator[](std::size_t index) noexcept
+    {
+        VXIO_DEBUG_ASSERT_LT(index, size_);
+        VXIO_DEBUG_ASSERT_NOTNULL(pages[index / PAGE_SIZE]);
+        return pages[index / PAGE_SIZE][index % PAGE_SIZE];
+    }
+
+    const T &operator[](std::size_t index) const noexcept
+    {
+        VXIO_DEBUG_ASSERT_LT(index, size_);
+        VXIO_DEBUG_ASSERT_NOTNULL(pages[index / PAGE_SIZE]);
+        return pages[index / PAGE_SIZE][index % PAGE_SIZE];
+    }
+
+    void push_back(const T &value)
+    {
+        if (size_ % PAGE_SIZE == 0) {
+            pages.push_back(std::make_unique<T[]>(PAGE_SIZE));
+        }
+        ++size_;
+        (*this)[size_ - 1] = value;
+    }
+
+    /// Shrinks the vector to the given size, which frees all pages past the new end.
+    void truncate(std::size_t size) noexcept
+    {
+        VXIO_DEBUG_ASSERT_LE(size, size_);
+        size_ = size;
+        pages.resize((size + PAGE_SIZE - 1) / PAGE_SIZE);
+    }
+
+    /// Frees the page with the given index while keeping the indices of all other elements intact.
+    void releasePage(std::size_t page) noexcept
+    {
+        VXIO_DEBUG_ASSERT_LT(page, pages.size());
+        pages[page].reset();
+    }
+
+    void clear() noexcept
+    {
+        pages.clear();
+        size_ = 0;
+    }
+
+    std::size_t size() const noexcept
+    {
+        return size_;
+    }
+
+    std::size_t pageCount() const noexcept
+    {
+        return pages.size();
+    }
+
+    bool empty() const noexcept
+    {
+        return size_ == 0;
+    }
+};
+
+}  // namespace obj2voxel
+
+#endif  // OBJ2VOXEL_PAGEDVECTOR_HPP
@@ -0,0 +1,61 @@
+#include "pipes.hpp"
+
+#include "constants.hpp"
+
+#include <cerrno>
+#include <cstdio>
+
+#if defined(_WIN32)
+#define OBJ2VOXEL_PIPES_WINDOWS
+#include <fcntl.h>
+#include <io.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#define OBJ2VOXEL_PIPES_POSIX
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace obj2voxel {
+
+void enlargePipe([[maybe_unused]] int fd) noexcept
+{
+#ifdef F_SETPIPE_SZ
+    // this fails for anything but pipes and for sizes beyond the system limit, in which case the pipe is kept as is
+    ::fcntl(fd, F_SETPIPE_SZ, static_cast<int>(PIPE_BUFFER_SIZE));
+#endif
+}
+
+StdinBuffer::StdinBuffer() : buffer{new char[PIPE_BUFFER_SIZE]}
+{
+#if defined(OBJ2VOXEL_PIPES_POSIX)
+    enlargePipe(STDIN_FILENO);
+#elif defined(OBJ2VOXEL_PIPES_WINDOWS)
+    // standard input is opened in text mode on Windows, which would corrupt binary files
+    _setmode(_fileno(stdin), _O_BINARY);
+#endif
+    setg(buffer.get(), buffer.get(), buffer.get());
+}
+
+StdinBuffer::int_type StdinBuffer::underflow()
+{
+    if (gptr() != egptr()) {
+        return traits_type::to_int_type(*gptr());
+    }
+
+#ifdef OBJ2VOXEL_PIPES_POSIX
+    std::streamsize size;
+    do {
+        size = static_cast<std::streamsize>(::read(STDIN_FILENO, buffer.get(), PIPE_BUFFER_SIZE));
+    } while (size < 0 && errno == EINTR);
+#else
+    const auto size = static_cast<std::streamsize>(std::fread(buffer.get(), 1, PIPE_BUFFER_SIZE, stdin));
+#endif
+    if (size <= 0) {
+        return traits_type::eof();
+    }
+
+    setg(buffer.get(), buffer.get(), buffer.get() + size);
+    return traits_type::to_int_type(*gptr());
+}
+
+}  // namespace obj2voxel
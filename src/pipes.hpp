@@ -0,0 +1,42 @@
+#ifndef OBJ2VOXEL_PIPES_HPP
+#define OBJ2VOXEL_PIPES_HPP
+
+#include <memory>
+#include <streambuf>
+#include <string>
+
+namespace obj2voxel {
+
+/// The path which stands for standard input when reading and for standard output when writing.
+constexpr const char *STDIO_PATH = "-";
+
+inline bool isStdioPath(const std::string &path) noexcept
+{
+    return path == STDIO_PATH;
+}
+
+/**
+ * @brief Raises the capacity of a pipe to PIPE_BUFFER_SIZE, so that both ends of the pipe block less often.
+ * Nothing happens if the file descriptor is not a pipe or if the platform doesn't support resizing pipes.
+ * @param fd the file descriptor
+ */
+void enlargePipe(int fd) noexcept;
+
+/**
+ * @brief A stream buffer which reads standard input in blocks of PIPE_BUFFER_SIZE.
+ * If standard input is a pipe, its capacity is raised as well.
+ */
+class StdinBuffer final : public std::streambuf {
+private:
+    std::unique_ptr<char[]> buffer;
+
+public:
+    StdinBuffer();
+
+protected:
+    int_type underflow() final;
+};
+
+}  // namespace obj2voxel
+
+#endif  // OBJ2VOXEL_PIPES_HPP
@@ -0,0 +1,571 @@
+#include "io.hpp"
+#include "mappedfile.hpp"
+
+#include "voxelio/log.hpp"
+#include "voxelio/stringify.hpp"
+#include "voxelio/stringmanip.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <limits>
+#include <string_view>
+
+namespace obj2voxel {
+namespace {
+
+// PLY HEADER ==========================================================================================================
+
+enum class PlyType : u8 { NONE, INT8, UINT8, INT16, UINT16, INT32, UINT32, FLOAT32, FLOAT64 };
+
+constexpr usize sizeOf(PlyType type) noexcept
+{
+    switch (type) {
+    case PlyType::NONE: return 0;
+    case PlyType::INT8:
+    case PlyType::UINT8: return 1;
+    case PlyType::INT16:
+    case PlyType::UINT16: return 2;
+    case PlyType::INT32:
+    case PlyType::UINT32:
+    case PlyType::FLOAT32: return 4;
+    case PlyType::FLOAT64: return 8;
+    }
+    VXIO_DEBUG_ASSERT_UNREACHABLE();
+}
+
+/// Returns the largest value of an unsigned integer type or one for other types.
+/// This is used to normalize color properties to [0, 1].
+constexpr double normalizationDivisorOf(PlyType type) noexcept
+{
+    switch (type) {
+    case PlyType::UINT8: return std::numeric_limits<u8>::max();
+    case PlyType::UINT16: return std::numeric_limits<u16>::max();
+    case PlyType::UINT32: return std::numeric_limits<u32>::max();
+    default: return 1;
+    }
+}
+
+PlyType plyTypeOf(std::string_view name) noexcept
+{
+    if (name == "char" || name == "int8") return PlyType::INT8;
+    if (name == "uchar" || name == "uint8") return PlyType::UINT8;
+    if (name == "short" || name == "int16") return PlyType::INT16;
+    if (name == "ushort" || name == "uint16") return PlyType::UINT16;
+    if (name == "int" || name == "int32") return PlyType::INT32;
+    if (name == "uint" || name == "uint32") return PlyType::UINT32;
+    if (name == "float" || name == "float32") return PlyType::FLOAT32;
+    if (name == "double" || name == "float64") return PlyType::FLOAT64;
+    return PlyType::NONE;
+}
+
+struct PlyProperty {
+    std::string name;
+    /// The type of the property or the type of list elements.
+    PlyType type;
+    /// The type of the list size or NONE if the property is not a list.
+    PlyType countType;
+    /// The byte offset within the element. Only meaningful for elements without list properties.
+    usize offset;
+
+    bool isList() const noexcept
+    {
+        return countType != PlyType::NONE;
+    }
+};
+
+struct PlyElement {
+    std::string name;
+    usize count;
+    std::vector<PlyProperty> properties;
+    /// The size of one element in bytes or zero if the element contains lists and has no fixed size.
+    usize fixedSize = 0;
+    /// The location of the first element in the file.
+    const u8 *data = nullptr;
+
+    const PlyProperty *find(std::initializer_list<std::string_view> names) const noexcept
+    {
+        for (const PlyProperty &property : properties) {
+            for (std::string_view name : names) {
+                if (property.name == name) {
+                    return &property;
+                }
+            }
+        }
+        return nullptr;
+    }
+};
+
+/// Reads a scalar of any PLY type and converts it to double.
+inline double readPlyScalar(const u8 *bytes, PlyType type, bool bigEndian) noexcept
+{
+    // clang-format off
+    switch (type) {
+    case PlyType::NONE: break;
+    case PlyType::INT8: return static_cast<i8>(*bytes);
+    case PlyType::UINT8: return *bytes;
+    case PlyType::INT16: return bigEndian ? decodeBig<i16>(bytes) : decodeLittle<i16>(bytes);
+    case PlyType::UINT16: return bigEndian ? decodeBig<u16>(bytes) : decodeLittle<u16>(bytes);
+    case PlyType::INT32: return bigEndian ? decodeBig<i32>(bytes) : decodeLittle<i32>(bytes);
+    case PlyType::UINT32: return bigEndian ? decodeBig<u32>(bytes) : decodeLittle<u32>(bytes);
+    case PlyType::FLOAT32: return bigEndian ? decodeBig<f32>(bytes) : decodeLittle<f32>(bytes);
+    case PlyType::FLOAT64: return bigEndian ? decodeBig<f64>(bytes) : decodeLittle<f64>(bytes);
+    }
+    // clang-format on
+    VXIO_DEBUG_ASSERT_UNREACHABLE();
+}
+
+/// Reads an integer of any PLY type. Negative and floating point values are returned as the maximum u64.
+inline u64 readPlyIndex(const u8 *bytes, PlyType type, bool bigEndian) noexcept
+{
+    const double value = readPlyScalar(bytes, type, bigEndian);
+    return value >= 0 ? static_cast<u64>(value) : std::numeric_limits<u64>::max();
+}
+
+struct PlyHeader {
+    std::vector<PlyElement> elements;
+    std::string textureFile;
+    bool bigEndian = false;
+    /// The offset of the first byte after "end_header".
+    usize bodyOffset = 0;
+};
+
+/// Parses the ASCII header of a PLY file. Returns an error message or an empty string on success.
+std::string parsePlyHeader(const u8 *data, usize size, PlyHeader &out)
+{
+    const std::string_view file{reinterpret_cast<const char *>(data), size};
+    if (file.substr(0, 3) != "ply") {
+        return "File does not start with \"ply\" magic bytes";
+    }
+
+    usize lineStart = 0;
+    while (true) {
+        const usize lineEnd = file.find('\n', lineStart);
+        if (lineEnd == std::string_view::npos) {
+            return "Header is not terminated by \"end_header\"";
+        }
+        std::string line{file.substr(lineStart, lineEnd - lineStart)};
+        lineStart = lineEnd + 1;
+        trim(line);
+
+        std::vector<std::string> tokens = splitAtDelimiter(line, ' ');
+        tokens.erase(std::remove(tokens.begin(), tokens.end(), std::string{}), tokens.end());
+        if (tokens.empty()) {
+            continue;
+        }
+        const std::string &keyword = tokens[0];
+
+        if (keyword == "end_header") {
+            out.bodyOffset = lineStart;
+            return {};
+        }
+        else if (keyword == "format") {
+            if (tokens.size() < 2) {
+                return "Incomplete format line";
+            }
+            if (tokens[1] == "binary_little_endian") {
+                out.bigEndian = false;
+            }
+            else if (tokens[1] == "binary_big_endian") {
+                out.bigEndian = true;
+            }
+            else {
+                return "Unsupported PLY format \"" + tokens[1] + "\" (only binary PLY is supported)";
+            }
+        }
+        else if (keyword == "comment") {
+            // MeshLab and other tools reference textures using "comment TextureFile <path>"
+            constexpr std::string_view textureKeyword = "TextureFile";
+            if (tokens.size() >= 3 && tokens[1] == textureKeyword) {
+                out.textureFile = line.substr(line.find(textureKeyword) + textureKeyword.size());
+                trim(out.textureFile);
+            }
+        }
+        else if (keyword == "element") {
+            if (tokens.size() != 3) {
+                return "Malformed element line \"" + line + '"';
+            }
+            usize count = 0;
+            const std::string &countStr = tokens[2];
+            auto [end, errc] = std::from_chars(countStr.data(), countStr.data() + countStr.size(), count);
+            if (errc != std::errc{} || end != countStr.data() + countStr.size()) {
+                return "Malformed element count \"" + countStr + '"';
+            }
+            out.elements.push_back({tokens[1], count, {}});
+        }
+        else if (keyword == "property") {
+            if (out.elements.empty()) {
+                return "Property declared outside of element";
+            }
+            PlyProperty property{};
+            if (tokens.size() == 5 && tokens[1] == "list") {
+                property.countType = plyTypeOf(tokens[2]);
+                property.type = plyTypeOf(tokens[3]);
+                property.name = tokens[4];
+                if (property.countType == PlyType::NONE || property.type == PlyType::NONE) {
+                    return "Unknown type in list property \"" + line + '"';
+                }
+            }
+            else if (tokens.size() == 3) {
+                property.countType = PlyType::NONE;
+                property.type = plyTypeOf(tokens[1]);
+                property.name = tokens[2];
+                if (property.type == PlyType::NONE) {
+                    return "Unknown type in property \"" + line + '"';
+                }
+            }
+            else {
+                return "Malformed property line \"" + line + '"';
+            }
+            out.elements.back().properties.push_back(std::move(property));
+        }
+        else if (keyword != "obj_info" && keyword != "ply") {
+            return "Unknown header keyword \"" + keyword + '"';
+        }
+    }
+}
+
+/// Computes property offsets and fixed sizes of elements and locates the data of each element in the file body.
+/// Elements with list properties have to be walked because they have no fixed size.
+/// Returns an error message or an empty string on success.
+std::string locatePlyElements(const u8 *data, usize size, PlyHeader &header)
+{
+    const u8 *cursor = data + header.bodyOffset;
+    const u8 *const end = data + size;
+
+    for (PlyElement &element : header.elements) {
+        bool hasLists = false;
+        usize offset = 0;
+        for (PlyProperty &property : element.properties) {
+            property.offset = offset;
+            offset += sizeOf(property.type);
+            hasLists |= property.isList();
+        }
+        element.fixedSize = hasLists ? 0 : offset;
+        element.data = cursor;
+
+        if (not hasLists) {
+            if (element.fixedSize != 0 && usize(end - cursor) / element.fixedSize < element.count) {
+                return "Unexpected end of file in element \"" + element.name + '"';
+            }
+            cursor += element.fixedSize * element.count;
+            continue;
+        }
+
+        for (usize i = 0; i < element.count; ++i) {
+            for (const PlyProperty &property : element.properties) {
+                const usize countSize = sizeOf(property.countType);
+                if (usize(end - cursor) < countSize) {
+                    return "Unexpected end of file in element \"" + element.name + '"';
+                }
+                usize listSize = 1;
+                if (property.isList()) {
+                    listSize = readPlyIndex(cursor, property.countType, header.bigEndian);
+                    cursor += countSize;
+                }
+                // negative list sizes are read as the maximum u64, so the product could overflow
+                if (usize(end - cursor) / sizeOf(property.type) < listSize) {
+                    return "Unexpected end of file in element \"" + element.name + '"';
+                }
+                cursor += listSize * sizeOf(property.type);
+            }
+        }
+    }
+
+    return {};
+}
+
+// PLY TRIANGLE STREAM =================================================================================================
+
+/// Triangle stream which reads vertex and face data directly from the memory-mapped file.
+struct PlyTriangleStream final : public ITriangleStream {
+private:
+    MappedFile file;
+    std::optional<Texture> texture;
+    bool bigEndian;
+
+    const PlyElement vertices;
+    const PlyElement faces;
+
+    const PlyProperty *position[3];
+    const PlyProperty *uv[2];
+    const PlyProperty *color[3];
+    const PlyProperty *faceIndices;
+    const PlyProperty *faceTexcoords;
+
+    const u8 *faceCursor;
+    usize facesLeft;
+
+    // current face being triangulated as a fan
+    const u8 *cornerIndices = nullptr;
+    const u8 *cornerTexcoords = nullptr;
+    usize cornerCount = 0;
+    usize fanIndex = 0;
+
+public:
+    PlyTriangleStream(MappedFile file,
+                      std::optional<Texture> texture,
+                      const PlyHeader &header,
+                      usize vertexElement,
+                      usize faceElement) noexcept;
+
+    bool next(VisualTriangle &out) noexcept final;
+
+private:
+    /// Advances to the next face with at least three corners. Returns false if there are no more faces.
+    bool nextFace() noexcept;
+
+    Vec3 positionOf(u64 vertex) const noexcept
+    {
+        const u8 *base = vertices.data + vertex * vertices.fixedSize;
+        Vec3 result;
+        for (usize i = 0; i < 3; ++i) {
+            result[i] = static_cast<real_type>(readPlyScalar(base + position[i]->offset, position[i]->type, bigEndian));
+        }
+        return result;
+    }
+
+    Vec2f uvOf(u64 vertex, usize corner) const noexcept
+    {
+        if (cornerTexcoords != nullptr) {
+            const usize elementSize = sizeOf(faceTexcoords->type);
+            const u8 *base = cornerTexcoords + corner * 2 * elementSize;
+            return {static_cast<float>(readPlyScalar(base, faceTexcoords->type, bigEndian)),
+                    static_cast<float>(readPlyScalar(base + elementSize, faceTexcoords->type, bigEndian))};
+        }
+        const u8 *base = vertices.data + vertex * vertices.fixedSize;
+        return {static_cast<float>(readPlyScalar(base + uv[0]->offset, uv[0]->type, bigEndian)),
+                static_cast<float>(readPlyScalar(base + uv[1]->offset, uv[1]->type, bigEndian))};
+    }
+
+    Vec3f colorOf(u64 vertex) const noexcept
+    {
+        const u8 *base = vertices.data + vertex * vertices.fixedSize;
+        Vec3f result;
+        for (usize i = 0; i < 3; ++i) {
+            const double value = readPlyScalar(base + color[i]->offset, color[i]->type, bigEndian);
+            result[i] = static_cast<float>(value / normalizationDivisorOf(color[i]->type));
+        }
+        return result;
+    }
+
+    u64 cornerIndex(usize corner) const noexcept
+    {
+        const u8 *base = cornerIndices + corner * sizeOf(faceIndices->type);
+        return readPlyIndex(base, faceIndices->type, bigEndian);
+    }
+};
+
+PlyTriangleStream::PlyTriangleStream(MappedFile file,
+                                     std::optional<Texture> texture,
+                                     const PlyHeader &header,
+                                     usize vertexElement,
+                                     usize faceElement) noexcept
+    : file{std::move(file)}
+    , texture{std::move(texture)}
+    , bigEndian{header.bigEndian}
+    , vertices{header.elements[vertexElement]}
+    , faces{header.elements[faceElement]}
+    , faceCursor{faces.data}
+    , facesLeft{faces.count}
+{
+    // these point into our own copies of the elements, not into the header
+    position[0] = vertices.find({"x"});
+    position[1] = vertices.find({"y"});
+    position[2] = vertices.find({"z"});
+    uv[0] = vertices.find({"u", "s", "texture_u", "texture_s"});
+    uv[1] = vertices.find({"v", "t", "texture_v", "texture_t"});
+    color[0] = vertices.find({"red", "r", "diffuse_red"});
+    color[1] = vertices.find({"green", "g", "diffuse_green"});
+    color[2] = vertices.find({"blue", "b", "diffuse_blue"});
+    faceIndices = faces.find({"vertex_indices", "vertex_index"});
+    faceTexcoords = faces.find({"texcoord"});
+
+    if (uv[0] == nullptr || uv[1] == nullptr) {
+        uv[0] = uv[1] = nullptr;
+    }
+    if (color[0] == nullptr || color[1] == nullptr || color[2] == nullptr) {
+        color[0] = nullptr;
+    }
+    if (faceTexcoords != nullptr && not faceTexcoords->isList()) {
+        faceTexcoords = nullptr;
+    }
+}
+
+bool PlyTriangleStream::nextFace() noexcept
+{
+    while (facesLeft != 0) {
+        --facesLeft;
+        cornerIndices = nullptr;
+        cornerTexcoords = nullptr;
+        cornerCount = 0;
+        fanIndex = 0;
+
+        // bounds have already been checked by locatePlyElements()
+        for (const PlyProperty &property : faces.properties) {
+            usize listSize = 1;
+            if (property.isList()) {
+                listSize = readPlyIndex(faceCursor, property.countType, bigEndian);
+                faceCursor += sizeOf(property.countType);
+            }
+            if (&property == faceIndices) {
+                cornerIndices = faceCursor;
+                cornerCount = listSize;
+            }
+            else if (&property == faceTexcoords && listSize != 0) {
+                cornerTexcoords = faceCursor;
+            }
+            faceCursor += listSize * sizeOf(property.type);
+        }
+
+        if (cornerCount >= 3) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool PlyTriangleStream::next(VisualTriangle &triangle) noexcept
+{
+    if (fanIndex + 2 >= cornerCount && not nextFace()) {
+        return false;
+    }
+
+    // faces with more than three corners are triangulated as a fan around the first corner
+    const usize corners[3]{0, fanIndex + 1, fanIndex + 2};
+    ++fanIndex;
+
+    const bool hasUv = uv[0] != nullptr || cornerTexcoords != nullptr;
+    Vec3f colorSum = Vec3f::zero();
+
+    for (usize i = 0; i < 3; ++i) {
+        const u64 vertex = cornerIndex(corners[i]);
+        VXIO_DEBUG_ASSERT_LT(vertex, vertices.count);
+        triangle.v[i] = positionOf(vertex);
+        triangle.t[i] = hasUv ? uvOf(vertex, corners[i]) : Vec2f{};
+        if (color[0] != nullptr) {
+            colorSum += colorOf(vertex);
+        }
+    }
+
+    if (hasUv && texture.has_value()) {
+        triangle.type = TriangleType::TEXTURED;
+        triangle.texture = &*texture;
+    }
+    else if (color[0] != nullptr) {
+        triangle.type = TriangleType::UNTEXTURED;
+        triangle.color = colorSum / 3.f;
+    }
+    else {
+        triangle.type = TriangleType::MATERIALLESS;
+    }
+    return true;
+}
+
+/// Checks that all face indices are in range and that every non-empty texcoord list has two values per corner, so
+/// that the stream never has to.
+bool validatePlyFaces(const PlyHeader &header, const PlyElement &faces, const PlyProperty &indices, usize vertexCount)
+{
+    const PlyProperty *texcoords = faces.find({"texcoord"});
+    const u8 *cursor = faces.data;
+    for (usize i = 0; i < faces.count; ++i) {
+        usize cornerCount = 0;
+        usize texcoordCount = 0;
+        for (const PlyProperty &property : faces.properties) {
+            usize listSize = 1;
+            if (property.isList()) {
+                listSize = readPlyIndex(cursor, property.countType, header.bigEndian);
+                cursor += sizeOf(property.countType);
+            }
+            if (&property == texcoords && property.isList()) {
+                texcoordCount = listSize;
+            }
+            if (&property == &indices) {
+                cornerCount = listSize;
+                for (usize j = 0; j < listSize; ++j) {
+                    const u64 index = readPlyIndex(cursor + j * sizeOf(property.type), property.type, header.bigEndian);
+                    if (index >= vertexCount) {
+                        VXIO_LOG(ERROR,
+                                 "Face " + stringifyLargeInt(i) + " references vertex " + stringifyLargeInt(index) +
+                                     " but there are only " + stringifyLargeInt(vertexCount) + " vertices");
+                        return false;
+                    }
+                }
+            }
+            cursor += listSize * sizeOf(property.type);
+        }
+        if (texcoordCount != 0 && texcoordCount != 2 * cornerCount) {
+            VXIO_LOG(ERROR,
+                     "Face " + stringifyLargeInt(i) + " has " + stringifyLargeInt(cornerCount) + " corners but " +
+                         stringifyLargeInt(texcoordCount) + " texture coordinates");
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+std::unique_ptr<ITriangleStream> ITriangleStream::fromPlyFile(const std::string &inFile) noexcept
+{
+    std::optional<MappedFile> file = MappedFile::open(inFile);
+    if (not file.has_value()) {
+        VXIO_LOG(ERROR, "Failed to open PLY file: \"" + inFile + "\"");
+        return nullptr;
+    }
+
+    PlyHeader header;
+    std::string error = parsePlyHeader(file->data(), file->size(), header);
+    if (error.empty()) {
+        error = locatePlyElements(file->data(), file->size(), header);
+    }
+    if (not error.empty()) {
+        VXIO_LOG(ERROR, "Failed to read PLY file \"" + inFile + "\": " + error);
+        return nullptr;
+    }
+
+    usize vertexElement = header.elements.size();
+    usize faceElement = header.elements.size();
+    for (usize i = 0; i < header.elements.size(); ++i) {
+        if (header.elements[i].name == "vertex") vertexElement = i;
+        if (header.elements[i].name == "face") faceElement = i;
+    }
+    if (vertexElement == header.elements.size() || faceElement == header.elements.size()) {
+        VXIO_LOG(ERROR, "PLY file must contain a vertex and a face element (point clouds can't be voxelized)");
+        return nullptr;
+    }
+
+    const PlyElement &vertices = header.elements[vertexElement];
+    const PlyElement &faces = header.elements[faceElement];
+    if (vertices.fixedSize == 0) {
+        VXIO_LOG(ERROR, "PLY vertex element must not contain list properties");
+        return nullptr;
+    }
+    for (const char *axis : {"x", "y", "z"}) {
+        if (vertices.find({axis}) == nullptr) {
+            VXIO_LOG(ERROR, "PLY vertex element is missing property \"" + std::string{axis} + '"');
+            return nullptr;
+        }
+    }
+    const PlyProperty *indices = faces.find({"vertex_indices", "vertex_index"});
+    if (indices == nullptr || not indices->isList()) {
+        VXIO_LOG(ERROR, "PLY face element has no vertex_indices list");
+        return nullptr;
+    }
+    if (not validatePlyFaces(header, faces, *indices, vertices.count)) {
+        return nullptr;
+    }
+
+    std::optional<Texture> texture;
+    if (not header.textureFile.empty()) {
+        texture = loadTexture(resolveReferencedPath(inFile, header.textureFile), "PLY");
+    }
+
+    VXIO_LOG(INFO,
+             "Mapped PLY file with " + stringifyLargeInt(vertices.count) + " vertices and " +
+                 stringifyLargeInt(faces.count) + " faces");
+
+    return std::unique_ptr<ITriangleStream>{
+        new PlyTriangleStream{std::move(*file), std::move(texture), header, vertexElement, faceElement}};
+}
+
+}  // namespace obj2voxel
@@ -0,0 +1,580 @@
+#include "postprocess.hpp"
+
+#include "voxelio/assert.hpp"
+
+#include <array>
+#include <cstdlib>
+
+namespace obj2voxel {
+
+namespace {
+
+/// Returns the index of the lowest set bit of a non-zero word.
+u32 lowestSetBit(u64 word) noexcept
+{
+#ifdef __GNUC__
+    return static_cast<u32>(__builtin_ctzll(word));
+#else
+    u32 result = 0;
+    for (; (word & 1) == 0; word >>= 1) {
+        ++result;
+    }
+    return result;
+#endif
+}
+
+/// Returns a word where the bits in the inclusive range [low, high] are set.
+constexpr u64 bitRange(u32 low, u32 high) noexcept
+{
+    return (high == 63 ? ~u64{0} : (u64{1} << (high + 1)) - 1) & ~((u64{1} << low) - 1);
+}
+
+/// Returns the 26 offsets to the neighbors of a voxel, ordered by Manhattan distance.
+/// New voxels of a dilation take the value and normal of the first solid neighbor in this order, which is one of the
+/// closest.
+const std::array<Vec3i32, 26> &neighborOffsets()
+{
+    static const std::array<Vec3i32, 26> result = [] {
+        std::array<Vec3i32, 26> offsets{};
+        usize i = 0;
+        for (i32 distance = 1; distance <= 3; ++distance) {
+            for (i32 z = -1; z <= 1; ++z) {
+                for (i32 y = -1; y <= 1; ++y) {
+                    for (i32 x = -1; x <= 1; ++x) {
+                        if (std::abs(x) + std::abs(y) + std::abs(z) == distance) {
+                            offsets[i++] = {x, y, z};
+                        }
+                    }
+                }
+            }
+        }
+        return offsets;
+    }();
+    return result;
+}
+
+}  // namespace
+
+ChunkPostProcessor::ChunkPostProcessor(u32 resolution, u32 chunkSize)
+    : resolution{resolution}
+    , chunkSize{chunkSize}
+    , chunksPerAxis{divCeil(resolution, chunkSize)}
+    , rowMask{chunkSize == 64 ? ~u64{0} : (u64{1} << chunkSize) - 1}
+{
+    VXIO_ASSERT_NE(chunkSize, 0u);
+    VXIO_ASSERT_LE(chunkSize, 64u);
+}
+
+void ChunkPostProcessor::insert(u64 chunkIndex, const Voxel32 *voxels, const Voxel32 *normals, usize count)
+{
+    if (count == 0) {
+        return;
+    }
+    Vec3u32 chunkPos;
+    dileave3(chunkIndex, chunkPos.data());
+    const Vec3i32 origin = (chunkPos * chunkSize).cast<i32>();
+
+    DenseChunk chunk;
+    chunk.rows.resize(usize{chunkSize} * chunkSize);
+    chunk.voxels.reserve(count);
+    for (usize i = 0; i < count; ++i) {
+        const Vec3u32 local = (voxels[i].pos - origin).cast<u32>();
+        VXIO_DEBUG_ASSERT(local.x() < chunkSize && local.y() < chunkSize && local.z() < chunkSize);
+        const u32 row = local.y() + local.z() * chunkSize;
+        chunk.rows[row] |= u64{1} << local.x();
+        chunk.voxels.push_back({row * chunkSize + local.x(), voxels[i].argb, 0});
+    }
+    const auto indexLess = [](const LocalVoxel &voxel, u32 index) {
+        return voxel.index < index;
+    };
+    std::sort(chunk.voxels.begin(), chunk.voxels.end(), [](const LocalVoxel &lhs, const LocalVoxel &rhs) {
+        return lhs.index < rhs.index;
+    });
+    for (usize i = 0; normals != nullptr && i < count; ++i) {
+        const Vec3u32 local = (normals[i].pos - origin).cast<u32>();
+        const u32 index = (local.y() + local.z() * chunkSize) * chunkSize + local.x();
+        const auto location = std::lower_bound(chunk.voxels.begin(), chunk.voxels.end(), index, indexLess);
+        VXIO_DEBUG_ASSERT(location != chunk.voxels.end() && location->index == index);
+        location->normal = normals[i].argb;
+    }
+
+    std::lock_guard<std::mutex> lock{mutex};
+    const bool inserted = chunks.emplace(chunkIndex, std::move(chunk)).second;
+    VXIO_ASSERT(inserted);
+}
+
+const ChunkPostProcessor::DenseChunk *ChunkPostProcessor::findNeighbor(Vec3u32 chunkPos,
+                                                                       Vec3i32 offset) const noexcept
+{
+    const Vec3i32 pos = chunkPos.cast<i32>() + offset;
+    for (usize i = 0; i < 3; ++i) {
+        if (pos[i] < 0 || static_cast<u32>(pos[i]) >= chunksPerAxis) {
+            return nullptr;
+        }
+    }
+    const auto location = chunks.find(ileave3(static_cast<u32>(pos.x()), //
+                                              static_cast<u32>(pos.y()),
+                                              static_cast<u32>(pos.z())));
+    return location == chunks.end() ? nullptr : &location->second;
+}
+
+usize ChunkPostProcessor::beginPass(Pass type)
+{
+    pass = type;
+
+    if (pass == Pass::DILATE) {
+        // Dilation can grow into neighbors which don't exist yet, but only across faces which have solid voxels.
+        std::vector<u64> grownChunks;
+        for (const auto &[chunkIndex, chunk] : chunks) {
+            bool touchesLow[3]{}, touchesHigh[3]{};
+            for (u32 z = 0; z < chunkSize; ++z) {
+                for (u32 y = 0; y < chunkSize; ++y) {
+                    const u64 row = chunk.rows[y + z * chunkSize];
+                    if (row == 0) {
+                        continue;
+                    }
+                    touchesLow[0] |= (row & 1) != 0;
+                    touchesHigh[0] |= (row >> (chunkSize - 1) & 1) != 0;
+                    touchesLow[1] |= y == 0;
+                    touchesHigh[1] |= y == chunkSize - 1;
+                    touchesLow[2] |= z == 0;
+                    touchesHigh[2] |= z == chunkSize - 1;
+                }
+            }
+
+            Vec3u32 chunkPos;
+            dileave3(chunkIndex, chunkPos.data());
+            for (const Vec3i32 &offset : neighborOffsets()) {
+                bool reachable = true;
+                for (usize i = 0; i < 3; ++i) {
+                    reachable &= offset[i] == 0 || (offset[i] < 0 ? touchesLow[i] : touchesHigh[i]);
+                    reachable &= offset[i] >= 0 || chunkPos[i] != 0;
+                    reachable &= offset[i] <= 0 || chunkPos[i] + 1 < chunksPerAxis;
+                }
+                if (reachable) {
+                    const Vec3u32 neighbor = (chunkPos.cast<i32>() + offset).cast<u32>();
+                    grownChunks.push_back(ileave3(neighbor.x(), neighbor.y(), neighbor.z()));
+                }
+            }
+        }
+        for (u64 chunkIndex : grownChunks) {
+            if (chunks.count(chunkIndex) == 0) {
+                chunks[chunkIndex].rows.resize(usize{chunkSize} * chunkSize);
+            }
+        }
+    }
+
+    passChunks.clear();
+    for (const auto &entry : chunks) {
+        passChunks.push_back(entry.first);
+    }
+    std::sort(passChunks.begin(), passChunks.end());
+    return passChunks.size();
+}
+
+ChunkPostProcessor::Neighborhood ChunkPostProcessor::neighborhoodOf(Vec3u32 chunkPos) const noexcept
+{
+    Neighborhood result;
+    for (i32 z = -1; z <= 1; ++z) {
+        for (i32 y = -1; y <= 1; ++y) {
+            for (i32 x = -1; x <= 1; ++x) {
+                result[static_cast<usize>((x + 1) + (y + 1) * 3 + (z + 1) * 9)] = findNeighbor(chunkPos, {x, y, z});
+            }
+        }
+    }
+    return result;
+}
+
+void ChunkPostProcessor::processChunk(usize index) noexcept
+{
+    const u64 chunkIndex = passChunks[index];
+    DenseChunk &chunk = chunks.find(chunkIndex)->second;
+
+    switch (pass) {
+    case Pass::DILATE:
+    case Pass::ERODE:
+    case Pass::ERODE_CLAMPED: morphChunk(chunkIndex, chunk); break;
+    case Pass::LABEL_RUNS: labelRuns(chunk); break;
+    case Pass::MERGE_RUNS: mergeRuns(chunkIndex, chunk); break;
+    case Pass::MEASURE_COMPONENTS: measureComponents(chunk); break;
+    case Pass::REMOVE_COMPONENTS: removeComponents(chunk); break;
+    }
+}
+
+void ChunkPostProcessor::morphChunk(u64 chunkIndex, DenseChunk &chunk) noexcept
+{
+    Vec3u32 chunkPos;
+    dileave3(chunkIndex, chunkPos.data());
+    const Vec3u32 origin = chunkPos * chunkSize;
+    // the halo of the chunk consists of the rows of all 26 neighbors, which are looked up only once
+    const Neighborhood neighborhood = neighborhoodOf(chunkPos);
+
+    const auto size = static_cast<i32>(chunkSize);
+    // Returns the neighborhood chunk and the index of a row or voxel within it for local coordinates in [-1, size].
+    const auto locate = [&](i32 x, i32 y, i32 z, usize &outIndex) -> const DenseChunk * {
+        const i32 dx = x < 0 ? -1 : x >= size;
+        const i32 dy = y < 0 ? -1 : y >= size;
+        const i32 dz = z < 0 ? -1 : z >= size;
+        outIndex = static_cast<usize>(((z - dz * size) * size + (y - dy * size)) * size + (x - dx * size));
+        return neighborhood[static_cast<usize>((dx + 1) + (dy + 1) * 3 + (dz + 1) * 9)];
+    };
+    const auto rowAt = [&](i32 dx, i32 y, i32 z) -> u64 {
+        usize voxelIndex;
+        const DenseChunk *neighbor = locate(dx * size, y, z, voxelIndex);
+        return neighbor == nullptr ? 0 : neighbor->rows[voxelIndex / chunkSize];
+    };
+    const auto voxelAt = [](const DenseChunk &owner, usize voxelIndex) -> const LocalVoxel & {
+        const auto location = std::lower_bound(
+            owner.voxels.begin(), owner.voxels.end(), voxelIndex, [](const LocalVoxel &voxel, usize i) {
+                return voxel.index < i;
+            });
+        VXIO_DEBUG_ASSERT(location != owner.voxels.end() && location->index == voxelIndex);
+        return *location;
+    };
+
+    const u32 limitX = resolution - origin.x();
+    const u64 columnMask = limitX >= chunkSize ? rowMask : (u64{1} << limitX) - 1;
+
+    // voxels outside the grid are either empty or replicate the closest voxel inside the grid
+    const bool clamped = pass == Pass::ERODE_CLAMPED;
+    const auto clampToGrid = [this](u32 originCoord, i32 local) -> i32 {
+        const i64 global = std::clamp(i64{originCoord} + local, i64{0}, i64{resolution} - 1);
+        return static_cast<i32>(global - originCoord);
+    };
+
+    chunk.nextRows.resize(usize{chunkSize} * chunkSize);
+    chunk.nextVoxels.clear();
+    for (i32 z = 0; z < size; ++z) {
+        for (i32 y = 0; y < size; ++y) {
+            const usize rowIndex = static_cast<usize>(y + z * size);
+            if (origin.y() + static_cast<u32>(y) >= resolution || origin.z() + static_cast<u32>(z) >= resolution) {
+                chunk.nextRows[rowIndex] = 0;
+                continue;
+            }
+
+            u64 result = pass == Pass::DILATE ? 0 : rowMask;
+            for (i32 dz = -1; dz <= 1; ++dz) {
+                for (i32 dy = -1; dy <= 1; ++dy) {
+                    const i32 ny = clamped ? clampToGrid(origin.y(), y + dy) : y + dy;
+                    const i32 nz = clamped ? clampToGrid(origin.z(), z + dz) : z + dz;
+                    const u64 row = rowAt(0, ny, nz);
+                    // the bits shifted in at either end of the row come from the neighbors along the x-axis
+                    u64 fromLeft = row << 1 | (rowAt(-1, ny, nz) >> (chunkSize - 1) & 1);
+                    u64 fromRight = row >> 1 | (rowAt(1, ny, nz) & 1) << (chunkSize - 1);
+                    if (clamped && origin.x() == 0) {
+                        fromLeft |= row & 1;
+                    }
+                    if (clamped && limitX <= chunkSize) {
+                        fromRight |= row & u64{1} << (limitX - 1);
+                    }
+                    if (pass == Pass::DILATE) {
+                        result |= row | fromLeft | fromRight;
+                    }
+                    else {
+                        result &= row & fromLeft & fromRight;
+                    }
+                }
+            }
+            result &= columnMask;
+            chunk.nextRows[rowIndex] = result;
+
+            const u64 current = chunk.rows[rowIndex];
+            for (u64 bits = result; bits != 0; bits &= bits - 1) {
+                const u32 x = lowestSetBit(bits);
+                const usize voxelIndex = rowIndex * chunkSize + x;
+                if ((current >> x & 1) != 0) {
+                    chunk.nextVoxels.push_back(voxelAt(chunk, voxelIndex));
+                    continue;
+                }
+                // only dilation creates voxels, which are guaranteed to have a solid neighbor
+                for (const Vec3i32 &offset : neighborOffsets()) {
+                    usize neighborIndex;
+                    const DenseChunk *neighbor =
+                        locate(static_cast<i32>(x) + offset.x(), y + offset.y(), z + offset.z(), neighborIndex);
+                    if (neighbor != nullptr && (neighbor->rows[neighborIndex / chunkSize] >>
+                                                    (neighborIndex % chunkSize) & 1) != 0) {
+                        const LocalVoxel &source = voxelAt(*neighbor, neighborIndex);
+                        chunk.nextVoxels.push_back({static_cast<u32>(voxelIndex), source.value, source.normal});
+                        break;
+                    }
+                }
+            }
+        }
+    }
+}
+
+void ChunkPostProcessor::endPass()
+{
+    switch (pass) {
+    case Pass::DILATE:
+    case Pass::ERODE:
+    case Pass::ERODE_CLAMPED:
+        for (auto it = chunks.begin(); it != chunks.end();) {
+            DenseChunk &chunk = it->second;
+            std::swap(chunk.rows, chunk.nextRows);
+            std::swap(chunk.voxels, chunk.nextVoxels);
+            // chunks with a snapshot are kept, since their original voxels may reappear after subtraction
+            const bool empty = chunk.voxels.empty() && chunk.originalVoxels.empty();
+            it = empty ? chunks.erase(it) : std::next(it);
+        }
+        break;
+
+    case Pass::LABEL_RUNS:
+        // every run starts out as its own component, with labels assigned in Morton order of the chunks
+        runCount = 0;
+        for (u64 chunkIndex : passChunks) {
+            DenseChunk &chunk = chunks.at(chunkIndex);
+            chunk.firstRun = runCount;
+            runCount += chunk.runs.size();
+        }
+        labels = std::make_unique<std::atomic<u64>[]>(runCount);
+        componentSizes = std::make_unique<std::atomic<u64>[]>(runCount);
+        for (u64 label = 0; label < runCount; ++label) {
+            labels[label] = label;
+            componentSizes[label] = 0;
+        }
+        break;
+
+    case Pass::MERGE_RUNS:
+    case Pass::MEASURE_COMPONENTS: break;
+
+    case Pass::REMOVE_COMPONENTS:
+        for (auto it = chunks.begin(); it != chunks.end();) {
+            DenseChunk &chunk = it->second;
+            chunk.runs = {};
+            chunk.rowRuns = {};
+            it = chunk.voxels.empty() ? chunks.erase(it) : std::next(it);
+        }
+        labels.reset();
+        componentSizes.reset();
+        keptComponents = {};
+        break;
+    }
+    passChunks.clear();
+}
+
+void ChunkPostProcessor::snapshot()
+{
+    for (auto &[chunkIndex, chunk] : chunks) {
+        chunk.originalRows = chunk.rows;
+        chunk.originalVoxels = chunk.voxels;
+    }
+}
+
+void ChunkPostProcessor::subtractFromSnapshot()
+{
+    for (auto it = chunks.begin(); it != chunks.end();) {
+        DenseChunk &chunk = it->second;
+        chunk.voxels.clear();
+        for (const LocalVoxel &voxel : chunk.originalVoxels) {
+            if ((chunk.rows[voxel.index / chunkSize] >> (voxel.index % chunkSize) & 1) == 0) {
+                chunk.voxels.push_back(voxel);
+            }
+        }
+        for (usize i = 0; i < chunk.rows.size(); ++i) {
+            chunk.rows[i] = chunk.originalRows[i] & ~chunk.rows[i];
+        }
+        chunk.originalRows = {};
+        chunk.originalVoxels = {};
+
+        if (chunk.voxels.empty()) {
+            it = chunks.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+void ChunkPostProcessor::labelRuns(DenseChunk &chunk)
+{
+    chunk.runs.clear();
+    chunk.rowRuns.resize(chunk.rows.size() + 1);
+    for (usize row = 0; row < chunk.rows.size(); ++row) {
+        chunk.rowRuns[row] = static_cast<u32>(chunk.runs.size());
+        const u64 bits = chunk.rows[row];
+        // runs begin at solid voxels after an empty one and end at solid voxels before an empty one
+        u64 begins = bits & ~(bits << 1);
+        u64 ends = bits & ~(bits >> 1);
+        for (; begins != 0; begins &= begins - 1, ends &= ends - 1) {
+            chunk.runs.push_back({static_cast<u8>(lowestSetBit(begins)), static_cast<u8>(lowestSetBit(ends))});
+        }
+    }
+    chunk.rowRuns.back() = static_cast<u32>(chunk.runs.size());
+}
+
+void ChunkPostProcessor::mergeRuns(u64 chunkIndex, const DenseChunk &chunk) noexcept
+{
+    Vec3u32 chunkPos;
+    dileave3(chunkIndex, chunkPos.data());
+    const Neighborhood neighborhood = neighborhoodOf(chunkPos);
+
+    const auto size = static_cast<i32>(chunkSize);
+    const u32 last = chunkSize - 1;
+    for (i32 z = 0; z < size; ++z) {
+        for (i32 y = 0; y < size; ++y) {
+            const auto row = static_cast<usize>(y + z * size);
+            for (u32 i = chunk.rowRuns[row]; i < chunk.rowRuns[row + 1]; ++i) {
+                const Run run = chunk.runs[i];
+
+                for (i32 dz = -1; dz <= 1; ++dz) {
+                    for (i32 dy = -1; dy <= 1; ++dy) {
+                        const i32 ty = y + dy, tz = z + dz;
+                        const i32 cy = ty < 0 ? -1 : ty >= size;
+                        const i32 cz = tz < 0 ? -1 : tz >= size;
+                        for (i32 cx = -1; cx <= 1; ++cx) {
+                            if ((cx < 0 && run.begin != 0) || (cx > 0 && run.end != last)) {
+                                continue;
+                            }
+                            const DenseChunk *neighbor =
+                                neighborhood[static_cast<usize>((cx + 1) + (cy + 1) * 3 + (cz + 1) * 9)];
+                            if (neighbor == nullptr) {
+                                continue;
+                            }
+                            // Every pair of adjacent runs is only merged from one side.
+                            // Within the chunk, runs merge with the preceding rows, across chunks, the chunk with the
+                            // greater labels merges with the other one.
+                            const bool mergedByOtherRun = neighbor == &chunk ? dz > 0 || (dz == 0 && dy >= 0)
+                                                                             : neighbor->firstRun > chunk.firstRun;
+                            if (mergedByOtherRun) {
+                                continue;
+                            }
+
+                            const auto targetRow = static_cast<usize>((ty - cy * size) + (tz - cz * size) * size);
+                            const u32 low = cx < 0 ? last : cx > 0 ? 0 : std::max<u32>(run.begin, 1) - 1;
+                            const u32 high = cx < 0 ? last : cx > 0 ? 0 : std::min<u32>(run.end + 1u, last);
+                            if ((neighbor->rows[targetRow] & bitRange(low, high)) == 0) {
+                                continue;
+                            }
+                            for (u32 j = neighbor->rowRuns[targetRow]; j < neighbor->rowRuns[targetRow + 1]; ++j) {
+                                const Run other = neighbor->runs[j];
+                                if (other.begin > high) {
+                                    break;
+                                }
+                                if (other.end >= low) {
+                                    uniteLabels(chunk.firstRun + i, neighbor->firstRun + j);
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+void ChunkPostProcessor::measureComponents(const DenseChunk &chunk) noexcept
+{
+    for (usize i = 0; i < chunk.runs.size(); ++i) {
+        const u64 component = findLabel(chunk.firstRun + i);
+        componentSizes[component].fetch_add(chunk.runs[i].end - chunk.runs[i].begin + 1u, std::memory_order_relaxed);
+    }
+}
+
+ComponentSelection ChunkPostProcessor::selectComponents(u64 minVoxels, u64 maxComponents)
+{
+    std::vector<u64> components;
+    for (u64 label = 0; label < runCount; ++label) {
+        if (labels[label] == label) {
+            components.push_back(label);
+        }
+    }
+    // larger components come first, with ties broken by label so that the selection is deterministic
+    std::sort(components.begin(), components.end(), [this](u64 lhs, u64 rhs) {
+        const u64 lhsSize = componentSizes[lhs], rhsSize = componentSizes[rhs];
+        return lhsSize != rhsSize ? lhsSize > rhsSize : lhs < rhs;
+    });
+
+    ComponentSelection result{components.size(), 0, 0};
+    keptComponents.assign(runCount, false);
+    for (usize i = 0; i < components.size(); ++i) {
+        const u64 voxelCount = componentSizes[components[i]];
+        if (voxelCount >= minVoxels && (maxComponents == 0 || i < maxComponents)) {
+            keptComponents[components[i]] = true;
+        }
+        else {
+            ++result.removedComponents;
+            result.removedVoxels += voxelCount;
+        }
+    }
+    return result;
+}
+
+void ChunkPostProcessor::removeComponents(DenseChunk &chunk) noexcept
+{
+    bool removedAny = false;
+    for (usize row = 0; row + 1 < chunk.rowRuns.size(); ++row) {
+        for (u32 i = chunk.rowRuns[row]; i < chunk.rowRuns[row + 1]; ++i) {
+            if (not keptComponents[findLabel(chunk.firstRun + i)]) {
+                chunk.rows[row] &= ~bitRange(chunk.runs[i].begin, chunk.runs[i].end);
+                removedAny = true;
+            }
+        }
+    }
+    if (removedAny) {
+        const auto isRemoved = [this, &chunk](const LocalVoxel &voxel) -> bool {
+            return (chunk.rows[voxel.index / chunkSize] >> (voxel.index % chunkSize) & 1) == 0;
+        };
+        chunk.voxels.erase(std::remove_if(chunk.voxels.begin(), chunk.voxels.end(), isRemoved), chunk.voxels.end());
+    }
+}
+
+u64 ChunkPostProcessor::findLabel(u64 label) noexcept
+{
+    // parents never have greater labels than their children, so this terminates even while labels are being merged
+    while (true) {
+        u64 parent = labels[label].load(std::memory_order_relaxed);
+        if (parent == label) {
+            return label;
+        }
+        const u64 grandparent = labels[parent].load(std::memory_order_relaxed);
+        if (grandparent != parent) {
+            // path halving, which may fail harmlessly if another thread has changed the parent in the meantime
+            labels[label].compare_exchange_weak(parent, grandparent, std::memory_order_relaxed);
+        }
+        label = grandparent;
+    }
+}
+
+void ChunkPostProcessor::uniteLabels(u64 a, u64 b) noexcept
+{
+    while (true) {
+        a = findLabel(a);
+        b = findLabel(b);
+        if (a == b) {
+            return;
+        }
+        if (a < b) {
+            std::swap(a, b);
+        }
+        // the greater root is linked to the smaller one, unless it has stopped being a root in the meantime
+        u64 expected = a;
+        if (labels[a].compare_exchange_strong(expected, b, std::memory_order_relaxed)) {
+            return;
+        }
+    }
+}
+
+void ChunkPostProcessor::toVoxels(u64 chunkIndex,
+                                  const DenseChunk &chunk,
+                                  std::vector<Voxel32> &out,
+                                  std::vector<Voxel32> &outNormals) const
+{
+    Vec3u32 chunkPos;
+    dileave3(chunkIndex, chunkPos.data());
+    const Vec3i32 origin = (chunkPos * chunkSize).cast<i32>();
+
+    out.clear();
+    outNormals.clear();
+    out.reserve(chunk.voxels.size());
+    outNormals.reserve(chunk.voxels.size());
+    for (const LocalVoxel &voxel : chunk.voxels) {
+        const Vec3u32 local{
+            voxel.index % chunkSize, voxel.index / chunkSize % chunkSize, voxel.index / chunkSize / chunkSize};
+        const Vec3i32 pos = origin + local.cast<i32>();
+        out.push_back({pos, {voxel.value}});
+        outNormals.push_back({pos, {voxel.normal}});
+    }
+}
+
+}  // namespace obj2voxel
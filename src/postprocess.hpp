@@ -0,0 +1,229 @@
+#ifndef OBJ2VOXEL_POSTPROCESS_HPP
+#define OBJ2VOXEL_POSTPROCESS_HPP
+
+#include "obj2voxel.h"
+#include "util.hpp"
+
+#include "voxelio/voxelio.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace obj2voxel {
+
+/// An enum which describes a morphological operation applied to the voxelized model.
+enum class Morphology : obj2voxel_enum_t {
+    /// Every empty voxel next to a solid voxel becomes solid.
+    DILATE = OBJ2VOXEL_MORPHOLOGY_DILATE,
+    /// Every solid voxel next to an empty voxel becomes empty.
+    ERODE = OBJ2VOXEL_MORPHOLOGY_ERODE,
+    /// Dilation followed by erosion, which fills gaps and holes without growing the model.
+    CLOSE = OBJ2VOXEL_MORPHOLOGY_CLOSE,
+    /// Keeps only the voxels which erosion would remove, which leaves a shell of the given thickness.
+    HOLLOW = OBJ2VOXEL_MORPHOLOGY_HOLLOW
+};
+
+constexpr const char *nameOf(Morphology operation)
+{
+    switch (operation) {
+    case Morphology::DILATE: return "DILATE";
+    case Morphology::ERODE: return "ERODE";
+    case Morphology::CLOSE: return "CLOSE";
+    case Morphology::HOLLOW: return "HOLLOW";
+    }
+    return nullptr;
+}
+
+/// An operation together with its radius, which is the number of passes for which it is applied.
+struct MorphologyStep {
+    Morphology operation;
+    u32 radius;
+};
+
+/// The result of selecting which connected components are kept.
+struct ComponentSelection {
+    u64 componentCount;
+    u64 removedComponents;
+    u64 removedVoxels;
+};
+
+/**
+ * @brief Stores voxelized chunks densely and applies morphological passes and island removal to them.
+ *
+ * Each chunk is stored as one 64-bit word per row along the x-axis, so that a pass combines the 3x3x3 neighborhood of
+ * 64 voxels at once with shifts, ORs and ANDs.
+ * Rows which cross the chunk boundary are read from the neighboring chunks, which are never modified during a pass.
+ * All chunks of a pass can therefore be processed concurrently.
+ *
+ * Connected components are found in four passes:
+ * 1. The rows of each chunk are split into runs of consecutive solid voxels, which become the initial labels.
+ * 2. Runs which are 26-connected are merged in a concurrent union-find, both within and across chunks.
+ * 3. The voxels of each component are counted at its root label.
+ * 4. After selectComponents(), the runs of all components which are not kept are removed.
+ *
+ * Only chunks which contain voxels are stored, so the full grid is never materialized.
+ * Chunks are identified by the same Morton indices as during voxelization, but their size is in output voxels.
+ */
+class ChunkPostProcessor {
+public:
+    enum class Pass : u8 {
+        DILATE,
+        /// Erosion where voxels outside the grid are empty, so the grid boundary erodes like any other surface.
+        ERODE,
+        /// Erosion where voxels outside the grid are copies of the closest voxel inside of it.
+        /// This undoes a dilation which was clipped at the grid boundary.
+        ERODE_CLAMPED,
+        LABEL_RUNS,
+        MERGE_RUNS,
+        MEASURE_COMPONENTS,
+        REMOVE_COMPONENTS
+    };
+
+private:
+    /// A voxel value and normal together with the index of the voxel within its chunk.
+    struct LocalVoxel {
+        u32 index;
+        u32 value;
+        u32 normal;
+    };
+
+    /// A run of consecutive solid voxels within a row with an inclusive range of x-coordinates.
+    struct Run {
+        u8 begin;
+        u8 end;
+    };
+
+    struct DenseChunk {
+        /// Rows indexed by y + z * chunkSize, where bit x is set for solid voxels.
+        std::vector<u64> rows;
+        /// Values of all solid voxels sorted by their index (z * chunkSize + y) * chunkSize + x.
+        std::vector<LocalVoxel> voxels;
+        std::vector<u64> nextRows;
+        std::vector<LocalVoxel> nextVoxels;
+        /// The state before the first pass of a hollowing operation.
+        std::vector<u64> originalRows;
+        std::vector<LocalVoxel> originalVoxels;
+        /// The runs of all rows, where the runs of a row start at the index stored for that row in rowRuns.
+        std::vector<Run> runs;
+        std::vector<u32> rowRuns;
+        /// The label of the first run, so that runs of all chunks have distinct labels.
+        u64 firstRun = 0;
+    };
+
+    u32 resolution;
+    u32 chunkSize;
+    u32 chunksPerAxis;
+    u64 rowMask;
+    Pass pass = Pass::DILATE;
+
+    std::mutex mutex;
+    std::unordered_map<u64, DenseChunk> chunks;
+    /// The chunks of the current pass in Morton order.
+    std::vector<u64> passChunks;
+
+    /// The union-find parent of every run label, where a component is identified by its smallest label.
+    std::unique_ptr<std::atomic<u64>[]> labels;
+    /// The number of voxels of each component, stored at the label of the component.
+    std::unique_ptr<std::atomic<u64>[]> componentSizes;
+    std::vector<bool> keptComponents;
+    u64 runCount = 0;
+
+public:
+    /**
+     * @brief Constructs an empty post-processor.
+     * @param resolution the output resolution
+     * @param chunkSize the size of a chunk in output voxels, which must be at most 64
+     */
+    ChunkPostProcessor(u32 resolution, u32 chunkSize);
+
+    /**
+     * @brief Stores the voxels of a chunk, whose positions are absolute. This function is thread-safe.
+     * @param chunkIndex the Morton index of the chunk
+     * @param voxels the voxels
+     * @param normals the normals of the same voxels in any order or nullptr
+     * @param count the number of voxels
+     */
+    void insert(u64 chunkIndex, const Voxel32 *voxels, const Voxel32 *normals, usize count);
+
+    /// Prepares a pass and returns the number of chunks which have to be processed.
+    usize beginPass(Pass type);
+
+    /// Processes the chunk with the given index in [0, beginPass()) and can be called concurrently.
+    void processChunk(usize index) noexcept;
+
+    /// Completes a pass, for example by replacing every chunk with its processed state and dropping empty chunks.
+    void endPass();
+
+    /**
+     * @brief Decides which components are kept after they have been measured.
+     * @param minVoxels the minimum number of voxels of a kept component
+     * @param maxComponents the maximum number of components, of which the largest are kept, or zero for no limit
+     * @return the number of components and of those which are removed
+     */
+    ComponentSelection selectComponents(u64 minVoxels, u64 maxComponents);
+
+    /// Remembers the current state of every chunk for subtractFromSnapshot().
+    void snapshot();
+
+    /// Replaces every chunk with the voxels of its snapshot which are not solid anymore and discards the snapshot.
+    void subtractFromSnapshot();
+
+    /// Returns the number of stored chunks.
+    usize chunkCount() const noexcept
+    {
+        return chunks.size();
+    }
+
+    /// Returns the Morton indices of all stored chunks in ascending order.
+    std::vector<u64> sortedChunkIndices() const
+    {
+        std::vector<u64> result;
+        result.reserve(chunks.size());
+        for (const auto &entry : chunks) {
+            result.push_back(entry.first);
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    /// Invokes a function with the Morton index, the absolute voxels and their normals of every chunk in Morton order.
+    /// Voxels which were inserted without normals have a normal of zero.
+    template <typename F>
+    void forEachChunk(F f) const
+    {
+        const std::vector<u64> sortedChunks = sortedChunkIndices();
+
+        std::vector<Voxel32> buffer;
+        std::vector<Voxel32> normalBuffer;
+        for (u64 chunkIndex : sortedChunks) {
+            toVoxels(chunkIndex, chunks.at(chunkIndex), buffer, normalBuffer);
+            f(chunkIndex, buffer.data(), normalBuffer.data(), buffer.size());
+        }
+    }
+
+private:
+    using Neighborhood = std::array<const DenseChunk *, 27>;
+
+    const DenseChunk *findNeighbor(Vec3u32 chunkPos, Vec3i32 offset) const noexcept;
+    Neighborhood neighborhoodOf(Vec3u32 chunkPos) const noexcept;
+    void morphChunk(u64 chunkIndex, DenseChunk &chunk) noexcept;
+    void labelRuns(DenseChunk &chunk);
+    void mergeRuns(u64 chunkIndex, const DenseChunk &chunk) noexcept;
+    void measureComponents(const DenseChunk &chunk) noexcept;
+    void removeComponents(DenseChunk &chunk) noexcept;
+    u64 findLabel(u64 label) noexcept;
+    void uniteLabels(u64 a, u64 b) noexcept;
+    void toVoxels(u64 chunkIndex,
+                  const DenseChunk &chunk,
+                  std::vector<Voxel32> &out,
+                  std::vector<Voxel32> &outNormals) const;
+};
+
+}  // namespace obj2voxel
+
+#endif  // OBJ2VOXEL_POSTPROCESS_HPP
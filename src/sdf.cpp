@@ -0,0 +1,200 @@
+#include "sdf.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace obj2voxel {
+
+namespace {
+
+constexpr float INF = std::numeric_limits<float>::infinity();
+
+/**
+ * @brief Computes the one-dimensional squared distance transform of a sampled function.
+ * This is the lower envelope of parabolas rooted at each sample, as described by Felzenszwalb and Huttenlocher.
+ * Infinite samples never contribute to the envelope and are skipped.
+ * @param f the input samples, which are replaced with the transformed values
+ * @param n the number of samples
+ * @param v scratch buffer for parabola locations of size n
+ * @param z scratch buffer for envelope boundaries of size n + 1
+ * @param d scratch buffer for the output of size n
+ */
+void distanceTransform1d(float f[], usize n, usize v[], float z[], float d[]) noexcept
+{
+    usize first = 0;
+    while (first < n && f[first] == INF) {
+        ++first;
+    }
+    if (first == n) {
+        return;
+    }
+
+    usize k = 0;
+    v[0] = first;
+    z[0] = -INF;
+    z[1] = INF;
+
+    const auto intersection = [f](usize q, usize p) -> float {
+        const auto qf = static_cast<float>(q);
+        const auto pf = static_cast<float>(p);
+        return ((f[q] + qf * qf) - (f[p] + pf * pf)) / (2 * qf - 2 * pf);
+    };
+
+    for (usize q = first + 1; q < n; ++q) {
+        if (f[q] == INF) {
+            continue;
+        }
+        float s = intersection(q, v[k]);
+        while (s <= z[k]) {
+            --k;
+            s = intersection(q, v[k]);
+        }
+        ++k;
+        v[k] = q;
+        z[k] = s;
+        z[k + 1] = INF;
+    }
+
+    k = 0;
+    for (usize q = 0; q < n; ++q) {
+        while (z[k + 1] < static_cast<float>(q)) {
+            ++k;
+        }
+        const auto offset = static_cast<float>(q) - static_cast<float>(v[k]);
+        d[q] = offset * offset + f[v[k]];
+    }
+    std::copy(d, d + n, f);
+}
+
+}  // namespace
+
+real_type distanceToTriangle(Vec3 p, const Triangle &triangle) noexcept
+{
+    // closest point computation from "Real-Time Collision Detection" by Christer Ericson, 5.1.5
+    const Vec3 a = triangle.v[0], b = triangle.v[1], c = triangle.v[2];
+    const Vec3 ab = b - a, ac = c - a, ap = p - a;
+
+    const real_type d1 = dot(ab, ap), d2 = dot(ac, ap);
+    if (d1 <= 0 && d2 <= 0) {
+        return length(p - a);
+    }
+
+    const Vec3 bp = p - b;
+    const real_type d3 = dot(ab, bp), d4 = dot(ac, bp);
+    if (d3 >= 0 && d4 <= d3) {
+        return length(p - b);
+    }
+
+    const real_type vc = d1 * d4 - d3 * d2;
+    if (vc <= 0 && d1 >= 0 && d3 <= 0) {
+        return length(p - (a + ab * (d1 / (d1 - d3))));
+    }
+
+    const Vec3 cp = p - c;
+    const real_type d5 = dot(ab, cp), d6 = dot(ac, cp);
+    if (d6 >= 0 && d5 <= d6) {
+        return length(p - c);
+    }
+
+    const real_type vb = d5 * d2 - d1 * d6;
+    if (vb <= 0 && d2 >= 0 && d6 <= 0) {
+        return length(p - (a + ac * (d2 / (d2 - d6))));
+    }
+
+    const real_type va = d3 * d6 - d5 * d4;
+    if (va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0) {
+        return length(p - (b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)))));
+    }
+
+    const real_type denominator = 1 / (va + vb + vc);
+    return length(p - (a + ab * (vb * denominator) + ac * (vc * denominator)));
+}
+
+DistanceGrid::DistanceGrid(u32 resolution)
+    : resolution{resolution}
+    , values(usize{resolution} * resolution * resolution, INF)
+    , states(values.size(), State::INSIDE)
+{
+}
+
+void DistanceGrid::classifyOutside() noexcept
+{
+    std::vector<usize> stack;
+
+    const auto visit = [this, &stack](usize index) {
+        if (states[index] == State::INSIDE) {
+            states[index] = State::OUTSIDE;
+            stack.push_back(index);
+        }
+    };
+
+    const u32 last = resolution - 1;
+    for (u32 a = 0; a < resolution; ++a) {
+        for (u32 b = 0; b < resolution; ++b) {
+            visit(indexOf({0, a, b}));
+            visit(indexOf({last, a, b}));
+            visit(indexOf({a, 0, b}));
+            visit(indexOf({a, last, b}));
+            visit(indexOf({a, b, 0}));
+            visit(indexOf({a, b, last}));
+        }
+    }
+
+    const usize strides[3]{1, resolution, lineCount()};
+    while (not stack.empty()) {
+        const usize index = stack.back();
+        stack.pop_back();
+
+        for (usize axis = 0; axis < 3; ++axis) {
+            const usize coordinate = index / strides[axis] % resolution;
+            if (coordinate != 0) {
+                visit(index - strides[axis]);
+            }
+            if (coordinate != last) {
+                visit(index + strides[axis]);
+            }
+        }
+    }
+}
+
+void DistanceGrid::transformLines(usize axis, usize firstLine, usize count) noexcept
+{
+    VXIO_DEBUG_ASSERT_LT(axis, 3u);
+
+    std::vector<float> line(resolution);
+    std::vector<usize> v(resolution);
+    std::vector<float> z(usize{resolution} + 1);
+    std::vector<float> d(resolution);
+
+    const usize stride = axis == 0 ? 1 : axis == 1 ? resolution : lineCount();
+    const usize end = std::min(firstLine + count, lineCount());
+
+    for (usize l = firstLine; l < end; ++l) {
+        const usize lo = l % resolution;
+        const usize hi = l / resolution;
+        // the line is identified by the two coordinates of the other axes
+        const usize base = axis == 0 ? l * resolution : axis == 1 ? hi * lineCount() + lo : hi * resolution + lo;
+
+        for (usize i = 0; i < resolution; ++i) {
+            line[i] = values[base + i * stride];
+        }
+        distanceTransform1d(line.data(), resolution, v.data(), z.data(), d.data());
+        for (usize i = 0; i < resolution; ++i) {
+            values[base + i * stride] = line[i];
+        }
+    }
+}
+
+void DistanceGrid::finalize(float band) noexcept
+{
+    for (usize i = 0; i < values.size(); ++i) {
+        float distance = std::sqrt(values[i]);
+        if (states[i] == State::INSIDE) {
+            distance = -distance;
+        }
+        values[i] = band == 0 ? distance : std::clamp(distance, -band, band);
+    }
+}
+
+}  // namespace obj2voxel
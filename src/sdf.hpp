@@ -0,0 +1,92 @@
+#ifndef OBJ2VOXEL_SDF_HPP
+#define OBJ2VOXEL_SDF_HPP
+
+#include "triangle.hpp"
+
+#include <vector>
+
+namespace obj2voxel {
+
+/// Returns the Euclidean distance between a point and a triangle.
+real_type distanceToTriangle(Vec3 p, const Triangle &triangle) noexcept;
+
+/**
+ * @brief A dense cubic grid from which a signed distance field is computed.
+ *
+ * The computation happens in three steps:
+ * 1. Surface voxels are marked and seeded with their exact distance to nearby triangles.
+ *    Different threads may seed different voxels concurrently.
+ * 2. All voxels which are reachable from the grid boundary without crossing the surface are classified as outside.
+ * 3. A separable Euclidean distance transform propagates the seed distances through the grid.
+ *    It runs as three passes of independent lines along each axis, so lines can be transformed in parallel.
+ *
+ * Voxels which are neither surface nor outside are inside and get a negative distance.
+ * For meshes which are not watertight, the classification leaks and the result is an unsigned distance field.
+ */
+class DistanceGrid {
+private:
+    enum class State : u8 { INSIDE, SURFACE, OUTSIDE };
+
+    u32 resolution;
+    /// Squared distances until finalize() is called, signed distances afterwards.
+    std::vector<float> values;
+    std::vector<State> states;
+
+public:
+    explicit DistanceGrid(u32 resolution);
+
+    u32 size() const noexcept
+    {
+        return resolution;
+    }
+
+    /// Returns the number of lines along any axis.
+    usize lineCount() const noexcept
+    {
+        return usize{resolution} * resolution;
+    }
+
+    /// Marks a voxel as being part of the surface.
+    void markSurface(Vec3u32 pos) noexcept
+    {
+        states[indexOf(pos)] = State::SURFACE;
+    }
+
+    bool isSurface(Vec3u32 pos) const noexcept
+    {
+        return states[indexOf(pos)] == State::SURFACE;
+    }
+
+    /// Lowers the distance of a surface voxel if the given distance is smaller than the current one.
+    void seed(Vec3u32 pos, float distance) noexcept
+    {
+        float &value = values[indexOf(pos)];
+        value = std::min(value, distance * distance);
+    }
+
+    /// Classifies all voxels which are 6-connected to the grid boundary through non-surface voxels as outside.
+    /// This is a serial flood fill over the entire grid.
+    void classifyOutside() noexcept;
+
+    /// Runs the one-dimensional distance transform on a range of lines along the given axis.
+    void transformLines(usize axis, usize firstLine, usize count) noexcept;
+
+    /// Converts squared distances into signed distances, optionally clamped to [-band, band] if band is not zero.
+    void finalize(float band) noexcept;
+
+    /// Returns the z-slice of the finalized grid with resolution * resolution values where x varies fastest.
+    const float *slice(u32 z) const noexcept
+    {
+        return values.data() + usize{z} * lineCount();
+    }
+
+private:
+    usize indexOf(Vec3u32 pos) const noexcept
+    {
+        return (usize{pos.z()} * resolution + pos.y()) * resolution + pos.x();
+    }
+};
+
+}  // namespace obj2voxel
+
+#endif  // OBJ2VOXEL_SDF_HPP
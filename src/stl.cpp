@@ -0,0 +1,400 @@
+#include "constants.hpp"
+#include "io.hpp"
+#include "mappedfile.hpp"
+#include "pipes.hpp"
+
+#include "voxelio/log.hpp"
+#include "voxelio/stringify.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <future>
+#include <string_view>
+#include <thread>
+
+namespace obj2voxel {
+namespace {
+
+constexpr usize BINARY_HEADER_SIZE = 84;
+constexpr usize BINARY_TRIANGLE_SIZE = 50;
+/// ASCII files are only split across threads in pieces of at least this many bytes.
+constexpr usize ASCII_MIN_PIECE_SIZE = 1024 * 1024;
+
+struct StlTriangleStream final : public ITriangleStream {
+private:
+    std::vector<f32> vertices;
+    usize index = 0;
+
+public:
+    StlTriangleStream(std::vector<f32> vertices) noexcept : vertices{std::move(vertices)} {}
+
+    bool next(VisualTriangle &triangle) noexcept final
+    {
+        if (not hasNext()) {
+            return false;
+        }
+
+        for (usize i = 0; i < 3; ++i) {
+            triangle.v[i] = Vec3f{vertices.data() + index}.cast<real_type>();
+            triangle.t[i] = {};
+            index += 3;
+        }
+
+        triangle.type = TriangleType::MATERIALLESS;
+        return true;
+    }
+
+private:
+    bool hasNext() const noexcept
+    {
+        return index < vertices.size();
+    }
+};
+
+// BINARY STL ==========================================================================================================
+
+/// Returns true if the file is a binary STL file.
+/// Many binary exporters start their header with "solid" as well, so such files are only recognized as binary if their
+/// size matches the triangle count exactly.
+bool isBinaryStl(const u8 *data, usize size) noexcept
+{
+    if (size < BINARY_HEADER_SIZE) {
+        return false;
+    }
+    const usize expectedSize = BINARY_HEADER_SIZE + usize{decodeLittle<u32>(data + 80)} * BINARY_TRIANGLE_SIZE;
+    const bool hasSolidHeader = std::string_view{reinterpret_cast<const char *>(data), 5} == "solid";
+    return hasSolidHeader ? size == expectedSize : size >= expectedSize;
+}
+
+/// Appends the vertices of consecutive binary STL triangles to a vector.
+void decodeBinaryStlTriangles(const u8 *data, usize triangleCount, std::vector<f32> &out) noexcept
+{
+    out.reserve(out.size() + triangleCount * 9);
+    for (usize i = 0; i < triangleCount; ++i) {
+        // skip the normal at the start and the attribute byte count at the end of each triangle
+        const u8 *triangle = data + i * BINARY_TRIANGLE_SIZE + 3 * sizeof(f32);
+        for (usize j = 0; j < 9; ++j) {
+            out.push_back(decodeLittle<f32>(triangle + j * sizeof(f32)));
+        }
+    }
+}
+
+std::vector<f32> parseBinaryStl(const u8 *data) noexcept
+{
+    std::vector<f32> vertices;
+    decodeBinaryStlTriangles(data + BINARY_HEADER_SIZE, decodeLittle<u32>(data + 80), vertices);
+    return vertices;
+}
+
+// ASCII STL ===========================================================================================================
+
+constexpr bool isSpace(char c) noexcept
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+/// Returns the offset of the first "facet" keyword at or after the given offset, or the size if there is none.
+/// Parsing pieces of the file which begin at facets ensures that no facet is split between two pieces.
+usize findFacet(std::string_view text, usize offset) noexcept
+{
+    while ((offset = text.find("facet", offset)) != std::string_view::npos) {
+        // "endfacet" also contains the keyword, so only accept it at the start of a token
+        if (offset == 0 || isSpace(text[offset - 1])) {
+            return offset;
+        }
+        offset += 5;
+    }
+    return text.size();
+}
+
+/**
+ * @brief Parses the vertices of all facets in a piece of an ASCII STL file.
+ * Only "vertex" keywords and their coordinates are relevant, all other tokens such as normals are skipped.
+ * @param text the piece of the file
+ * @param out the vector to which the coordinates are appended
+ * @return an error message or an empty string on success
+ */
+std::string parseAsciiStlPiece(std::string_view text, std::vector<f32> &out) noexcept
+{
+    const char *pos = text.data();
+    const char *const end = text.data() + text.size();
+
+    const auto nextToken = [&pos, end]() -> std::string_view {
+        while (pos != end && isSpace(*pos)) {
+            ++pos;
+        }
+        const char *begin = pos;
+        while (pos != end && not isSpace(*pos)) {
+            ++pos;
+        }
+        return {begin, static_cast<usize>(pos - begin)};
+    };
+
+    usize vertexCount = 0;
+    for (std::string_view token = nextToken(); not token.empty(); token = nextToken()) {
+        if (token != "vertex") {
+            continue;
+        }
+        for (usize i = 0; i < 3; ++i) {
+            std::string_view number = nextToken();
+            // from_chars doesn't accept an explicit plus sign
+            if (not number.empty() && number.front() == '+') {
+                number.remove_prefix(1);
+            }
+            f32 value;
+            const auto [numberEnd, errc] = std::from_chars(number.data(), number.data() + number.size(), value);
+            if (errc != std::errc{} || numberEnd != number.data() + number.size()) {
+                return "invalid vertex coordinate \"" + std::string{number} + '"';
+            }
+            out.push_back(value);
+        }
+        ++vertexCount;
+    }
+
+    if (vertexCount % 3 != 0) {
+        return "facet with " + stringify(vertexCount % 3) + " instead of 3 vertices";
+    }
+    return {};
+}
+
+/// Returns the offset of the last "facet" keyword in the text, or zero if there is none.
+usize findLastFacet(std::string_view text) noexcept
+{
+    usize offset = text.size();
+    while (offset != 0 && (offset = text.rfind("facet", offset - 1)) != std::string_view::npos) {
+        if (offset == 0 || isSpace(text[offset - 1])) {
+            return offset;
+        }
+    }
+    return 0;
+}
+
+/// Splits an ASCII STL file at facet boundaries and parses the pieces concurrently.
+std::optional<std::vector<f32>> parseAsciiStl(std::string_view text) noexcept
+{
+    // even a single core benefits from a second piece because page faults of the mapped file overlap with parsing
+    const usize maxPieces = std::max(2u, std::thread::hardware_concurrency());
+    const usize pieceCount = std::clamp(text.size() / ASCII_MIN_PIECE_SIZE, usize{1}, maxPieces);
+
+    std::vector<usize> boundaries{findFacet(text, 0)};
+    for (usize i = 1; i < pieceCount; ++i) {
+        boundaries.push_back(std::max(boundaries.back(), findFacet(text, text.size() * i / pieceCount)));
+    }
+    boundaries.push_back(text.size());
+
+    std::vector<std::future<std::string>> futures;
+    std::vector<std::vector<f32>> pieces(pieceCount);
+    for (usize i = 0; i < pieceCount; ++i) {
+        const std::string_view piece = text.substr(boundaries[i], boundaries[i + 1] - boundaries[i]);
+        // the first piece is parsed on the calling thread
+        const auto policy = i == 0 ? std::launch::deferred : std::launch::async;
+        futures.push_back(std::async(policy, [piece, &out = pieces[i]] {
+            return parseAsciiStlPiece(piece, out);
+        }));
+    }
+
+    usize totalSize = 0;
+    bool success = true;
+    for (usize i = 0; i < pieceCount; ++i) {
+        if (const std::string error = futures[i].get(); not error.empty()) {
+            VXIO_LOG(ERROR, "Failed to parse ASCII STL: " + error);
+            success = false;
+        }
+        totalSize += pieces[i].size();
+    }
+    if (not success) {
+        return std::nullopt;
+    }
+
+    if (pieceCount == 1) {
+        return std::move(pieces[0]);
+    }
+    std::vector<f32> vertices;
+    vertices.reserve(totalSize);
+    for (const std::vector<f32> &piece : pieces) {
+        vertices.insert(vertices.end(), piece.begin(), piece.end());
+    }
+    return vertices;
+}
+
+// STANDARD INPUT ======================================================================================================
+
+/// Returns true if the start of an STL file is binary.
+/// The size of standard input is unknown, so binary files whose header starts with "solid" are only recognized by
+/// bytes which can't occur in text, such as those of the triangle count and of the first triangle.
+bool isBinaryStlPrefix(std::string_view prefix) noexcept
+{
+    if (prefix.substr(0, 5) != "solid") {
+        return true;
+    }
+    return std::any_of(prefix.begin(), prefix.end(), [](char c) {
+        const auto byte = static_cast<unsigned char>(c);
+        return byte >= 0x7f || (byte < 0x20 && not isSpace(c));
+    });
+}
+
+/// Parses an STL file from standard input in blocks, so that the file is never held in memory entirely.
+/// Each block is parsed once all of its triangles have been streamed.
+struct StdinStlTriangleStream final : public ITriangleStream {
+private:
+    StdinBuffer in;
+    /// Bytes which have been read, but not parsed yet.
+    std::string pending;
+    std::vector<f32> vertices;
+    usize index = 0;
+    usize triangleCount = 0;
+    /// The number of triangles of a binary file which have not been parsed yet.
+    u32 remainingTriangles = 0;
+    bool binary = false;
+    bool ended = false;
+    bool failed_ = false;
+
+public:
+    /// Reads the start of the file and returns false if it is malformed.
+    bool init() noexcept
+    {
+        pending.resize(BINARY_HEADER_SIZE + BINARY_TRIANGLE_SIZE);
+        pending.resize(static_cast<usize>(in.sgetn(pending.data(), static_cast<std::streamsize>(pending.size()))));
+
+        binary = isBinaryStlPrefix(pending);
+        if (not binary) {
+            return true;
+        }
+        if (pending.size() < BINARY_HEADER_SIZE) {
+            VXIO_LOG(ERROR, "Binary STL from standard input is shorter than its header");
+            return false;
+        }
+        remainingTriangles = decodeLittle<u32>(reinterpret_cast<const u8 *>(pending.data()) + 80);
+        pending.erase(0, BINARY_HEADER_SIZE);
+        return true;
+    }
+
+    bool failed() const noexcept final
+    {
+        return failed_;
+    }
+
+    bool next(VisualTriangle &triangle) noexcept final
+    {
+        while (index == vertices.size()) {
+            if (ended) {
+                return false;
+            }
+            vertices.clear();
+            index = 0;
+            if (binary) {
+                readBinaryBlock();
+            }
+            else {
+                readAsciiBlock();
+            }
+        }
+
+        for (usize i = 0; i < 3; ++i) {
+            triangle.v[i] = Vec3f{vertices.data() + index}.cast<real_type>();
+            triangle.t[i] = {};
+            index += 3;
+        }
+        triangle.type = TriangleType::MATERIALLESS;
+        ++triangleCount;
+        return true;
+    }
+
+private:
+    /// Reads bytes from standard input and appends them to the pending bytes, returning the number of bytes read.
+    usize readPending(usize size) noexcept
+    {
+        const usize oldSize = pending.size();
+        pending.resize(oldSize + size);
+        const auto count = static_cast<usize>(in.sgetn(pending.data() + oldSize, static_cast<std::streamsize>(size)));
+        pending.resize(oldSize + count);
+        return count;
+    }
+
+    void readBinaryBlock() noexcept
+    {
+        const usize blockTriangles = std::min(usize{remainingTriangles}, PIPE_BUFFER_SIZE / BINARY_TRIANGLE_SIZE);
+        const usize blockSize = blockTriangles * BINARY_TRIANGLE_SIZE;
+        if (pending.size() < blockSize) {
+            readPending(blockSize - pending.size());
+        }
+
+        const usize parsedTriangles = std::min(blockTriangles, pending.size() / BINARY_TRIANGLE_SIZE);
+        decodeBinaryStlTriangles(reinterpret_cast<const u8 *>(pending.data()), parsedTriangles, vertices);
+        pending.erase(0, parsedTriangles * BINARY_TRIANGLE_SIZE);
+        remainingTriangles -= static_cast<u32>(parsedTriangles);
+
+        if (parsedTriangles < blockTriangles) {
+            VXIO_LOG(ERROR,
+                     "Binary STL from standard input ended " + stringifyLargeInt(remainingTriangles) +
+                         " triangles early");
+            remainingTriangles = 0;
+            failed_ = true;
+        }
+        finishIf(remainingTriangles == 0);
+    }
+
+    void readAsciiBlock() noexcept
+    {
+        const bool endOfInput = readPending(PIPE_BUFFER_SIZE) == 0;
+        // the last facet might be incomplete, so it is kept for the next block unless there is no more input
+        const usize parsedSize = endOfInput ? pending.size() : findLastFacet(pending);
+
+        if (const std::string error = parseAsciiStlPiece({pending.data(), parsedSize}, vertices); not error.empty()) {
+            VXIO_LOG(ERROR, "Failed to parse ASCII STL from standard input: " + error);
+            vertices.clear();
+            failed_ = true;
+            finishIf(true);
+            return;
+        }
+        pending.erase(0, parsedSize);
+        finishIf(endOfInput);
+    }
+
+    void finishIf(bool condition) noexcept
+    {
+        if (condition) {
+            ended = true;
+            const usize totalCount = triangleCount + vertices.size() / 9;
+            VXIO_LOG(INFO, "Streamed STL with " + stringifyLargeInt(totalCount) + " triangles");
+        }
+    }
+};
+
+}  // namespace
+
+std::unique_ptr<ITriangleStream> ITriangleStream::fromStlFile(const std::string &inFile) noexcept
+{
+    if (isStdioPath(inFile)) {
+        auto stream = std::make_unique<StdinStlTriangleStream>();
+        return stream->init() ? std::move(stream) : nullptr;
+    }
+
+    std::optional<MappedFile> file = MappedFile::open(inFile);
+    if (not file.has_value()) {
+        VXIO_LOG(ERROR, "Failed to open STL file: \"" + inFile + "\"");
+        return nullptr;
+    }
+
+    std::vector<f32> vertices;
+    if (isBinaryStl(file->data(), file->size())) {
+        vertices = parseBinaryStl(file->data());
+    }
+    else {
+        const std::string_view text{reinterpret_cast<const char *>(file->data()), file->size()};
+        if (text.substr(0, 5) != "solid") {
+            VXIO_LOG(ERROR, "Binary STL file \"" + inFile + "\" is smaller than its triangle count implies");
+            return nullptr;
+        }
+        std::optional<std::vector<f32>> parsed = parseAsciiStl(text);
+        if (not parsed.has_value()) {
+            return nullptr;
+        }
+        vertices = std::move(*parsed);
+    }
+
+    VXIO_LOG(INFO, "Loaded STL file with " + stringifyLargeInt(vertices.size() / 9) + " triangles");
+    return std::unique_ptr<StlTriangleStream>(new StlTriangleStream{std::move(vertices)});
+}
+
+}  // namespace obj2voxel
@@ -3,6 +3,7 @@
 
 #include "ringbuffer.hpp"
 
+#include <chrono>
 #include <condition_variable>
 #include <mutex>
 
@@ -125,6 +126,32 @@ public:
         return true;
     }
 
+    /// Waits until the event is triggered or the timeout expires.
+    /// Returns true if the event has been triggered.
+    template <typename Rep, typename Period>
+    bool waitFor(const std::chrono::duration<Rep, Period> &timeout) noexcept
+    {
+        std::unique_lock<std::mutex> lock{mutex};
+        return condition.wait_for(lock, timeout, [this] {
+            return flag;
+        });
+    }
+
+    /// Waits until the event is triggered, regardless of spurious wakeups.
+    void waitUntilTriggered() noexcept
+    {
+        std::unique_lock<std::mutex> lock{mutex};
+        condition.wait(lock, [this] {
+            return flag;
+        });
+    }
+
+    bool isTriggered() const noexcept
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        return flag;
+    }
+
     void trigger() noexcept
     {
         std::lock_guard<std::mutex> lock{mutex};
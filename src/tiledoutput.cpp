@@ -0,0 +1,199 @@
+#include "tiledoutput.hpp"
+
+#include "asyncfile.hpp"
+
+#include "voxelio/log.hpp"
+#include "voxelio/stream.hpp"
+#include "voxelio/stringify.hpp"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace obj2voxel {
+
+TiledVoxelOutput::TiledVoxelOutput(
+    const std::string &path, FileType format, u32 resolution, u32 tilesPerAxis, u32 chunkSize)
+    : format{format}, resolution{resolution}, chunkSize{chunkSize}
+{
+    VXIO_ASSERT_NE(tilesPerAxis, 0u);
+    VXIO_ASSERT_NE(chunkSize, 0u);
+
+    const usize dot = path.find_last_of('.');
+    const usize separator = path.find_last_of("/\\");
+    const bool hasExtension = dot != std::string::npos && (separator == std::string::npos || dot > separator);
+    basePath = hasExtension ? path.substr(0, dot) : path;
+    extension = hasExtension ? path.substr(dot) : std::string{};
+
+    // tiles are aligned to chunks so that every chunk belongs to exactly one tile
+    tileSize = divCeil(divCeil(resolution, tilesPerAxis), chunkSize) * chunkSize;
+    this->tilesPerAxis = divCeil(resolution, tileSize);
+    tiles = std::make_unique<Tile[]>(usize{this->tilesPerAxis} * this->tilesPerAxis * this->tilesPerAxis);
+
+    chunksPerAxis = divCeil(resolution, chunkSize);
+    chunksPerTile = tileSize / chunkSize;
+    std::vector<u64> chunksOfTileOnAxis(this->tilesPerAxis);
+    for (u32 t = 0; t < this->tilesPerAxis; ++t) {
+        chunksOfTileOnAxis[t] = std::min(chunksPerTile, chunksPerAxis - t * chunksPerTile);
+    }
+    for (u32 z = 0; z < this->tilesPerAxis; ++z) {
+        for (u32 y = 0; y < this->tilesPerAxis; ++y) {
+            for (u32 x = 0; x < this->tilesPerAxis; ++x) {
+                tiles[indexOf({x, y, z})].remainingChunks =
+                    chunksOfTileOnAxis[x] * chunksOfTileOnAxis[y] * chunksOfTileOnAxis[z];
+            }
+        }
+    }
+
+    VXIO_LOG(INFO,
+             "Writing " + stringify(this->tilesPerAxis) + "^3 tiles with " + stringify(tileSize) +
+                 "^3 voxels each to \"" + basePath + "_x_y_z" + extension + '"');
+}
+
+std::string TiledVoxelOutput::pathOf(Vec3u32 tilePos) const
+{
+    return basePath + '_' + stringify(tilePos.x()) + '_' + stringify(tilePos.y()) + '_' + stringify(tilePos.z()) +
+           extension;
+}
+
+bool TiledVoxelOutput::completeChunk(Vec3u32 chunkMin, const Voxel32 voxels[], usize count) noexcept
+{
+    if (chunkMin.x() >= resolution || chunkMin.y() >= resolution || chunkMin.z() >= resolution) {
+        VXIO_DEBUG_ASSERT_EQ(count, 0u);
+        return true;
+    }
+
+    return completeChunks(chunkMin / tileSize, voxels, count, 1);
+}
+
+bool TiledVoxelOutput::completeEmptyChunks(Vec3u32 boxMin,
+                                           Vec3u32 boxMax,
+                                           const std::vector<Vec3u32> &completedChunks) noexcept
+{
+    const Vec3u32 chunkMin = boxMin / chunkSize;
+    const Vec3u32 chunkMax = obj2voxel::min(boxMax / chunkSize, Vec3u32::filledWith(chunksPerAxis));
+    if (obj2voxel::min(chunkMin, chunkMax) != chunkMin || chunkMin.x() == chunkMax.x() ||
+        chunkMin.y() == chunkMax.y() || chunkMin.z() == chunkMax.z()) {
+        return true;
+    }
+
+    std::unordered_map<usize, u64> completedChunksOfTile;
+    for (Vec3u32 completedChunk : completedChunks) {
+        if (completedChunk.x() < resolution && completedChunk.y() < resolution && completedChunk.z() < resolution) {
+            ++completedChunksOfTile[indexOf(completedChunk / tileSize)];
+        }
+    }
+
+    // only the tiles which overlap the box are visited, each is completed with the number of its empty chunks at once
+    const Vec3u32 tileMin = chunkMin / chunksPerTile;
+    const Vec3u32 tileMax = (chunkMax - Vec3u32::one()) / chunksPerTile;
+    bool success = true;
+    for (u32 z = tileMin.z(); z <= tileMax.z(); ++z) {
+        for (u32 y = tileMin.y(); y <= tileMax.y(); ++y) {
+            for (u32 x = tileMin.x(); x <= tileMax.x(); ++x) {
+                const Vec3u32 tilePos{x, y, z};
+                const Vec3u32 overlapMin = obj2voxel::max(chunkMin, tilePos * chunksPerTile);
+                const Vec3u32 overlapMax = obj2voxel::min(chunkMax, (tilePos + Vec3u32::one()) * chunksPerTile);
+                const Vec3u32 overlap = overlapMax - overlapMin;
+                const u64 overlapChunks = u64{overlap.x()} * overlap.y() * overlap.z();
+
+                const auto completed = completedChunksOfTile.find(indexOf(tilePos));
+                const u64 completedCount = completed == completedChunksOfTile.end() ? 0 : completed->second;
+                VXIO_ASSERT_LE(completedCount, overlapChunks);
+                success &= completeChunks(tilePos, nullptr, 0, overlapChunks - completedCount);
+            }
+        }
+    }
+    return success;
+}
+
+bool TiledVoxelOutput::completeChunks(Vec3u32 tilePos, const Voxel32 voxels[], usize count, u64 chunkCount) noexcept
+{
+    if (chunkCount == 0) {
+        return true;
+    }
+    Tile &tile = tiles[indexOf(tilePos)];
+
+    std::vector<Voxel32> tileVoxels;
+    {
+        std::lock_guard<std::mutex> lock{tile.mutex};
+        VXIO_ASSERT_GE(tile.remainingChunks, chunkCount);
+        tile.voxels.insert(tile.voxels.end(), voxels, voxels + count);
+        tile.remainingChunks -= chunkCount;
+        if (tile.remainingChunks != 0) {
+            return true;
+        }
+        tileVoxels = std::move(tile.voxels);
+        tile.voxels = {};
+    }
+
+    return tileVoxels.empty() || writeTile(tilePos, std::move(tileVoxels));
+}
+
+bool TiledVoxelOutput::writeTile(Vec3u32 tilePos, std::vector<Voxel32> voxels) noexcept
+{
+    const std::string path = pathOf(tilePos);
+    std::unique_ptr<OutputStream> stream = openAsyncFileOutput(path, directIo);
+    if (stream == nullptr) {
+        VXIO_LOG(ERROR, "Failed to open output tile \"" + path + '"');
+        return false;
+    }
+
+    const Vec3i32 origin = (tilePos * tileSize).cast<i32>();
+    for (Voxel32 &voxel : voxels) {
+        voxel.pos -= origin;
+    }
+
+    std::unique_ptr<IVoxelSink> sink = IVoxelSink::fromVoxelio(std::move(stream), format, tileSize);
+    if (materials) {
+        sink->useMaterials(materialColors);
+    }
+    sink->write(voxels.data(), voxels.size());
+    sink->finalize();
+    if (not sink->canWrite()) {
+        VXIO_LOG(ERROR, "Failed to write output tile \"" + path + '"');
+        return false;
+    }
+
+    voxelCount += voxels.size();
+    {
+        std::lock_guard<std::mutex> lock{writtenMutex};
+        writtenTiles.push_back(indexOf(tilePos));
+    }
+    VXIO_LOG(DEBUG, "Wrote " + stringifyLargeInt(voxels.size()) + " voxels to tile \"" + path + '"');
+    return true;
+}
+
+bool TiledVoxelOutput::finalize() noexcept
+{
+    std::sort(writtenTiles.begin(), writtenTiles.end());
+
+    const std::string manifestPath = basePath + ".tiles";
+    std::optional<FileOutputStream> stream = FileOutputStream::open(manifestPath);
+    if (not stream.has_value()) {
+        VXIO_LOG(ERROR, "Failed to open tile manifest \"" + manifestPath + '"');
+        return false;
+    }
+
+    const usize separator = basePath.find_last_of("/\\");
+    const std::string baseName = separator == std::string::npos ? basePath : basePath.substr(separator + 1);
+
+    stream->writeString("# minX minY minZ maxX maxY maxZ path, in voxels\n");
+    for (usize index : writtenTiles) {
+        const Vec3u32 tilePos{static_cast<u32>(index % tilesPerAxis),
+                              static_cast<u32>(index / tilesPerAxis % tilesPerAxis),
+                              static_cast<u32>(index / tilesPerAxis / tilesPerAxis)};
+        const Vec3u32 min = tilePos * tileSize;
+        const Vec3u32 max = obj2voxel::min(min + Vec3u32::filledWith(tileSize), Vec3u32::filledWith(resolution));
+        const std::string file = pathOf(tilePos);
+        stream->writeString(stringify(min.x()) + ' ' + stringify(min.y()) + ' ' + stringify(min.z()) + ' ' +
+                            stringify(max.x()) + ' ' + stringify(max.y()) + ' ' + stringify(max.z()) + ' ' +
+                            baseName + file.substr(basePath.size()) + '\n');
+    }
+
+    VXIO_LOG(INFO,
+             "Wrote " + stringifyLargeInt(writtenTiles.size()) + " non-empty tiles and manifest \"" + manifestPath +
+                 '"');
+    return not stream->err();
+}
+
+}  // namespace obj2voxel
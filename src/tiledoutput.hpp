@@ -0,0 +1,128 @@
+#ifndef OBJ2VOXEL_TILEDOUTPUT_HPP
+#define OBJ2VOXEL_TILEDOUTPUT_HPP
+
+#include "io.hpp"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace obj2voxel {
+
+/**
+ * @brief Partitions the output grid into cubic tiles which are written to separate files.
+ * Each file has the origin of its tile as its local origin.
+ *
+ * The voxels of a tile are buffered until every chunk inside of it has been completed.
+ * The thread which completes the last chunk then writes the tile with its own sink, so different tiles can be written
+ * concurrently.
+ * Tiles without voxels produce no files.
+ * Once all tiles are written, a manifest lists the voxel bounds and file name of each tile.
+ */
+class TiledVoxelOutput {
+private:
+    struct Tile {
+        std::mutex mutex;
+        std::vector<Voxel32> voxels;
+        u64 remainingChunks = 0;
+    };
+
+    std::string basePath;
+    std::string extension;
+    FileType format;
+    u32 resolution;
+    u32 tileSize;
+    u32 tilesPerAxis;
+    /// The size of a chunk in output voxels.
+    u32 chunkSize;
+    u32 chunksPerAxis;
+    u32 chunksPerTile;
+    std::vector<u32> materialColors;
+    bool materials = false;
+    bool directIo = false;
+
+    std::unique_ptr<Tile[]> tiles;
+    std::mutex writtenMutex;
+    /// Indices of all tiles which have been written to a file.
+    std::vector<usize> writtenTiles;
+    std::atomic<usize> voxelCount = 0;
+
+public:
+    /**
+     * @brief Constructs the tiled output.
+     * @param path the output path, whose extension is kept while the tile position is inserted before it
+     * @param format the file format of every tile
+     * @param resolution the output resolution
+     * @param tilesPerAxis the requested number of tiles on each axis
+     * @param chunkSize the size of a chunk in output voxels, which tiles are aligned to
+     */
+    TiledVoxelOutput(const std::string &path, FileType format, u32 resolution, u32 tilesPerAxis, u32 chunkSize);
+
+    /// Returns the edge length of a tile in voxels.
+    u32 size() const noexcept
+    {
+        return tileSize;
+    }
+
+    /// Makes tiles interpret voxel values as material indices, like IVoxelSink::useMaterials().
+    void useMaterials(std::vector<u32> colors) noexcept
+    {
+        materialColors = std::move(colors);
+        materials = true;
+    }
+
+    /// Writes tile files with direct I/O, like the single output file. See openAsyncFileOutput().
+    void useDirectIo(bool enabled) noexcept
+    {
+        directIo = enabled;
+    }
+
+    /**
+     * @brief Adds the voxels of a completed chunk to its tile and writes the tile if this was its last chunk.
+     * Chunks outside the grid are ignored.
+     * This may be called concurrently for different chunks.
+     * @param chunkMin the minimum of the chunk in output voxels
+     * @param voxels the voxels of the chunk, which may be empty
+     * @param count the number of voxels
+     * @return false if the tile couldn't be written
+     */
+    [[nodiscard]] bool completeChunk(Vec3u32 chunkMin, const Voxel32 voxels[], usize count) noexcept;
+
+    /**
+     * @brief Completes all chunks inside of a box at once, except for those which are completed with completeChunk().
+     * This way, chunks without triangles don't have to be visited one by one.
+     * Chunks outside the grid are ignored.
+     * This may be called concurrently with completeChunk().
+     * @param boxMin the inclusive minimum of the box in output voxels, aligned to chunks
+     * @param boxMax the exclusive maximum of the box in output voxels, aligned to chunks
+     * @param completedChunks the minimums of the chunks inside of the box which are completed with completeChunk()
+     * @return false if a tile couldn't be written
+     */
+    [[nodiscard]] bool completeEmptyChunks(Vec3u32 boxMin,
+                                           Vec3u32 boxMax,
+                                           const std::vector<Vec3u32> &completedChunks) noexcept;
+
+    /// Writes the manifest of all written tiles. Returns false if it couldn't be written.
+    [[nodiscard]] bool finalize() noexcept;
+
+    /// Returns the total number of voxels written to all tiles.
+    usize voxelsWritten() const noexcept
+    {
+        return voxelCount;
+    }
+
+private:
+    std::string pathOf(Vec3u32 tilePos) const;
+    usize indexOf(Vec3u32 tilePos) const noexcept
+    {
+        return (usize{tilePos.z()} * tilesPerAxis + tilePos.y()) * tilesPerAxis + tilePos.x();
+    }
+    bool completeChunks(Vec3u32 tilePos, const Voxel32 voxels[], usize count, u64 chunkCount) noexcept;
+    bool writeTile(Vec3u32 tilePos, std::vector<Voxel32> voxels) noexcept;
+};
+
+}  // namespace obj2voxel
+
+#endif  // OBJ2VOXEL_TILEDOUTPUT_HPP
@@ -0,0 +1,97 @@
+#include "tiles.hpp"
+
+#include "io.hpp"
+#include "mappedfile.hpp"
+
+#include "voxelio/log.hpp"
+#include "voxelio/stringify.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <string_view>
+
+namespace obj2voxel {
+namespace {
+
+constexpr bool isSpace(char c) noexcept
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+/// Parses one line of the manifest. Returns an error message or an empty string on success.
+std::string parseTileLine(std::string_view line, const std::string &manifestPath, TileInfo &out)
+{
+    real_type bounds[6];
+    for (real_type &bound : bounds) {
+        while (not line.empty() && isSpace(line.front())) {
+            line.remove_prefix(1);
+        }
+        const auto [end, errc] = std::from_chars(line.data(), line.data() + line.size(), bound);
+        if (errc != std::errc{}) {
+            return "expected six bounds followed by a path";
+        }
+        // from_chars accepts "nan" and "inf", which would turn into undefined voxel coordinates
+        if (not std::isfinite(bound)) {
+            return "bounds must be finite";
+        }
+        line.remove_prefix(static_cast<usize>(end - line.data()));
+    }
+    while (not line.empty() && isSpace(line.front())) {
+        line.remove_prefix(1);
+    }
+    while (not line.empty() && isSpace(line.back())) {
+        line.remove_suffix(1);
+    }
+    if (line.empty()) {
+        return "missing tile path";
+    }
+
+    out.min = Vec3{bounds};
+    out.max = Vec3{bounds + 3};
+    if (obj2voxel::min(out.min, out.max) != out.min) {
+        return "lower bound exceeds upper bound";
+    }
+
+    out.path = resolveReferencedPath(manifestPath, line);
+    return {};
+}
+
+}  // namespace
+
+std::optional<std::vector<TileInfo>> parseTileManifest(const std::string &path) noexcept
+{
+    std::optional<MappedFile> file = MappedFile::open(path);
+    if (not file.has_value()) {
+        VXIO_LOG(ERROR, "Failed to open tile manifest: \"" + path + "\"");
+        return std::nullopt;
+    }
+
+    std::string_view text{reinterpret_cast<const char *>(file->data()), file->size()};
+    std::vector<TileInfo> result;
+
+    for (usize lineNumber = 1; not text.empty(); ++lineNumber) {
+        const usize lineEnd = std::min(text.find('\n'), text.size());
+        std::string_view line = text.substr(0, lineEnd);
+        text.remove_prefix(std::min(lineEnd + 1, text.size()));
+
+        while (not line.empty() && isSpace(line.front())) {
+            line.remove_prefix(1);
+        }
+        if (line.empty() || line.front() == '#') {
+            continue;
+        }
+
+        TileInfo tile;
+        if (const std::string error = parseTileLine(line, path, tile); not error.empty()) {
+            VXIO_LOG(ERROR, "Invalid tile manifest \"" + path + "\" in line " + stringify(lineNumber) + ": " + error);
+            return std::nullopt;
+        }
+        result.push_back(std::move(tile));
+    }
+
+    VXIO_LOG(INFO, "Read tile manifest with " + stringifyLargeInt(result.size()) + " tiles");
+    return result;
+}
+
+}  // namespace obj2voxel
@@ -0,0 +1,33 @@
+#ifndef OBJ2VOXEL_TILES_HPP
+#define OBJ2VOXEL_TILES_HPP
+
+#include "triangle.hpp"
+
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace obj2voxel {
+
+/// A mesh file which is part of a tiled model, together with its bounds in model space.
+struct TileInfo {
+    std::string path;
+    Vec3 min;
+    Vec3 max;
+};
+
+/**
+ * @brief Parses a tile manifest which lists the tiles of a model that is too large to be loaded at once.
+ * Each non-empty line which doesn't start with '#' describes one tile as:
+ * <pre>minX minY minZ maxX maxY maxZ path</pre>
+ * The bounds must be finite and should contain every triangle of the tile.
+ * Triangles outside of the bounds are clamped into them when the tile is loaded.
+ * Relative paths are resolved against the directory of the manifest.
+ * @param path the manifest path
+ * @return the tiles or std::nullopt if the manifest couldn't be read
+ */
+std::optional<std::vector<TileInfo>> parseTileManifest(const std::string &path) noexcept;
+
+}  // namespace obj2voxel
+
+#endif  // OBJ2VOXEL_TILES_HPP
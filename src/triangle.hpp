@@ -7,6 +7,8 @@
 #include "voxelio/image.hpp"
 #include "voxelio/vec.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <optional>
 
 namespace obj2voxel {
@@ -143,13 +145,118 @@ struct TexturedTriangle : public Triangle {
     }
 };
 
+// TRIANGLE-CUBE OVERLAP ===============================================================================================
+
+/**
+ * @brief A separating axis test between one triangle and many axis-aligned cubes.
+ * The triangle is projected onto every axis once, so testing a cube only takes one dot product per axis.
+ * The axes of the cube itself are not tested, which means that only cubes within the bounding box of the triangle may
+ * be tested.
+ * Computations are done in double precision because coordinates can be as large as 2^27.
+ */
+class TriangleCubeTest {
+private:
+    /// The plane normal and the cross products of the three coordinate axes with the three edges.
+    static constexpr usize AXIS_COUNT = 10;
+
+    Vec<f64, 3> axes[AXIS_COUNT];
+    f64 triangleMin[AXIS_COUNT];
+    f64 triangleMax[AXIS_COUNT];
+    /// The sum of absolute components of each axis, which scales the projected radius of a cube.
+    f64 axisExtent[AXIS_COUNT];
+
+public:
+    explicit TriangleCubeTest(const Triangle &triangle) noexcept
+    {
+        Vec<f64, 3> v[3];
+        for (usize i = 0; i < 3; ++i) {
+            v[i] = triangle.v[i].cast<f64>();
+        }
+
+        axes[0] = cross(v[1] - v[0], v[2] - v[0]);
+        for (usize i = 0; i < 3; ++i) {
+            Vec<f64, 3> unit = Vec<f64, 3>::zero();
+            unit[i] = 1;
+            for (usize j = 0; j < 3; ++j) {
+                axes[1 + i * 3 + j] = cross(unit, v[(j + 1) % 3] - v[j]);
+            }
+        }
+
+        for (usize a = 0; a < AXIS_COUNT; ++a) {
+            const f64 p0 = dot(axes[a], v[0]), p1 = dot(axes[a], v[1]), p2 = dot(axes[a], v[2]);
+            triangleMin[a] = obj2voxel::min(p0, p1, p2);
+            triangleMax[a] = obj2voxel::max(p0, p1, p2);
+            const Vec<f64, 3> absAxis = obj2voxel::abs(axes[a]);
+            axisExtent[a] = absAxis.x() + absAxis.y() + absAxis.z();
+        }
+    }
+
+    /// Returns true if the triangle intersects or touches the cube with the given minimum corner and edge length.
+    bool intersects(Vec<f64, 3> cubeMin, f64 size) const noexcept
+    {
+        const f64 halfSize = size / 2;
+        const Vec<f64, 3> center = cubeMin + Vec<f64, 3>::filledWith(halfSize);
+        for (usize a = 0; a < AXIS_COUNT; ++a) {
+            const f64 projectedCenter = dot(axes[a], center);
+            const f64 projectedRadius = halfSize * axisExtent[a];
+            if (triangleMin[a] > projectedCenter + projectedRadius ||
+                triangleMax[a] < projectedCenter - projectedRadius) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+// TEXTURES ============================================================================================================
+
+/// Caller-owned 8-bit pixel memory which is sampled in place instead of being copied into an image.
+struct BorrowedPixels {
+    const u8 *data;
+    usize width;
+    usize height;
+    /// The distance in bytes between the beginnings of two consecutive rows.
+    usize stride;
+    usize channels;
+    /// Byte offsets of the red, green and blue channel within a pixel.
+    u8 rgbOffsets[3];
+    /// Byte offset of the alpha channel within a pixel, or channels if there is no alpha channel.
+    u8 alphaOffset;
+    WrapMode wrapMode = WrapMode::REPEAT;
+
+    Color32 getPixel(usize x, usize y) const noexcept
+    {
+        const u8 *pixel = data + y * stride + x * channels;
+        const u8 alpha = alphaOffset < channels ? pixel[alphaOffset] : u8{0xff};
+        return Color32{pixel[rgbOffsets[0]], pixel[rgbOffsets[1]], pixel[rgbOffsets[2]], alpha};
+    }
+
+    Color32 getPixel(Vec2f uv) const noexcept
+    {
+        float u = uv[0], v = uv[1];
+        if (wrapMode == WrapMode::REPEAT) {
+            u -= std::floor(u);
+            v -= std::floor(v);
+        }
+        else {
+            u = std::clamp(u, 0.f, 1.f);
+            v = std::clamp(v, 0.f, 1.f);
+        }
+        const usize x = std::min(static_cast<usize>(u * static_cast<float>(width)), width - 1);
+        const usize y = std::min(static_cast<usize>(v * static_cast<float>(height)), height - 1);
+        return getPixel(x, y);
+    }
+};
+
 }  // namespace obj2voxel
 
 // API TYPES ===========================================================================================================
 
-/// Wrapper class for voxelio images.
+/// Wrapper class for voxelio images or borrowed pixel memory.
 struct obj2voxel_texture {
     std::optional<voxelio::Image> image;
+    /// Pixels owned by the caller, which take precedence over the image if present.
+    std::optional<obj2voxel::BorrowedPixels> borrowed;
 
     /// Leaves the image uninitialized.
     obj2voxel_texture() : image{std::nullopt} {}
@@ -157,12 +264,32 @@ struct obj2voxel_texture {
     /// Constructs the texture from a voxelio image.
     obj2voxel_texture(voxelio::Image image) : image{std::move(image)} {}
 
+    /// Returns true if the texture has either an image or borrowed pixels.
+    bool isLoaded() const
+    {
+        return image.has_value() || borrowed.has_value();
+    }
+
     /// Returns the color at the given uv coordinates as a vector.
     voxelio::Vec3f get(voxelio::Vec2f uv) const
     {
-        VXIO_DEBUG_ASSERT(image.has_value());
         // TODO move uv transformation on y-axis here instead of doing it in VisualTriangle
-        return image->getPixel(uv).vecf();
+        return sample(uv).vecf();
+    }
+
+    /// Returns the color at the given uv coordinates as a vector and assigns its alpha in [0, 1].
+    voxelio::Vec3f get(voxelio::Vec2f uv, float &outAlpha) const
+    {
+        const voxelio::Color32 color = sample(uv);
+        outAlpha = static_cast<float>(color.a) / 255;
+        return color.vecf();
+    }
+
+private:
+    voxelio::Color32 sample(voxelio::Vec2f uv) const
+    {
+        VXIO_DEBUG_ASSERT(isLoaded());
+        return borrowed.has_value() ? borrowed->getPixel(uv) : image->getPixel(uv);
     }
 };
 
@@ -173,6 +300,8 @@ struct obj2voxel_triangle : public obj2voxel::TexturedTriangle {
         const obj2voxel_texture *texture;
         obj2voxel::Vec3f color;
     };
+    /// The index of the triangle's material, where 0 means that the triangle has no material.
+    uint32_t material = 0;
 
     obj2voxel_triangle() : texture{nullptr} {}
 
@@ -192,6 +321,17 @@ struct obj2voxel_triangle : public obj2voxel::TexturedTriangle {
         }
         VXIO_DEBUG_ASSERT_UNREACHABLE();
     }
+
+    /// Like colorAt_f(uv), but also assigns the alpha at the given uv coordinates, which is 1 for untextured triangles.
+    obj2voxel::Vec3f colorAt_f(obj2voxel::Vec2f uv, float &outAlpha) const
+    {
+        if (type != obj2voxel::TriangleType::TEXTURED) {
+            outAlpha = 1;
+            return colorAt_f(uv);
+        }
+        VXIO_DEBUG_ASSERT_NOTNULL(texture);
+        return texture->get({uv.x(), 1 - uv.y()}, outAlpha);
+    }
 };
 
 #endif  // OBJ2VOXEL_TRIANGLE_HPP
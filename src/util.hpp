@@ -6,6 +6,7 @@
 #include "voxelio/types.hpp"
 #include "voxelio/vec.hpp"
 
+#include <algorithm>
 #include <unordered_map>
 
 namespace obj2voxel {
@@ -156,6 +157,34 @@ struct Weighted {
 using WeightedColor = Weighted<Vec<real_type, 3>>;
 using WeightedUv = Weighted<Vec<real_type, 2>>;
 
+/**
+ * @brief Encodes a direction as an octahedral normal with two 16-bit components.
+ * The direction is projected onto an octahedron which is then unfolded into the unit square.
+ * The x-component is stored in the upper 16 bits, the y-component in the lower 16 bits, where [0, 65535] maps to
+ * [-1, 1].
+ * Zero vectors are encoded as +z.
+ * @param direction the direction, which does not need to be normalized
+ * @return the encoded normal
+ */
+inline u32 encodeOctahedralNormal(Vec<real_type, 3> direction) noexcept
+{
+    const real_type manhattanLength = std::abs(direction.x()) + std::abs(direction.y()) + std::abs(direction.z());
+    real_type x = manhattanLength == 0 ? 0 : direction.x() / manhattanLength;
+    real_type y = manhattanLength == 0 ? 0 : direction.y() / manhattanLength;
+    if (direction.z() < 0) {
+        // the lower half of the octahedron is folded over the diagonals
+        const real_type foldedX = (1 - std::abs(y)) * (x < 0 ? -1 : 1);
+        const real_type foldedY = (1 - std::abs(x)) * (y < 0 ? -1 : 1);
+        x = foldedX;
+        y = foldedY;
+    }
+    const auto quantize = [](real_type component) -> u32 {
+        return static_cast<u32>((std::clamp<real_type>(component, -1, 1) * real_type{0.5} + real_type{0.5}) * 65535 +
+                                real_type{0.5});
+    };
+    return quantize(x) << 16 | quantize(y);
+}
+
 /// Mixes two colors based on their weights.
 template <typename T>
 constexpr Weighted<T> mix(const Weighted<T> &lhs, const Weighted<T> &rhs)
@@ -176,6 +205,9 @@ using WeightedCombineFunction = Weighted<T> (*)(const Weighted<T> &, const Weigh
 
 // VOXEL MAP ===========================================================================================================
 
+/// A map of voxels with Morton indices as keys.
+/// Keys are local to the chunk which is being voxelized, so the 21 bits per axis of a Morton index never limit the
+/// resolution of the grid.
 template <typename T>
 struct VoxelMap : public std::unordered_map<u64, T> {
     using base_type = std::unordered_map<u64, T>;
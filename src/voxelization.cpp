@@ -2,7 +2,9 @@
 
 #include "constants.hpp"
 
+#include <algorithm>
 #include <cmath>
+#include <functional>
 
 namespace obj2voxel {
 
@@ -427,6 +429,7 @@ void voxelizeSubTriangle(const VisualTriangle &inputTriangle,
                          TexturedTriangle subTriangle,
                          Vec3u32 min,
                          Vec3u32 max,
+                         Topology topology,
                          split_buffer_type *preSplitBuffer,
                          split_buffer_type *postSplitBuffer,
                          VoxelMap<WeightedUv> &out) noexcept
@@ -436,6 +439,10 @@ void voxelizeSubTriangle(const VisualTriangle &inputTriangle,
 
     const Vec3 planeOrg = subTriangle.vertex(0);
     const Vec3 planeNormal = normalize(subTriangle.normal());
+    // Along the dominant axis, consecutive voxel centers are this far apart from the plane.
+    // A window of this size around the plane contains exactly one voxel center per column.
+    const Vec3 absNormal = abs(planeNormal);
+    const real_type thinLimit = obj2voxel::max(absNormal.x(), absNormal.y(), absNormal.z()) / 2;
 
     Vec3u32 triangleMin = subTriangle.voxelMin();
     triangleMin = obj2voxel::max(min, triangleMin);
@@ -448,7 +455,16 @@ void voxelizeSubTriangle(const VisualTriangle &inputTriangle,
             for (u32 x = triangleMin.x(); x < triangleMax.x(); ++x) {
                 const Vec3u32 pos = {x, y, z};
 
-                if constexpr (ENABLE_PLANE_DISTANCE_TEST) {
+                if (topology == Topology::THIN) {
+                    const Vec3 center = pos + Vec3::filledWith(0.5f);
+                    const real_type signedDistance = distance_point_plane(center, planeOrg, planeNormal);
+
+                    // the window is half-open so that a plane through two centers only keeps one of them
+                    if (signedDistance <= -thinLimit || signedDistance > thinLimit) {
+                        continue;
+                    }
+                }
+                else if constexpr (ENABLE_PLANE_DISTANCE_TEST) {
                     const Vec3 center = pos + Vec3::filledWith(0.5f);
                     const real_type signedDistance = distance_point_plane(center, planeOrg, planeNormal);
 
@@ -464,7 +480,7 @@ void voxelizeSubTriangle(const VisualTriangle &inputTriangle,
                 WeightedUv uv = computeTrianglesUvInVoxel(inputTriangle, pos, preSplitBuffer, postSplitBuffer);
 
                 if (not eqExactly(uv.weight, 0.f)) {
-                    insertWeighted<ColorStrategy::BLEND>(out, pos, uv);
+                    insertWeighted<ColorStrategy::BLEND>(out, pos - min, uv);
                 }
             }
         }
@@ -475,11 +491,26 @@ void voxelizeSubTriangle(const VisualTriangle &inputTriangle,
 
 // VOXELIZER IMPLEMENTATION ============================================================================================
 
-Voxelizer::Voxelizer(ColorStrategy colorStrategy) noexcept : combineFunction{combineFunctionOf(colorStrategy)} {}
+Voxelizer::Voxelizer(ColorStrategy colorStrategy,
+                     Topology topology,
+                     VoxelAttribute attribute,
+                     bool accumulateNormals,
+                     float alphaCutoff) noexcept
+    : combineFunction{combineFunctionOf(colorStrategy)}
+    , deferShading{colorStrategy == ColorStrategy::MAX || attribute == VoxelAttribute::MATERIAL}
+    , topology{topology}
+    , attribute{attribute}
+    , accumulateNormals{accumulateNormals}
+    , alphaCutoff{alphaCutoff}
+{
+}
 
 void Voxelizer::voxelize(const VisualTriangle &triangle, Vec3u32 min, Vec3u32 max) noexcept
 {
     VXIO_ASSERT(uvBuffer.empty());
+    // all voxels of a chunk share its origin, so it may only change once the previous chunk has been cleared
+    VXIO_DEBUG_ASSERT((voxelCount() == 0 && fragments.empty()) || min == origin);
+    origin = min;
 
     voxelizeTriangleToUvBuffer(triangle, min, max);
     moveUvBufferIntoVoxels(triangle);
@@ -497,7 +528,8 @@ void Voxelizer::voxelizeTriangleToUvBuffer(const VisualTriangle &inputTriangle,
         if constexpr (build::DEBUG) {
             globalTriangleDebugCallback(subTriangle);
         }
-        voxelizeSubTriangle(inputTriangle, subTriangle, min, max, &preSplitBuffer, &postSplitBuffer, uvBuffer);
+        voxelizeSubTriangle(
+            inputTriangle, subTriangle, min, max, topology, &preSplitBuffer, &postSplitBuffer, uvBuffer);
     };
 
     if (isRoughlyAlignedWithAnyAxisPlane(inputTriangle)) {
@@ -512,45 +544,121 @@ void Voxelizer::voxelizeTriangleToUvBuffer(const VisualTriangle &inputTriangle,
 
 void Voxelizer::moveUvBufferIntoVoxels(const VisualTriangle &inputTriangle) noexcept
 {
-    for (auto &[index, weightedUv] : uvBuffer) {
-        Vec3u32 pos = uvBuffer.posOf(index);
-        Vec3f colorVec = inputTriangle.colorAt_f(weightedUv.value);
-        WeightedColor color = {weightedUv.weight, colorVec};
+    const Vec3 normal = accumulateNormals ? normalize(inputTriangle.normal()) : Vec3{};
+
+    if (deferShading) {
+        // Transparent fragments must not become candidates, otherwise a transparent winner would discard voxels which
+        // are also hit by opaque fragments. Only the alpha is needed here, the color is still sampled once per voxel.
+        const bool testAlpha = alphaCutoff > 0 && attribute == VoxelAttribute::COLOR;
+        for (auto &[index, weightedUv] : uvBuffer) {
+            if (testAlpha) {
+                float alpha;
+                inputTriangle.colorAt_f(weightedUv.value, alpha);
+                if (alpha < alphaCutoff) {
+                    continue;
+                }
+            }
+            if (accumulateNormals) {
+                normals[index] += normal * weightedUv.weight;
+            }
+            const WeightedFragment fragment{weightedUv.weight, {&inputTriangle, weightedUv.value}};
+
+            // same semantics as the MAX combine function: the later fragment only wins if it is strictly greater
+            auto [location, success] = fragments.emplace(index, fragment);
+            if (not success && fragment.weight > location->second.weight) {
+                location->second = fragment;
+            }
+        }
+        uvBuffer.clear();
+        return;
+    }
 
-        auto [location, success] = voxels_.emplace(pos, color);
-        if (not success) {
-            location->second = this->combineFunction(color, location->second);
+    for (auto &[index, weightedUv] : uvBuffer) {
+        float alpha;
+        Vec3f colorVec = inputTriangle.colorAt_f(weightedUv.value, alpha);
+        if (alpha >= alphaCutoff) {
+            insertColor(index, {weightedUv.weight, colorVec});
+            if (accumulateNormals) {
+                normals[index] += normal * weightedUv.weight;
+            }
         }
     }
     uvBuffer.clear();
 }
 
-void Voxelizer::merge(VoxelMap<WeightedColor> &target, VoxelMap<WeightedColor> &source) noexcept
+void Voxelizer::insertColor(u64 index, const WeightedColor &color) noexcept
 {
-    for (auto &[index, color] : source) {
-        auto [location, success] = target.emplace(index, color);
-        if (not success) {
-            location->second = this->combineFunction(color, location->second);
-        }
+    auto [location, success] = voxels_.emplace(index, color);
+    if (not success) {
+        location->second = this->combineFunction(color, location->second);
     }
 }
 
-void Voxelizer::downscale() noexcept
+void Voxelizer::resolveColors() noexcept
 {
-    constexpr u32 divisor = 2;
+    if (fragments.empty()) {
+        return;
+    }
+
+    if (attribute == VoxelAttribute::MATERIAL) {
+        // the fragments already hold the winning triangle, so there is nothing left to sample
+        for (const auto &[index, fragment] : fragments) {
+            materials.emplace(index, WeightedMaterial{fragment.weight, fragment.value.triangle->material});
+        }
+        fragments.clear();
+        return;
+    }
 
-    VoxelMap<WeightedColor> result;
+    shadingBuffer.assign(fragments.begin(), fragments.end());
+    fragments.clear();
+
+    // Untextured fragments have a null key and end up first, textured fragments are grouped by texture.
+    const auto textureKeyOf = [](const WeightedFragment &fragment) -> const Texture * {
+        return fragment.value.triangle->type == TriangleType::TEXTURED ? fragment.value.triangle->texture : nullptr;
+    };
+    std::sort(shadingBuffer.begin(), shadingBuffer.end(), [&textureKeyOf](const auto &lhs, const auto &rhs) {
+        return std::less<const Texture *>{}(textureKeyOf(lhs.second), textureKeyOf(rhs.second));
+    });
 
-    for (auto iter = voxels_.begin(); iter != voxels_.end(); iter = voxels_.erase(iter)) {
-        u64 index = iter->first;
+    for (const auto &[index, fragment] : shadingBuffer) {
+        // transparent fragments were already discarded in moveUvBufferIntoVoxels()
+        insertColor(index, {fragment.weight, fragment.value.triangle->colorAt_f(fragment.value.uv)});
+    }
+    shadingBuffer.clear();
+}
 
-        auto [location, success] = voxels_.emplace(index / divisor, iter->second);
-        if (not success) {
-            location->second = this->combineFunction(iter->second, location->second);
+void Voxelizer::downscale() noexcept
+{
+    // Halving all coordinates removes the lowest bit of each axis, which are the lowest three bits of a Morton index.
+    // Chunk origins are even, so halving the origin and the local coordinates separately is exact.
+    constexpr u32 mortonShift = 3;
+    origin /= 2;
+
+    if (accumulateNormals) {
+        VoxelMap<Vec3> source = std::move(normals);
+        normals.clear();
+        for (const auto &[index, normal] : source) {
+            normals[index >> mortonShift] += normal;
         }
     }
 
-    voxels_ = std::move(result);
+    if (attribute == VoxelAttribute::MATERIAL) {
+        VoxelMap<WeightedMaterial> source = std::move(materials);
+        materials.clear();
+        for (const auto &[index, material] : source) {
+            auto [location, success] = materials.emplace(index >> mortonShift, material);
+            if (not success) {
+                location->second = obj2voxel::max(material, location->second);
+            }
+        }
+    }
+    else {
+        VoxelMap<WeightedColor> source = std::move(voxels_);
+        voxels_.clear();
+        for (const auto &[index, color] : source) {
+            insertColor(index >> mortonShift, color);
+        }
+    }
 }
 
 }  // namespace obj2voxel
@@ -34,6 +34,23 @@ constexpr const char *nameOf(ColorStrategy strategy)
     return strategy == ColorStrategy::MAX ? "MAX" : "BLEND";
 }
 
+/// An enum which describes what information is stored in each voxel.
+enum class VoxelAttribute : obj2voxel_enum_t {
+    /// Voxels store a color sampled from their triangles.
+    COLOR = OBJ2VOXEL_ATTRIBUTE_COLOR,
+    /// Voxels store the material index of the triangle with the greatest area inside of them.
+    MATERIAL = OBJ2VOXEL_ATTRIBUTE_MATERIAL
+};
+
+/// An enum which describes which voxels intersected by a triangle become part of the surface.
+enum class Topology : obj2voxel_enum_t {
+    /// Every voxel with a non-zero intersection is kept, which produces 26-separating surfaces.
+    CONSERVATIVE = OBJ2VOXEL_CONSERVATIVE_TOPOLOGY,
+    /// Only voxels whose center lies within half a voxel of the plane along its dominant axis are kept.
+    /// This produces 6-separating surfaces with exactly one voxel per column along the dominant axis.
+    THIN = OBJ2VOXEL_THIN_TOPOLOGY
+};
+
 /// Parses the color strategy. This function is case sensitive.
 inline bool parseColorStrategy(const std::string &str, ColorStrategy &out)
 {
@@ -48,6 +65,15 @@ inline bool parseColorStrategy(const std::string &str, ColorStrategy &out)
     return false;
 }
 
+/// A reference to the fragment of a triangle inside a voxel whose color has not been sampled yet.
+struct Fragment {
+    const VisualTriangle *triangle;
+    Vec2f uv;
+};
+
+using WeightedFragment = Weighted<Fragment>;
+using WeightedMaterial = Weighted<u32>;
+
 /// Throwaway class which manages all necessary data structures for voxelization and simplifies the procedure from the
 /// caller's side to just using voxelize(triangle).
 ///
@@ -62,34 +88,108 @@ private:
     split_buffer_type postSplitBuffer;
     VoxelMap<WeightedUv> uvBuffer;
     VoxelMap<WeightedColor> voxels_;
+    VoxelMap<WeightedMaterial> materials;
+    /// Sums of area-weighted triangle normals, only filled if normals are accumulated.
+    VoxelMap<Vec3> normals;
+    /// The winning fragment of each voxel when shading is deferred.
+    VoxelMap<WeightedFragment> fragments;
+    std::vector<std::pair<u64, WeightedFragment>> shadingBuffer;
+    /// The minimum of the chunk being voxelized, which all keys of the voxel maps are relative to.
+    Vec3u32 origin{};
     WeightedCombineFunction<Vec3f> combineFunction;
+    /// True if colors are only sampled once per voxel in resolveColors() instead of once per fragment.
+    /// This is only possible for ColorStrategy::MAX, where all fragments but one are discarded anyway.
+    /// Materials are always deferred because they are chosen with the same semantics.
+    bool deferShading;
+    Topology topology;
+    VoxelAttribute attribute;
+    bool accumulateNormals;
+    /// Fragments whose sampled alpha is below this value are discarded.
+    float alphaCutoff;
 
 public:
-    Voxelizer(ColorStrategy colorStrategy) noexcept;
+    Voxelizer(ColorStrategy colorStrategy,
+              Topology topology = Topology::CONSERVATIVE,
+              VoxelAttribute attribute = VoxelAttribute::COLOR,
+              bool accumulateNormals = false,
+              float alphaCutoff = 0) noexcept;
 
     Voxelizer(const Voxelizer &) noexcept = delete;
     Voxelizer(Voxelizer &&) noexcept = default;
 
+    /**
+     * @brief Voxelizes a triangle within the given voxel bounds.
+     * If shading is deferred, the voxelizer keeps a pointer to the triangle, so it must stay alive and unmodified until
+     * resolveColors() is called.
+     * @param triangle the triangle
+     * @param min the inclusive minimum voxel
+     * @param max the exclusive maximum voxel
+     */
     void voxelize(const VisualTriangle &triangle, Vec3u32 min, Vec3u32 max) noexcept;
 
-    void mergeResults(VoxelMap<WeightedColor> &out) noexcept
-    {
-        merge(out, voxels_);
-    }
-
-    void merge(VoxelMap<WeightedColor> &target, VoxelMap<WeightedColor> &source) noexcept;
+    /**
+     * @brief Samples the colors or looks up the materials of all deferred fragments and stores them as voxels.
+     * Fragments are grouped by texture before sampling to improve cache locality.
+     * This must be called after all triangles of a chunk have been voxelized and before accessing the voxels.
+     */
+    void resolveColors() noexcept;
 
     /**
      * @brief Scales down the voxels of the voxelizer to half the original resolution.
      */
     void downscale() noexcept;
 
-    VoxelMap<WeightedColor> &voxels() noexcept
+    /// Returns the number of accumulated voxels.
+    usize voxelCount() const noexcept
     {
-        return voxels_;
+        if (attribute == VoxelAttribute::MATERIAL) {
+            return materials.size();
+        }
+        return voxels_.size();
+    }
+
+    /// Invokes the action with the position and the value of each accumulated voxel.
+    /// The value is an ARGB color or a material index, depending on the voxel attribute.
+    template <typename Action>
+    void forEachVoxel(Action action) const noexcept
+    {
+        if (attribute == VoxelAttribute::MATERIAL) {
+            for (const auto &[index, material] : materials) {
+                action(positionOf(index), material.value);
+            }
+        }
+        else {
+            for (const auto &[index, color] : voxels_) {
+                action(positionOf(index), Color32{color.value}.argb());
+            }
+        }
+    }
+
+    /// Invokes the action with the position and the octahedral normal of each accumulated voxel.
+    /// Normals are only available if they are accumulated, otherwise the action is never invoked.
+    template <typename Action>
+    void forEachNormal(Action action) const noexcept
+    {
+        for (const auto &[index, normal] : normals) {
+            action(positionOf(index), encodeOctahedralNormal(normal));
+        }
+    }
+
+    /// Removes all accumulated voxels.
+    void clearVoxels() noexcept
+    {
+        voxels_.clear();
+        materials.clear();
+        normals.clear();
     }
 
 private:
+    /// Returns the position of the voxel with the given chunk-local Morton index.
+    Vec3u32 positionOf(u64 index) const noexcept
+    {
+        return origin + VoxelMap<Vec3>::posOf(index);
+    }
+
     /**
      * @brief Voxelizes a triangle.
      *
@@ -105,6 +205,9 @@ private:
     void voxelizeTriangleToUvBuffer(const VisualTriangle &inputTriangle, Vec3u32 min, Vec3u32 max) noexcept;
 
     void moveUvBufferIntoVoxels(const VisualTriangle &inputTriangle) noexcept;
+
+    /// Combines a color with the voxel at the given index.
+    void insertColor(u64 index, const WeightedColor &color) noexcept;
 };
 
 }  // namespace obj2voxel
@@ -4,6 +4,13 @@
 #include "voxelio/format/vl32.hpp"
 #include "voxelio/log.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <set>
+#include <thread>
 #include <vector>
 
 std::vector<NamedTest> tests;
@@ -37,6 +44,23 @@ constexpr std::array<size_t, 6 * 4> unitCubeElements{
     1, 5, 7, 3
 };
 
+// every face of the unit cube twice, the second time with opposite winding, plus one degenerate quad
+constexpr std::array<size_t, 13 * 4> duplicatedUnitCubeElements{
+    0, 1, 3, 2,
+    4, 6, 7, 5,
+    0, 4, 5, 1,
+    2, 3, 7, 6,
+    0, 2, 6, 4,
+    1, 5, 7, 3,
+    3, 1, 0, 2,
+    7, 6, 4, 5,
+    5, 4, 0, 1,
+    7, 3, 2, 6,
+    6, 2, 0, 4,
+    7, 5, 1, 3,
+    0, 0, 1, 1
+};
+
 constexpr std::array<float, 3 * 4 * 3> threePlanesVertices{
     .0, 0, 0,
     .0, 0, 1,
@@ -178,6 +202,40 @@ TEST(unitCubeProducesExpectedByteCount)
     VXIO_ASSERT_EQ(size, expectedBytes);
 }
 
+TEST(directIoFileOutputMatchesMemoryOutput)
+{
+    // large enough to span multiple write buffers and to end with a partial block
+    constexpr size_t resolution = 256;
+
+    IndexedQuadInput input{unitCubeVertices.data(), unitCubeElements.data(), unitCubeElements.size()};
+
+    obj2voxel_instance *instance = obj2voxel_alloc();
+    obj2voxel_set_input_callback(instance, &inputCallback<IndexedQuadInput>, &input);
+    obj2voxel_set_output_memory(instance, "vl32");
+    obj2voxel_set_resolution(instance, resolution);
+    VXIO_ASSERT_EQ(obj2voxel_voxelize(instance), OBJ2VOXEL_ERR_OK);
+
+    size_t size;
+    const auto *memory = reinterpret_cast<const char *>(obj2voxel_get_output_memory(instance, &size));
+    VXIO_ASSERT_NOTNULL(memory);
+    const std::string expected{memory, size};
+    obj2voxel_free(instance);
+
+    IndexedQuadInput fileInput{unitCubeVertices.data(), unitCubeElements.data(), unitCubeElements.size()};
+    instance = obj2voxel_alloc();
+    obj2voxel_set_input_callback(instance, &inputCallback<IndexedQuadInput>, &fileInput);
+    obj2voxel_set_output_file(instance, "/tmp/obj2voxel_direct.vl32", nullptr);
+    obj2voxel_set_direct_io(instance, true);
+    obj2voxel_set_resolution(instance, resolution);
+    VXIO_ASSERT_EQ(obj2voxel_voxelize(instance), OBJ2VOXEL_ERR_OK);
+    obj2voxel_free(instance);
+
+    std::ifstream file{"/tmp/obj2voxel_direct.vl32", std::ios::binary};
+    const std::string actual{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+    VXIO_ASSERT_EQ(actual.size(), expected.size());
+    VXIO_ASSERT(actual == expected);
+}
+
 void testVoxelProduction(obj2voxel_instance *instance, size_t expectedVoxels)
 {
     CountingOutput output;
@@ -207,6 +265,1403 @@ TEST(unitCubeProducesExpectedVoxelCountForMultipleChunks)
     testVoxelProduction(instance, expectedVoxels);
 }
 
+void recordCompletion(void *callbackData, obj2voxel_error_t result)
+{
+    *static_cast<int *>(callbackData) = result == OBJ2VOXEL_ERR_OK ? 1 : -1;
+}
+
+TEST(asyncVoxelizationCompletesWithSameResult)
+{
+    constexpr size_t resolution = 64;
+    constexpr size_t expectedVoxels = expectedUnitCubeVoxels(resolution);
+
+    IndexedQuadInput input{unitCubeVertices.data(), unitCubeElements.data(), unitCubeElements.size()};
+    CountingOutput output;
+    int completion = 0;
+
+    obj2voxel_instance *instance = obj2voxel_alloc();
+    obj2voxel_set_input_callback(instance, &inputCallback<IndexedQuadInput>, &input);
+    obj2voxel_set_output_callback(instance, &outputCallback<CountingOutput>, &output);
+    obj2voxel_set_resolution(instance, resolution);
+    obj2voxel_set_completion_callback(instance, &recordCompletion, &completion);
+
+    VXIO_ASSERT(not obj2voxel_wait(instance, 0, nullptr));
+    VXIO_ASSERT_EQ(obj2voxel_voxelize_async(instance), OBJ2VOXEL_ERR_OK);
+    VXIO_ASSERT_EQ(obj2voxel_voxelize_async(instance), OBJ2VOXEL_ERR_DOUBLE_VOXELIZATION);
+
+    obj2voxel_error_t result = OBJ2VOXEL_ERR_NO_INPUT;
+    VXIO_ASSERT(obj2voxel_wait(instance, -1, &result));
+    VXIO_ASSERT_EQ(result, OBJ2VOXEL_ERR_OK);
+    VXIO_ASSERT(obj2voxel_poll(instance, nullptr));
+    // the callback runs on the voxelization thread, which is joined when freeing
+    obj2voxel_free(instance);
+
+    VXIO_ASSERT_EQ(completion, 1);
+    VXIO_ASSERT_EQ(output.voxelCount, expectedVoxels);
+}
+
+/// Pushes the unit cube into an instance with one thread per face, which pushes one triangle per call.
+void pushUnitCubeFromManyThreads(obj2voxel_instance *instance)
+{
+    std::vector<float> vertices;
+    for (size_t i = 0; i < unitCubeElements.size(); i += 4) {
+        for (size_t corner : {0, 1, 2, 0, 2, 3}) {
+            const float *vertex = unitCubeVertices.data() + unitCubeElements[i + corner] * 3;
+            vertices.insert(vertices.end(), vertex, vertex + 3);
+        }
+    }
+
+    std::vector<std::thread> producers;
+    for (size_t face = 0; face < unitCubeElements.size() / 4; ++face) {
+        producers.emplace_back([instance, &vertices, face] {
+            obj2voxel_push_triangles(instance, vertices.data() + face * 18, nullptr, 1);
+            obj2voxel_push_triangles(instance, vertices.data() + face * 18 + 9, nullptr, 1);
+        });
+    }
+    for (std::thread &producer : producers) {
+        producer.join();
+    }
+}
+
+TEST(errorOnUnfinishedPushedInput)
+{
+    pushLogLevel(OBJ2VOXEL_LOG_LEVEL_SILENT);
+
+    CountingOutput output;
+
+    obj2voxel_instance *instance = obj2voxel_alloc();
+    obj2voxel_set_output_callback(instance, &outputCallback<CountingOutput>, &output);
+    obj2voxel_set_resolution(instance, 8);
+    pushUnitCubeFromManyThreads(instance);
+    obj2voxel_error_t result = obj2voxel_voxelize(instance);
+    obj2voxel_free(instance);
+
+    popLogLevel();
+
+    VXIO_ASSERT_EQ(result, OBJ2VOXEL_ERR_NO_INPUT);
+}
+
+TEST(trianglesPushedFromManyThreadsProduceExpectedVoxelCount)
+{
+    constexpr size_t resolution = 64;
+    constexpr size_t expectedVoxels = expectedUnitCubeVoxels(resolution);
+
+    CountingOutput output;
+
+    obj2voxel_instance *instance = obj2voxel_alloc();
+    obj2voxel_set_output_callback(instance, &outputCallback<CountingOutput>, &output);
+    obj2voxel_set_resolution(instance, resolution);
+    pushUnitCubeFromManyThreads(instance);
+    obj2voxel_finish_input(instance);
+    obj2voxel_error_t result = obj2voxel_voxelize(instance);
+    obj2voxel_free(instance);
+
+    VXIO_ASSERT_EQ(result, OBJ2VOXEL_ERR_OK);
+    VXIO_ASSERT_EQ(output.voxelCount, expectedVoxels);
+}
+
+/// Writes the triangles of some quads of a mesh into a binary STL file.
+void writeQuadsAsStl(const std::string &path, const float *vertices, const size_t *quads, size_t quadCount)
+{
+    std::optional<voxelio::FileOutputStream> stream = voxelio::FileOutputStream::open(path);
+    VXIO_ASSERT(stream.has_value());
+
+    const std::string header(80, ' ');
+    stream->writeString(header);
+    stream->writeLittle<uint32_t>(static_cast<uint32_t>(quadCount * 2));
+    for (size_t i = 0; i < quadCount; ++i) {
+        const size_t *quad = quads + i * 4;
+        for (const std::array<size_t, 3> &triangle : {std::array{quad[0], quad[1], quad[2]},
+                                                      std::array{quad[0], quad[2], quad[3]}}) {
+            const float normal[3]{};
+            stream->writeLittle<3, float>(normal);
+            for (size_t vertex : triangle) {
+                stream->writeLittle<3, float>(vertices + vertex * 3);
+            }
+            stream->writeLittle<uint16_t>(0);
+        }
+    }
+    VXIO_ASSERT(not stream->err());
+}
+
+TEST(stlFromStandardInputProducesExpectedVoxelCount)
+{
+    constexpr size_t resolution = 64;
+    constexpr size_t expectedVoxels = expectedUnitCubeVoxels(resolution);
+
+    writeQuadsAsStl("/tmp/obj2voxel_stdin.stl", unitCubeVertices.data(), unitCubeElements.data(), 6);
+    // the tests don't read standard input otherwise, so it is replaced for good
+    VXIO_ASSERT_NOTNULL(std::freopen("/tmp/obj2voxel_stdin.stl", "rb", stdin));
+
+    obj2voxel_instance *instance = obj2voxel_alloc();
+    obj2voxel_set_input_file(instance, "-", "stl");
+    obj2voxel_set_resolution(instance, resolution);
+
+    testVoxelProduction(instance, expectedVoxels);
+}
+
+TEST(largeAsciiStlIsSplitAtFacetBoundaries)
+{
+    constexpr size_t resolution = 64;
+    constexpr size_t cubeCopies = 2000;
+
+    // the file is larger than two pieces, which are parsed separately and must neither lose nor duplicate facets
+    std::ofstream stream{"/tmp/obj2voxel_ascii.stl"};
+    stream << "solid cubes\n";
+    for (size_t copy = 0; copy < cubeCopies; ++copy) {
+        for (size_t quad = 0; quad < 6; ++quad) {
+            const size_t *corners = unitCubeElements.data() + quad * 4;
+            for (const std::array<size_t, 3> &triangle : {std::array{corners[0], corners[1], corners[2]},
+                                                          std::array{corners[0], corners[2], corners[3]}}) {
+                stream << "  facet normal 0 0 0\n    outer loop\n";
+                for (size_t vertex : triangle) {
+                    const float *position = unitCubeVertices.data() + vertex * 3;
+                    stream << "      vertex " << position[0] << ' ' << position[1] << ' ' << position[2] << '\n';
+                }
+                stream << "    endloop\n  endfacet\n";
+            }
+        }
+    }
+    stream << "endsolid cubes\n";
+    VXIO_ASSERT_GT(static_cast<size_t>(stream.tellp()), 2u * 1024 * 1024);
+    stream.close();
+
+    CountingOutput output;
+    obj2voxel_instance *instance = obj2voxel_alloc();
+    obj2voxel_set_input_file(instance, "/tmp/obj2voxel_ascii.stl", "stl");
+    obj2voxel_set_output_callback(instance, &outputCallback<CountingOutput>, &output);
+    obj2voxel_set_resolution(instance, resolution);
+    obj2voxel_error_t result = obj2voxel_voxelize(instance);
+
+    uint64_t degenerateTriangles, duplicateTriangles;
+    obj2voxel_get_culled_triangle_counts(instance, &degenerateTriangles, &duplicateTriangles);
+    obj2voxel_free(instance);
+
+    VXIO_ASSERT_EQ(result, OBJ2VOXEL_ERR_OK);
+    VXIO_ASSERT_EQ(output.voxelCount, expectedUnitCubeVoxels(resolution));
+    // every copy but the first is culled, so the count reveals facets which got lost or parsed twice
+    VXIO_ASSERT_EQ(degenerateTriangles, 0u);
+    VXIO_ASSERT_EQ(duplicateTriangles, (cubeCopies - 1) * 12);
+}
+
+// a single orange pixel, which is the smallest texture that mesh files can reference
+constexpr std::array<uint8_t, 69> orangePixelPng{
+    0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a, 0x00, 0x00, 0x00, 0x0d, 0x49, 0x48, 0x44, 0x52, 0x00, 0x00,
+    0x00, 0x01, 0x00, 0x00, 0x00, 0x01, 0x08, 0x02, 0x00, 0x00, 0x00, 0x90, 0x77, 0x53, 0xde, 0x00, 0x00, 0x00,
+    0x0c, 0x49, 0x44, 0x41, 0x54, 0x78, 0x9c, 0x63, 0xf8, 0xdf, 0xc0, 0x00, 0x00, 0x04, 0x01, 0x01, 0x80, 0xc5,
+    0x2a, 0x18, 0x5d, 0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4e, 0x44, 0xae, 0x42, 0x60, 0x82};
+
+/// Writes the unit cube into a binary PLY file with quad faces and per-face texture coordinates.
+void writeUnitCubeAsPly(const std::string &path, size_t texcoordsPerFace)
+{
+    std::optional<voxelio::FileOutputStream> texture = voxelio::FileOutputStream::open("/tmp/obj2voxel_ply.png");
+    VXIO_ASSERT(texture.has_value());
+    texture->write(orangePixelPng.data(), orangePixelPng.size());
+
+    std::optional<voxelio::FileOutputStream> stream = voxelio::FileOutputStream::open(path);
+    VXIO_ASSERT(stream.has_value());
+
+    stream->writeString(
+        "ply\n"
+        "format binary_little_endian 1.0\n"
+        "comment TextureFile obj2voxel_ply.png\n"
+        "element vertex 8\n"
+        "property float x\n"
+        "property float y\n"
+        "property float z\n"
+        "element face 6\n"
+        "property list uchar int vertex_indices\n"
+        "property list uchar float texcoord\n"
+        "end_header\n");
+    stream->write(reinterpret_cast<const uint8_t *>(unitCubeVertices.data()), sizeof(unitCubeVertices));
+    for (size_t face = 0; face < 6; ++face) {
+        stream->writeLittle<uint8_t>(4);
+        for (size_t corner = 0; corner < 4; ++corner) {
+            stream->writeLittle<int32_t>(static_cast<int32_t>(unitCubeElements[face * 4 + corner]));
+        }
+        stream->writeLittle<uint8_t>(static_cast<uint8_t>(texcoordsPerFace));
+        for (size_t i = 0; i < texcoordsPerFace; ++i) {
+            stream->writeLittle<float>(static_cast<float>(i % 2));
+        }
+    }
+    VXIO_ASSERT(not stream->err());
+}
+
+TEST(plyCubeProducesExpectedVoxelCount)
+{
+    constexpr size_t resolution = 64;
+    constexpr size_t expectedVoxels = expectedUnitCubeVoxels(resolution);
+
+    writeUnitCubeAsPly("/tmp/obj2voxel_test.ply", 8);
+
+    obj2voxel_instance *instance = obj2voxel_alloc();
+    obj2voxel_set_input_file(instance, "/tmp/obj2voxel_test.ply", nullptr);
+    obj2voxel_set_resolution(instance, resolution);
+
+    testVoxelProduction(instance, expectedVoxels);
+}
+
+TEST(errorOnPlyTexcoordsNotMatchingCorners)
+{
+    // three texture coordinate pairs for four corners would make the last face read past its data
+    writeUnitCubeAsPly("/tmp/obj2voxel_test.ply", 6);
+
+    pushLogLevel(OBJ2VOXEL_LOG_LEVEL_SILENT);
+
+    CountingOutput output;
+
+    obj2voxel_instance *instance = obj2voxel_alloc();
+    obj2voxel_set_input_file(instance, "/tmp/obj2voxel_test.ply", nullptr);
+    obj2voxel_set_output_callback(instance, &outputCallback<CountingOutput>, &output);
+    obj2voxel_set_resolution(instance, 64);
+    obj2voxel_error_t result = obj2voxel_voxelize(instance);
+    obj2voxel_free(instance);
+
+    popLogLevel();
+
+    VXIO_ASSERT_EQ(result, OBJ2VOXEL_ERR_IO_ERROR_ON_OPEN_INPUT_FILE);
+}
+
+TEST(objFacesUseTheColorOrTextureOfTheirMaterial)
+{
+    {
+        std::optional<voxelio::FileOutputStream> texture = voxelio::FileOutputStream::open("/tmp/obj2voxel_obj.png");
+        VXIO_ASSERT(texture.has_value());
+        texture->write(orangePixelPng.data(), orangePixelPng.size());
+    }
+    {
+        // The diffuse color of the textured material must be ignored in favor of its texture.
+        // OBJ texture paths are relative to the working directory, so the texture is referenced by its absolute path.
+        std::optional<voxelio::FileOutputStream> stream = voxelio::FileOutputStream::open("/tmp/obj2voxel_test.mtl");
+        VXIO_ASSERT(stream.has_value());
+        stream->writeString(
+            "newmtl green\nKd 0 1 0\n"
+            "newmtl blue\nKd 0 0 1\n"
+            "newmtl textured\nKd 0 1 1\nmap_Kd /tmp/obj2voxel_obj.png\n");
+    }
+    {
+        // three strips along the x-axis, far enough apart that no voxel is shared between them
+        std::optional<voxelio::FileOutputStream> stream = voxelio::FileOutputStream::open("/tmp/obj2voxel_test.obj");
+        VXIO_ASSERT(stream.has_value());
+        stream->writeString(
+            "mtllib obj2voxel_test.mtl\n"
+            "v 0 0 0\nv 0.2 0 0\nv 0.2 1 0\nv 0 1 0\n"
+            "v 0.4 0 0\nv 0.6 0 0\nv 0.6 1 0\nv 0.4 1 0\n"
+            "v 0.8 0 0\nv 1 0 0\nv 1 1 0\nv 0.8 1 0\n"
+            "vt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\n"
+            "usemtl green\nf 1 2 3\nf 1 3 4\n"
+            "usemtl blue\nf 5 6 7\nf 5 7 8\n"
+            "usemtl textured\nf 9/1 10/2 11/3\nf 9/1 11/3 12/4\n");
+    }
+
+    MapOutput output;
+    obj2voxel_instance *instance = obj2voxel_alloc();
+    obj2voxel_set_input_file(instance, "/tmp/obj2voxel_test.obj", nullptr);
+    obj2voxel_set_output_callback(instance, &outputCallback<MapOutput>, &output);
+    obj2voxel_set_resolution(instance, 32);
+    obj2voxel_error_t result = obj2voxel_voxelize(instance);
+    obj2voxel_free(instance);
+
+    VXIO_ASSERT_EQ(result, OBJ2VOXEL_ERR_OK);
+
+    constexpr std::array<uint32_t, 3> stripColors{0xff00ff00, 0xff0000ff, 0xffff8000};
+    std::array<size_t, 3> stripVoxels{};
+    for (const auto &[pos, color] : output.voxels) {
+        const size_t strip = pos[0] * 3 / 32;
+        VXIO_ASSERT_EQ(color, stripColors[strip]);
+        ++stripVoxels[strip];
+    }
+    for (size_t count : stripVoxels) {
+        VXIO_ASSERT_NE(count, 0u);
+    }
+}
+
+/**
+ * @brief Writes the unit cube into a GLB file as an indexed, textured mesh.
+ * The mesh is instanced by a child node, whose parent stretches it to twice its size along the x-axis.
+ * @param indexComponentType the component type of the index accessor, whose elements are always four bytes large
+ */
+void writeStretchedUnitCubeAsGlb(const std::string &path, uint32_t indexComponentType)
+{
+    // positions, texture coordinates, indices and the image are stored in this order at the offsets in the JSON
+    constexpr size_t imageOffset = 304;
+    constexpr size_t binSize = 376;
+    static_assert(sizeof(unitCubeVertices) + 8 * 2 * sizeof(float) + 36 * sizeof(uint32_t) == imageOffset);
+
+    std::string json =
+        R"({"asset":{"version":"2.0"},"scene":0,"scenes":[{"nodes":[0]}],)"
+        R"("nodes":[{"scale":[2,1,1],"children":[1]},{"mesh":0,"translation":[5,0,0]}],)"
+        R"("meshes":[{"primitives":[{"attributes":{"POSITION":0,"TEXCOORD_0":1},"indices":2,"material":0}]}],)"
+        R"("materials":[{"pbrMetallicRoughness":{"baseColorTexture":{"index":0}}}],)"
+        R"("textures":[{"source":0}],"images":[{"bufferView":3,"mimeType":"image/png"}],)"
+        R"("accessors":[{"bufferView":0,"componentType":5126,"count":8,"type":"VEC3"},)"
+        R"({"bufferView":1,"componentType":5126,"count":8,"type":"VEC2"},)"
+        R"({"bufferView":2,"componentType":)" +
+        voxelio::stringify(indexComponentType) + R"(,"count":36,"type":"SCALAR"}],)"
+        R"("bufferViews":[{"buffer":0,"byteOffset":0,"byteLength":96},{"buffer":0,"byteOffset":96,"byteLength":64},)"
+        R"({"buffer":0,"byteOffset":160,"byteLength":144},{"buffer":0,"byteOffset":304,"byteLength":69}],)"
+        R"("buffers":[{"byteLength":376}]})";
+    json.resize((json.size() + 3) / 4 * 4, ' ');
+
+    std::optional<voxelio::FileOutputStream> stream = voxelio::FileOutputStream::open(path);
+    VXIO_ASSERT(stream.has_value());
+
+    stream->writeLittle<uint32_t>(0x46546C67);
+    stream->writeLittle<uint32_t>(2);
+    stream->writeLittle<uint32_t>(static_cast<uint32_t>(12 + 8 + json.size() + 8 + binSize));
+    stream->writeLittle<uint32_t>(static_cast<uint32_t>(json.size()));
+    stream->writeLittle<uint32_t>(0x4E4F534A);
+    stream->writeString(json);
+    stream->writeLittle<uint32_t>(binSize);
+    stream->writeLittle<uint32_t>(0x004E4942);
+
+    stream->write(reinterpret_cast<const uint8_t *>(unitCubeVertices.data()), sizeof(unitCubeVertices));
+    for (size_t vertex = 0; vertex < 8; ++vertex) {
+        stream->writeLittle<2, float>(unitCubeVertices.data() + vertex * 3);
+    }
+    for (size_t quad = 0; quad < 6; ++quad) {
+        const size_t *corners = unitCubeElements.data() + quad * 4;
+        for (size_t corner : {corners[0], corners[1], corners[2], corners[0], corners[2], corners[3]}) {
+            stream->writeLittle<uint32_t>(static_cast<uint32_t>(corner));
+        }
+    }
+    stream->write(orangePixelPng.data(), orangePixelPng.size());
+    stream->writeString(std::string(binSize - imageOffset - orangePixelPng.size(), '\0'));
+    VXIO_ASSERT(not stream->err());
+}
+
+TEST(glbCubeWithNodeTransformMatchesTransformedMesh)
+{
+    constexpr size_t resolution = 64;
+    constexpr uint32_t unsignedInt = 5125;
+
+    std::array<float, 8 * 3> stretchedVertices = unitCubeVertices;
+    for (size_t vertex = 0; vertex < 8; ++vertex) {
+        stretchedVertices[vertex * 3] *= 2;
+    }
+    IndexedQuadInput input{stretchedVertices.data(), unitCubeElements.data(), unitCubeElements.size()};
+    CountingOutput expected;
+
+    obj2voxel_instance *instance = obj2voxel_alloc();
+    obj2voxel_set_input_callback(instance, &inputCallback<IndexedQuadInput>, &input);
+    obj2voxel_set_output_callback(instance, &outputCallback<CountingOutput>, &expected);
+    obj2voxel_set_resolution(instance, resolution);
+    VXIO_ASSERT_EQ(obj2voxel_voxelize(instance), OBJ2VOXEL_ERR_OK);
+    obj2voxel_free(instance);
+
+    writeStretchedUnitCubeAsGlb("/tmp/obj2voxel_test.glb", unsignedInt);
+
+    instance = obj2voxel_alloc();
+    obj2voxel_set_input_file(instance, "/tmp/obj2voxel_test.glb", nullptr);
+    obj2voxel_set_resolution(instance, resolution);
+
+    // the cube is only stretched if the node transforms were applied
+    VXIO_ASSERT_NE(expected.voxelCount, expectedUnitCubeVoxels(resolution));
+    testVoxelProduction(instance, expected.voxelCount);
+}
+
+TEST(errorOnGlbFloatIndices)
+{
+    constexpr uint32_t floatType = 5126;
+    writeStretchedUnitCubeAsGlb("/tmp/obj2voxel_test.glb", floatType);
+
+    pushLogLevel(OBJ2VOXEL_LOG_LEVEL_SILENT);
+
+    CountingOutput output;
+
+    obj2voxel_instance *instance = obj2voxel_alloc();
+    obj2voxel_set_input_file(instance, "/tmp/obj2voxel_test.glb", nullptr);
+    obj2voxel_set_output_callback(instance, &outputCallback<CountingOutput>, &output);
+    obj2voxel_set_resolution(instance, 64);
+    obj2voxel_error_t result = obj2voxel_voxelize(instance);
+    obj2voxel_free(instance);
+
+    popLogLevel();
+
+    VXIO_ASSERT_EQ(result, OBJ2VOXEL_ERR_IO_ERROR_ON_OPEN_INPUT_FILE);
+}
+
+TEST(tiledCubeProducesExpectedVoxelCount)
+{
+    // large enough for multiple tile regions
+    constexpr size_t resolution = 320;
+    constexpr size_t expectedVoxels = expectedUnitCubeVoxels(resolution);
+
+    // each face of the cube is a tile, stored next to the manifest
+    std::string manifest = "# minX minY minZ maxX maxY maxZ path\n";
+    for (size_t face = 0; face < 6; ++face) {
+        const std::string tileName = "obj2voxel_tile_" + voxelio::stringify(face) + ".stl";
+        writeQuadsAsStl("/tmp/" + tileName, unitCubeVertices.data(), unitCubeElements.data() + face * 4, 1);
+
+        float min[3]{1, 1, 1}, max[3]{0, 0, 0};
+        for (size_t i = 0; i < 4; ++i) {
+            const float *vertex = unitCubeVertices.data() + unitCubeElements[face * 4 + i] * 3;
+            for (size_t axis = 0; axis < 3; ++axis) {
+                min[axis] = std::min(min[axis], vertex[axis]);
+                max[axis] = std::max(max[axis], vertex[axis]);
+            }
+        }
+        for (float bound : {min[0], min[1], min[2], max[0], max[1], max[2]}) {
+            manifest += voxelio::stringify(bound) + ' ';
+        }
+        manifest += tileName + '\n';
+    }
+    {
+        std::optional<voxelio::FileOutputStream> stream = voxelio::FileOutputStream::open("/tmp/obj2voxel_test.tiles");
+        VXIO_ASSERT(stream.has_value());
+        stream->writeString(manifest);
+    }
+
+    obj2voxel_instance *instance = obj2voxel_alloc();
+    obj2voxel_set_input_file(instance, "/tmp/obj2voxel_test.tiles", nullptr);
+    obj2voxel_set_resolution(instance, resolution);
+
+    testVoxelProduction(instance, expectedVoxels);
+}
+
+TEST(culledTrianglesOfTilesAreCountedOnce)
+{
+    // a cube face, its duplicate and a degenerate quad along one of its edges, all spanning several tile regions
+    const size_t *face = unitCubeElements.data();
+    const std::array<size_t, 12> quads{face[0], face[1], face[2], face[3],
+                                       face[0], face[1], face[2], face[3],
+                                       face[0], face[1], face[1], face[0]};
+    writeQuadsAsStl("/tmp/obj2voxel_culled.stl", unitCubeVertices.data(), quads.data(), 3);
+    const std::string manifestPath = "/tmp/obj2voxel_culled.tiles";
+    {
+        std::optional<voxelio::FileOutputStream> stream = voxelio::FileOutputStream::open(manifestPath);
+        VXIO_ASSERT(stream.has_value());
+        stream->writeString("0 0 0 1 1 1 obj2voxel_culled.stl\n");
+    }
+
+    CountingOutput output;
+    obj2voxel_instance *instance = obj2voxel_alloc();
+    obj2voxel_set_input_file(instance, manifestPath.c_str(), nullptr);
+    obj2voxel_set_output_callback(instance, &outputCallback<CountingOutput>, &output);
+    obj2voxel_set_resolution(instance, 320);
+    obj2voxel_error_t result = obj2voxel_voxelize(instance);
+
+    uint64_t degenerateTriangles, duplicateTriangles;
+    obj2voxel_get_culled_triangle_counts(instance, &degenerateTriangles, &duplicateTriangles);
+    obj2voxel_free(instance);
+
+    VXIO_ASSERT_EQ(result, OBJ2VOXEL_ERR_OK);
+    VXIO_ASSERT_EQ(output.voxelCount, 320u * 320u);
+    VXIO_ASSERT_EQ(degenerateTriangles, 2u);
+    VXIO_ASSERT_EQ(duplicateTriangles, 2u);
+}
+
+/// Voxelizes a manifest with a single tile and returns the number of voxels or the error.
+size_t countVoxelsOfSingleTile(const std::string &bounds, const std::string &tileName, obj2voxel_error_t *outResult)
+{
+    const std::string manifestPath = "/tmp/obj2voxel_single.tiles";
+    {
+        std::optional<voxelio::FileOutputStream> stream = voxelio::FileOutputStream::open(manifestPath);
+        VXIO_ASSERT(stream.has_value());
+        stream->writeString(bounds + ' ' + tileName + '\n');
+    }
+
+    CountingOutput output;
+    obj2voxel_instance *instance = obj2voxel_alloc();
+    obj2voxel_set_input_file(instance, manifestPath.c_str(), nullptr);
+    obj2voxel_set_output_callback(instance, &outputCallback<CountingOutput>, &output);
+    obj2voxel_set_resolution(instance, 64);
+    *outResult = obj2voxel_voxelize(instance);
+    obj2voxel_free(instance);
+
+    return output.voxelCount;
+}
+
+TEST(trianglesOutsideOfTileBoundsAreClamped)
+{
+    std::array<float, unitCubeVertices.size()> flatCubeVertices = unitCubeVertices;
+    for (size_t i = 2; i < flatCubeVertices.size(); i += 3) {
+        flatCubeVertices[i] /= 2;
+    }
+    writeQuadsAsStl("/tmp/obj2voxel_cube.stl", unitCubeVertices.data(), unitCubeElements.data(), 6);
+    writeQuadsAsStl("/tmp/obj2voxel_flat_cube.stl", flatCubeVertices.data(), unitCubeElements.data(), 6);
+
+    // clamping the cube into the bounds on the z-axis turns it into the flat cube
+    obj2voxel_error_t clampedResult, flatResult;
+    const size_t clampedVoxels = countVoxelsOfSingleTile("0 0 0 1 1 0.5", "obj2voxel_cube.stl", &clampedResult);
+    const size_t flatVoxels = countVoxelsOfSingleTile("0 0 0 1 1 0.5", "obj2voxel_flat_cube.stl", &flatResult);
+
+    VXIO_ASSERT_EQ(clampedResult, OBJ2VOXEL_ERR_OK);
+    VXIO_ASSERT_EQ(flatResult, OBJ2VOXEL_ERR_OK);
+    VXIO_ASSERT_NE(flatVoxels, 0u);
+    VXIO_ASSERT_EQ(clampedVoxels, flatVoxels);
+}
+
+TEST(errorOnNonFiniteTileBounds)
+{
+    writeQuadsAsStl("/tmp/obj2voxel_cube.stl", unitCubeVertices.data(), unitCubeElements.data(), 6);
+
+    pushLogLevel(OBJ2VOXEL_LOG_LEVEL_SILENT);
+    for (const char *bounds : {"nan 0 0 1 1 1", "0 0 0 1 inf 1", "-inf 0 0 1 1 1"}) {
+        obj2voxel_error_t result;
+        VXIO_ASSERT_EQ(countVoxelsOfSingleTile(bounds, "obj2voxel_cube.stl", &result), 0u);
+        VXIO_ASSERT_EQ(result, OBJ2VOXEL_ERR_IO_ERROR_ON_OPEN_INPUT_FILE);
+    }
+    popLogLevel();
+}
+
+/// Returns the number of voxels in all tiles of an output manifest.
+size_t countVoxelsOfOutputTiles(const std::string &manifestPath, size_t &outTileCount)
+{
+    std::ifstream manifest{manifestPath};
+    size_t totalBytes = 0;
+    outTileCount = 0;
+    for (std::string line; std::getline(manifest, line);) {
+        if (line.empty() || line.front() == '#') {
+            continue;
+        }
+        std::ifstream tile{"/tmp/" + line.substr(line.rfind(' ') + 1), std::ios::binary | std::ios::ate};
+        VXIO_ASSERT(tile.is_open());
+        totalBytes += static_cast<size_t>(tile.tellg());
+        ++outTileCount;
+    }
+    return totalBytes / (sizeof(uint32_t) * 4);
+}
+
+/// Voxelizes the unit cube into output tiles and returns the number of voxels in all tiles of the manifest.
+size_t countVoxelsOfTiledCube(uint32_t resolution, uint32_t tilesPerAxis, uint32_t dilation, size_t &outTileCount)
+{
+    IndexedQuadInput input{unitCubeVertices.data(), unitCubeElements.data(), unitCubeElements.size()};
+
+    obj2voxel_instance *instance = obj2voxel_alloc();
+    obj2voxel_set_input_callback(instance, &inputCallback<IndexedQuadInput>, &input);
+    obj2voxel_set_output_file(instance, "/tmp/obj2voxel_tiled.vl32", nullptr);
+    obj2voxel_set_output_tiles(instance, tilesPerAxis);
+    obj2voxel_set_resolution(instance, resolution);
+    if (dilation != 0) {
+        obj2voxel_add_morphology(instance, OBJ2VOXEL_MORPHOLOGY_DILATE, dilation);
+    }
+    obj2voxel_error_t result = obj2voxel_voxelize(instance);
+    obj2voxel_free(instance);
+
+    VXIO_ASSERT_EQ(result, OBJ2VOXEL_ERR_OK);
+    return countVoxelsOfOutputTiles("/tmp/obj2voxel_tiled.tiles", outTileCount);
+}
+
+TEST(tiledOutputSplitsVoxelsAcrossTiles)
+{
+    size_t tileCount;
+    VXIO_ASSERT_EQ(countVoxelsOfTiledCube(128, 2, 0, tileCount), expectedUnitCubeVoxels(128));
+    // the cube surface passes through every octant, so all eight tiles are written
+    VXIO_ASSERT_EQ(tileCount, 8u);
+
+    // the surface only passes through the outer tiles, and most chunks of the grid are empty
+    VXIO_ASSERT_EQ(countVoxelsOfTiledCube(320, 5, 0, tileCount), expectedUnitCubeVoxels(320));
+    VXIO_ASSERT_EQ(tileCount, 5u * 5 * 5 - 3 * 3 * 3);
+}
+
+TEST(tiledOutputOfTiledInputCompletesTilesOverEmptyRegions)
+{
+    // clang-format off
+    // two small squares in opposite corners of the unit cube
+    const std::array<float, 8 * 3> vertices{
+        0, 0, 0,
+        0.05f, 0, 0,
+        0.05f, 0.05f, 0,
+        0, 0.05f, 0,
+        0.95f, 0.95f, 1,
+        1, 0.95f, 1,
+        1, 1, 1,
+        0.95f, 1, 1
+    };
+    // clang-format on
+    const std::array<size_t, 8> quads{0, 1, 2, 3, 4, 5, 6, 7};
+    writeQuadsAsStl("/tmp/obj2voxel_corner_0.stl", vertices.data(), quads.data(), 1);
+    writeQuadsAsStl("/tmp/obj2voxel_corner_1.stl", vertices.data(), quads.data() + 4, 1);
+    const std::string manifestPath = "/tmp/obj2voxel_corners.tiles";
+    {
+        std::optional<voxelio::FileOutputStream> stream = voxelio::FileOutputStream::open(manifestPath);
+        VXIO_ASSERT(stream.has_value());
+        stream->writeString("0 0 0 0.05 0.05 0 obj2voxel_corner_0.stl\n");
+        stream->writeString("0.95 0.95 1 1 1 1 obj2voxel_corner_1.stl\n");
+    }
+
+    // Each output tile spans five chunks per axis, so it overlaps input regions with and without tiles.
+    constexpr uint32_t resolution = 640;
+    CountingOutput output;
+    obj2voxel_instance *instance = obj2voxel_alloc();
+    obj2voxel_set_input_file(instance, manifestPath.c_str(), nullptr);
+    obj2voxel_set_output_callback(instance, &outputCallback<CountingOutput>, &output);
+    obj2voxel_set_resolution(instance, resolution);
+    VXIO_ASSERT_EQ(obj2voxel_voxelize(instance), OBJ2VOXEL_ERR_OK);
+    obj2voxel_free(instance);
+
+    instance = obj2voxel_alloc();
+    obj2voxel_set_input_file(instance, manifestPath.c_str(), nullptr);
+    obj2voxel_set_output_file(instance, "/tmp/obj2voxel_corners_out.vl32", nullptr);
+    obj2voxel_set_output_tiles(instance, 2);
+    obj2voxel_set_resolution(instance, resolution);
+    VXIO_ASSERT_EQ(obj2voxel_voxelize(instance), OBJ2VOXEL_ERR_OK);
+    obj2voxel_free(instance);
+
+    size_t tileCount;
+    VXIO_ASSERT_NE(output.voxelCount, 0u);
+    VXIO_ASSERT_EQ(countVoxelsOfOutputTiles("/tmp/obj2voxel_corners_out.tiles", tileCount), output.voxelCount);
+    VXIO_ASSERT_EQ(tileCount, 2u);
+}
+
+TEST(resolutionBeyondMortonLimitKeepsVoxelPositions)
+{
+    // more than the 21 bits per axis which a Morton index of a global voxel position could hold
+    constexpr uint32_t resolution = 3'000'000;
+    constexpr float e = 1e-5f;
+
+    // clang-format off
+    // two tiny triangles in opposite corners of the unit cube
+    const std::array<float, 6 * 3> vertices{
+        0, 0, 0,
+        0, 0, e,
+        e, 0, 0,
+        1, 1, 1,
+        1, 1, 1 - e,
+        1 - e, 1, 1
+    };
+    // clang-format on
+
+    TriangleInput input{vertices.data(), vertices.size() / 3};
+    MapOutput output;
+
+    obj2voxel_instance *instance = obj2voxel_alloc();
+    obj2voxel_set_input_callback(instance, &inputCallback<TriangleInput>, &input);
+    obj2voxel_set_output_callback(instance, &outputCallback<MapOutput>, &output);
+    obj2voxel_set_resolution(instance, resolution);
+    obj2voxel_error_t result = obj2voxel_voxelize(instance);
+    obj2voxel_free(instance);
+
+    VXIO_ASSERT_EQ(result, OBJ2VOXEL_ERR_OK);
+
+    size_t nearOrigin = 0, nearOppositeCorner = 0;
+    for (const auto &[pos, color] : output.voxels) {
+        const uint32_t min = std::min({pos[0], pos[1], pos[2]});
+        const uint32_t max = std::max({pos[0], pos[1], pos[2]});
+        VXIO_ASSERT_LT(max, resolution);
+        nearOrigin += max < 64;
+        nearOppositeCorner += min >= resolution - 64;
+    }
+    VXIO_ASSERT_NE(nearOrigin, 0u);
+    VXIO_ASSERT_NE(nearOppositeCorner, 0u);
+    VXIO_ASSERT_EQ(nearOrigin + nearOppositeCorner, output.voxels.size());
+}
+
+TEST(unitCubeDistanceFieldIsSigned)
+{
+    constexpr uint32_t resolution = 16;
+
+    IndexedQuadInput input{unitCubeVertices.data(), unitCubeElements.data(), unitCubeElements.size()};
+    DistanceFieldOutput output;
+
+    obj2voxel_instance *instance = obj2voxel_alloc();
+    obj2voxel_set_input_callback(instance, &inputCallback<IndexedQuadInput>, &input);
+    obj2voxel_set_sdf_output(instance, 0, &sdfCallback<DistanceFieldOutput>, &output);
+    obj2voxel_set_resolution(instance, resolution);
+    obj2voxel_error_t result = obj2voxel_voxelize(instance);
+    obj2voxel_free(instance);
+
+    VXIO_ASSERT_EQ(result, OBJ2VOXEL_ERR_OK);
+    VXIO_ASSERT_EQ(output.distances.size(), resolution * resolution * resolution);
+
+    const auto distanceAt = [&](uint32_t x, uint32_t y, uint32_t z) {
+        return output.distances[(z * resolution + y) * resolution + x];
+    };
+
+    // the cube spans the whole grid, so the outermost voxels are surface voxels close to a face
+    VXIO_ASSERT_GT(distanceAt(0, 0, 0), 0.f);
+    VXIO_ASSERT_LE(distanceAt(0, 0, 0), 0.87f);
+    VXIO_ASSERT_GT(distanceAt(0, 7, 9), 0.f);
+    VXIO_ASSERT_LE(distanceAt(0, 7, 9), 0.5f);
+    VXIO_ASSERT_LE(std::abs(distanceAt(2, 7, 9) + 2.f), 1.f);
+    VXIO_ASSERT_LE(std::abs(distanceAt(7, 8, 7) + 7.f), 1.f);
+}
+
+TEST(errorOnDistanceFieldResolutionAboveLimit)
+{
+    pushLogLevel(OBJ2VOXEL_LOG_LEVEL_SILENT);
+
+    IndexedQuadInput input{unitCubeVertices.data(), unitCubeElements.data(), unitCubeElements.size()};
+    DistanceFieldOutput output;
+
+    // the dense grid would need 320 GiB, which must be rejected before anything is allocated
+    obj2voxel_instance *instance = obj2voxel_alloc();
+    obj2voxel_set_input_callback(instance, &inputCallback<IndexedQuadInput>, &input);
+    obj2voxel_set_sdf_output(instance, 0, &sdfCallback<DistanceFieldOutput>, &output);
+    obj2voxel_set_resolution(instance, 4096);
+    obj2voxel_error_t result = obj2voxel_voxelize(instance);
+    obj2voxel_free(instance);
+
+    popLogLevel();
+
+    VXIO_ASSERT_EQ(result, OBJ2VOXEL_ERR_NO_RESOLUTION);
+    VXIO_ASSERT(output.distances.empty());
+}
+
+TEST(duplicateAndDegenerateTrianglesAreCulled)
+{
+    constexpr size_t resolution = 32;
+    constexpr size_t expectedVoxels = expectedUnitCubeVoxels(resolution);
+
+    IndexedQuadInput input{
+        unitCubeVertices.data(), duplicatedUnitCubeElements.data(), duplicatedUnitCubeElements.size()};
+    CountingOutput output;
+
+    obj2voxel_instance *instance = obj2voxel_alloc();
+    obj2voxel_set_input_callback(instance, &inputCallback<IndexedQuadInput>, &input);
+    obj2voxel_set_output_callback(instance, &outputCallback<CountingOutput>, &output);
+    obj2voxel_set_resolution(instance, resolution);
+    VXIO_ASSERT_EQ(obj2voxel_voxelize(instance), OBJ2VOXEL_ERR_OK);
+
+    uint64_t degenerateTriangles, duplicateTriangles;
+    obj2voxel_get_culled_triangle_counts(instance, &degenerateTriangles, &duplicateTriangles);
+    obj2voxel_free(instance);
+
+    VXIO_ASSERT_EQ(output.voxelCount, expectedVoxels);
+    // the degenerate quad consists of two triangles and each of the six duplicated quads of two more
+    VXIO_ASSERT_EQ(degenerateTriangles, 2u);
+    VXIO_ASSERT_EQ(duplicateTriangles, 12u);
+}
+
+/// Returns the number of voxels in the layers of a cube grid which are at least min and less than max voxels away from
+/// the grid boundary.
+constexpr size_t cubeLayerVoxels(size_t resolution, size_t min, size_t max)
+{
+    const size_t outer = resolution - 2 * min;
+    const size_t inner = resolution - 2 * max;
+    return outer * outer * outer - inner * inner * inner;
+}
+
+void testMorphologyOfUnitCube(const std::vector<std::pair<obj2voxel_enum_t, uint32_t>> &steps,
+                              size_t expectedVoxels,
+                              uint32_t supersampling = 1)
+{
+    IndexedQuadInput input{unitCubeVertices.data(), unitCubeElements.data(), unitCubeElements.size()};
+
+    obj2voxel_instance *instance = obj2voxel_alloc();
+    obj2voxel_set_input_callback(instance, &inputCallback<IndexedQuadInput>, &input);
+    // chunks are small enough that the results depend on their neighbors
+    obj2voxel_set_resolution(instance, obj2voxel_get_chunk_size(instance) * 2);
+    obj2voxel_set_supersampling(instance, supersampling);
+    for (const auto &[operation, radius] : steps) {
+        obj2voxel_add_morphology(instance, operation, radius);
+    }
+
+    testVoxelProduction(instance, expectedVoxels);
+}
+
+TEST(morphologyOfUnitCubeProducesExpectedVoxelCounts)
+{
+    // the surface of the unit cube is the outermost layer of the grid
+    constexpr size_t resolution = 128;
+
+    testMorphologyOfUnitCube({{OBJ2VOXEL_MORPHOLOGY_DILATE, 2}}, cubeLayerVoxels(resolution, 0, 3));
+    testMorphologyOfUnitCube({{OBJ2VOXEL_MORPHOLOGY_DILATE, 1}}, cubeLayerVoxels(resolution, 0, 2), 2);
+    // voxels outside of the grid are empty, so the outermost layer erodes as well
+    testMorphologyOfUnitCube({{OBJ2VOXEL_MORPHOLOGY_DILATE, 2}, {OBJ2VOXEL_MORPHOLOGY_ERODE, 1}},
+                             cubeLayerVoxels(resolution, 1, 2));
+    testMorphologyOfUnitCube({{OBJ2VOXEL_MORPHOLOGY_CLOSE, 3}}, expectedUnitCubeVoxels(resolution));
+    testMorphologyOfUnitCube({{OBJ2VOXEL_MORPHOLOGY_DILATE, 3}, {OBJ2VOXEL_MORPHOLOGY_HOLLOW, 1}},
+                             cubeLayerVoxels(resolution, 0, 1) + cubeLayerVoxels(resolution, 3, 4));
+    testMorphologyOfUnitCube({{OBJ2VOXEL_MORPHOLOGY_ERODE, 0}}, expectedUnitCubeVoxels(resolution));
+}
+
+TEST(tiledOutputOfPostProcessedChunksCompletesEveryTile)
+{
+    // tiles are aligned to chunks, so there are three tiles per axis and only the center tile is empty
+    size_t tileCount;
+    VXIO_ASSERT_EQ(countVoxelsOfTiledCube(300, 3, 1, tileCount), cubeLayerVoxels(300, 0, 2));
+    VXIO_ASSERT_EQ(tileCount, 3u * 3 * 3 - 1);
+}
+
+size_t countVoxelsOfUnitCubeWithIsland(uint64_t minIslandVoxels, uint32_t maxIslands)
+{
+    // clang-format off
+    constexpr std::array<float, 4 * 3> islandVertices{
+        .40f, .5f, .40f,
+        .40f, .5f, .45f,
+        .45f, .5f, .45f,
+        .45f, .5f, .40f
+    };
+    // clang-format on
+    constexpr std::array<size_t, 4> islandElements{0, 1, 2, 3};
+
+    std::vector<float> vertices{unitCubeVertices.begin(), unitCubeVertices.end()};
+    vertices.insert(vertices.end(), islandVertices.begin(), islandVertices.end());
+    std::vector<size_t> elements{unitCubeElements.begin(), unitCubeElements.end()};
+    for (size_t element : islandElements) {
+        elements.push_back(element + unitCubeVertices.size() / 3);
+    }
+    IndexedQuadInput input{vertices.data(), elements.data(), elements.size()};
+    CountingOutput output;
+
+    obj2voxel_instance *instance = obj2voxel_alloc();
+    obj2voxel_set_input_callback(instance, &inputCallback<IndexedQuadInput>, &input);
+    obj2voxel_set_output_callback(instance, &outputCallback<CountingOutput>, &output);
+    // the surface of the cube spans several chunks, which must be merged into one component
+    obj2voxel_set_resolution(instance, obj2voxel_get_chunk_size(instance) * 2);
+    obj2voxel_set_island_removal(instance, minIslandVoxels, maxIslands);
+    VXIO_ASSERT_EQ(obj2voxel_voxelize(instance), OBJ2VOXEL_ERR_OK);
+    obj2voxel_free(instance);
+
+    return output.voxelCount;
+}
+
+TEST(islandRemovalKeepsOnlyLargeComponents)
+{
+    constexpr size_t cubeVoxels = expectedUnitCubeVoxels(128);
+
+    const size_t allVoxels = countVoxelsOfUnitCubeWithIsland(0, 0);
+    VXIO_ASSERT_GT(allVoxels, cubeVoxels);
+    VXIO_ASSERT_EQ(countVoxelsOfUnitCubeWithIsland(allVoxels - cubeVoxels, 0), allVoxels);
+    VXIO_ASSERT_EQ(countVoxelsOfUnitCubeWithIsland(allVoxels - cubeVoxels + 1, 0), cubeVoxels);
+    VXIO_ASSERT_EQ(countVoxelsOfUnitCubeWithIsland(0, 2), allVoxels);
+    VXIO_ASSERT_EQ(countVoxelsOfUnitCubeWithIsland(0, 1), cubeVoxels);
+}
+
+/// Returns the vertices of a tilted plane which is tessellated into many triangles per voxel.
+std::vector<float> makeTessellatedPlane(size_t quadsPerAxis)
+{
+    const auto vertexAt = [quadsPerAxis](std::vector<float> &out, size_t x, size_t y) {
+        const float u = float(x) / float(quadsPerAxis);
+        const float v = float(y) / float(quadsPerAxis);
+        out.insert(out.end(), {u, v, 0.3f * u + 0.2f * v});
+    };
+
+    std::vector<float> result;
+    for (size_t y = 0; y < quadsPerAxis; ++y) {
+        for (size_t x = 0; x < quadsPerAxis; ++x) {
+            vertexAt(result, x, y);
+            vertexAt(result, x + 1, y);
+            vertexAt(result, x + 1, y + 1);
+            vertexAt(result, x + 1, y + 1);
+            vertexAt(result, x, y + 1);
+            vertexAt(result, x, y);
+        }
+    }
+    return result;
+}
+
+size_t countVoxelsOfTessellatedPlane(const std::vector<float> &vertices,
+                                     uint32_t decimation,
+                                     obj2voxel_enum_t topology = OBJ2VOXEL_CONSERVATIVE_TOPOLOGY,
+                                     uint64_t *outCulledTriangles = nullptr)
+{
+    TriangleInput input{vertices.data(), vertices.size() / 3};
+    CountingOutput output;
+
+    obj2voxel_instance *instance = obj2voxel_alloc();
+    obj2voxel_set_input_callback(instance, &inputCallback<TriangleInput>, &input);
+    obj2voxel_set_output_callback(instance, &outputCallback<CountingOutput>, &output);
+    obj2voxel_set_resolution(instance, 16);
+    obj2voxel_set_decimation(instance, decimation);
+    obj2voxel_set_topology(instance, topology);
+    obj2voxel_error_t result = obj2voxel_voxelize(instance);
+
+    uint64_t degenerateTriangles, duplicateTriangles;
+    obj2voxel_get_culled_triangle_counts(instance, &degenerateTriangles, &duplicateTriangles);
+    obj2voxel_free(instance);
+    if (outCulledTriangles != nullptr) {
+        *outCulledTriangles = degenerateTriangles + duplicateTriangles;
+    }
+
+    VXIO_ASSERT_EQ(result, OBJ2VOXEL_ERR_OK);
+    return output.voxelCount;
+}
+
+TEST(decimationKeepsVoxelCoverageWithinBounds)
+{
+    const std::vector<float> vertices = makeTessellatedPlane(128);
+
+    const size_t triangleCount = vertices.size() / 9;
+    uint64_t exactCulled, decimatedCulled;
+
+    const size_t exactVoxels =
+        countVoxelsOfTessellatedPlane(vertices, 0, OBJ2VOXEL_CONSERVATIVE_TOPOLOGY, &exactCulled);
+    const size_t decimatedVoxels =
+        countVoxelsOfTessellatedPlane(vertices, 4, OBJ2VOXEL_CONSERVATIVE_TOPOLOGY, &decimatedCulled);
+
+    // there are 8 * 8 quads per voxel, but only 4 * 4 clusters, so most triangles collapse
+    VXIO_ASSERT_EQ(exactCulled, 0u);
+    VXIO_ASSERT_GE(decimatedCulled * 2, triangleCount);
+
+    // vertices move by less than a quarter voxel, so only voxels that the plane barely touches may differ
+    const size_t difference =
+        exactVoxels > decimatedVoxels ? exactVoxels - decimatedVoxels : decimatedVoxels - exactVoxels;
+    VXIO_ASSERT_LE(difference * 20, exactVoxels);
+}
+
+TEST(thinTopologyKeepsOneVoxelPerColumn)
+{
+    const std::vector<float> vertices = makeTessellatedPlane(8);
+
+    const size_t conservativeVoxels = countVoxelsOfTessellatedPlane(vertices, 0, OBJ2VOXEL_CONSERVATIVE_TOPOLOGY);
+    const size_t thinVoxels = countVoxelsOfTessellatedPlane(vertices, 0, OBJ2VOXEL_THIN_TOPOLOGY);
+
+    // the plane spans 16x16 columns along its dominant z-axis
+    VXIO_ASSERT_EQ(thinVoxels, 16u * 16u);
+    VXIO_ASSERT_LT(thinVoxels, conservativeVoxels);
+}
+
+TEST(normalsOfPlaneAreOctahedrallyEncoded)
+{
+    const std::vector<float> vertices = makeTessellatedPlane(8);
+
+    TriangleInput input{vertices.data(), vertices.size() / 3};
+    CountingOutput output;
+    HistogramOutput normalOutput;
+
+    obj2voxel_instance *instance = obj2voxel_alloc();
+    obj2voxel_set_input_callback(instance, &inputCallback<TriangleInput>, &input);
+    obj2voxel_set_output_callback(instance, &outputCallback<CountingOutput>, &output);
+    obj2voxel_set_normal_output_callback(instance, &outputCallback<HistogramOutput>, &normalOutput);
+    obj2voxel_set_resolution(instance, 16);
+    obj2voxel_error_t result = obj2voxel_voxelize(instance);
+    obj2voxel_free(instance);
+
+    VXIO_ASSERT_EQ(result, OBJ2VOXEL_ERR_OK);
+    VXIO_ASSERT_EQ(normalOutput.voxelCount, output.voxelCount);
+
+    // the plane normal is (-0.3, -0.2, 1), which is (-0.2, -0.1333) on the octahedron
+    for (const auto &[normal, count] : normalOutput.histogram) {
+        const float x = float(normal >> 16) / 65535 * 2 - 1;
+        const float y = float(normal & 0xffff) / 65535 * 2 - 1;
+        VXIO_ASSERT_LT(std::abs(x + 0.2f), 0.001f);
+        VXIO_ASSERT_LT(std::abs(y + 0.1333f), 0.001f);
+    }
+}
+
+TEST(normalsFollowPostProcessedVoxels)
+{
+    const std::vector<float> vertices = makeTessellatedPlane(8);
+
+    TriangleInput input{vertices.data(), vertices.size() / 3};
+    MapOutput output;
+    MapOutput normalOutput;
+
+    obj2voxel_instance *instance = obj2voxel_alloc();
+    obj2voxel_set_input_callback(instance, &inputCallback<TriangleInput>, &input);
+    obj2voxel_set_output_callback(instance, &outputCallback<MapOutput>, &output);
+    obj2voxel_set_normal_output_callback(instance, &outputCallback<MapOutput>, &normalOutput);
+    obj2voxel_set_resolution(instance, 16);
+    obj2voxel_add_morphology(instance, OBJ2VOXEL_MORPHOLOGY_DILATE, 1);
+    obj2voxel_set_island_removal(instance, 1, 1);
+    obj2voxel_error_t result = obj2voxel_voxelize(instance);
+    obj2voxel_free(instance);
+
+    VXIO_ASSERT_EQ(result, OBJ2VOXEL_ERR_OK);
+    VXIO_ASSERT_EQ(normalOutput.voxels.size(), output.voxels.size());
+
+    // dilated voxels take the normal of a neighbor, which is the plane normal everywhere
+    for (const auto &[pos, normal] : normalOutput.voxels) {
+        VXIO_ASSERT(output.voxels.count(pos) != 0);
+        const float x = float(normal >> 16) / 65535 * 2 - 1;
+        const float y = float(normal & 0xffff) / 65535 * 2 - 1;
+        VXIO_ASSERT_LT(std::abs(x + 0.2f), 0.001f);
+        VXIO_ASSERT_LT(std::abs(y + 0.1333f), 0.001f);
+    }
+}
+
+size_t countVoxelsOfHalfTransparentPlane(float alphaCutoff, obj2voxel_enum_t strategy, bool borrowPixels = false)
+{
+    const std::vector<float> vertices = makeTessellatedPlane(8);
+    const size_t triangleCount = vertices.size() / 9;
+
+    // the plane's x and y coordinates span [0, 1], so they can be used as UV coordinates directly
+    std::vector<float> uvs;
+    for (size_t i = 0; i < vertices.size(); i += 3) {
+        uvs.insert(uvs.end(), {vertices[i], vertices[i + 1]});
+    }
+
+    // ARGB pixels, the left half is fully transparent
+    const obj2voxel_byte_t pixels[]{0, 255, 0, 0, 255, 255, 0, 0};
+    // the same pixels as BGRA with padding at the end of the row
+    const obj2voxel_byte_t borrowedPixels[]{0, 0, 255, 0, 0, 0, 255, 255, 0, 0, 0, 0};
+    obj2voxel_texture *texture = obj2voxel_texture_alloc();
+    if (borrowPixels) {
+        VXIO_ASSERT(obj2voxel_texture_borrow_pixels(texture, borrowedPixels, 2, 1, 12, OBJ2VOXEL_CHANNELS_BGRA));
+        VXIO_ASSERT_EQ(obj2voxel_texture_peek_pixels(texture, nullptr), borrowedPixels);
+
+        obj2voxel_byte_t copiedPixels[sizeof(pixels)];
+        obj2voxel_texture_get_pixels(texture, copiedPixels);
+        VXIO_ASSERT(std::equal(copiedPixels, copiedPixels + sizeof(pixels), pixels));
+    }
+    else {
+        VXIO_ASSERT(obj2voxel_texture_load_pixels(texture, pixels, 2, 1, 4));
+    }
+
+    TexturedTriangleInput input{vertices.data(), uvs.data(), texture, triangleCount};
+    CountingOutput output;
+
+    obj2voxel_instance *instance = obj2voxel_alloc();
+    obj2voxel_set_input_callback(instance, &inputCallback<TexturedTriangleInput>, &input);
+    obj2voxel_set_output_callback(instance, &outputCallback<CountingOutput>, &output);
+    obj2voxel_set_resolution(instance, 16);
+    obj2voxel_set_color_strategy(instance, strategy);
+    obj2voxel_set_alpha_cutoff(instance, alphaCutoff);
+    obj2voxel_error_t result = obj2voxel_voxelize(instance);
+    obj2voxel_free(instance);
+    obj2voxel_texture_free(texture);
+
+    VXIO_ASSERT_EQ(result, OBJ2VOXEL_ERR_OK);
+    return output.voxelCount;
+}
+
+TEST(alphaCutoffDiscardsTransparentFragments)
+{
+    for (obj2voxel_enum_t strategy : {OBJ2VOXEL_MAX_STRATEGY, OBJ2VOXEL_BLEND_STRATEGY}) {
+        const size_t opaqueVoxels = countVoxelsOfHalfTransparentPlane(0, strategy);
+        const size_t cutoutVoxels = countVoxelsOfHalfTransparentPlane(0.5f, strategy);
+
+        // roughly half of the plane remains, with some leeway for voxels on the border between both halves
+        VXIO_ASSERT_GE(cutoutVoxels * 20, opaqueVoxels * 9);
+        VXIO_ASSERT_LE(cutoutVoxels * 20, opaqueVoxels * 11);
+    }
+}
+
+/// Voxelizes a transparent square followed by a coplanar opaque triangle, which covers half of the square.
+size_t countVoxelsOfOpaqueTriangleBehindTransparentSquare(obj2voxel_enum_t strategy, size_t *outNormalCount)
+{
+    // clang-format off
+    const float vertices[]{
+        0, 0, 0,    1, 0, .3f,  1, 1, .5f,
+        1, 1, .5f,  0, 1, .2f,  0, 0, 0,
+        0, 0, 0,    1, 0, .3f,  0, 1, .2f
+    };
+    // the square samples the transparent left pixel, the triangle samples the opaque right pixel
+    const float uvs[]{
+        .25f, .5f,  .25f, .5f,  .25f, .5f,
+        .25f, .5f,  .25f, .5f,  .25f, .5f,
+        .75f, .5f,  .75f, .5f,  .75f, .5f
+    };
+    // clang-format on
+    const obj2voxel_byte_t pixels[]{0, 255, 0, 0, 255, 255, 0, 0};
+    obj2voxel_texture *texture = obj2voxel_texture_alloc();
+    VXIO_ASSERT(obj2voxel_texture_load_pixels(texture, pixels, 2, 1, 4));
+
+    TexturedTriangleInput input{vertices, uvs, texture, 3};
+    CountingOutput output;
+    CountingOutput normalOutput;
+
+    obj2voxel_instance *instance = obj2voxel_alloc();
+    obj2voxel_set_input_callback(instance, &inputCallback<TexturedTriangleInput>, &input);
+    obj2voxel_set_output_callback(instance, &outputCallback<CountingOutput>, &output);
+    obj2voxel_set_normal_output_callback(instance, &outputCallback<CountingOutput>, &normalOutput);
+    obj2voxel_set_resolution(instance, 16);
+    obj2voxel_set_color_strategy(instance, strategy);
+    obj2voxel_set_alpha_cutoff(instance, 0.5f);
+    obj2voxel_error_t result = obj2voxel_voxelize(instance);
+    obj2voxel_free(instance);
+    obj2voxel_texture_free(texture);
+
+    VXIO_ASSERT_EQ(result, OBJ2VOXEL_ERR_OK);
+    *outNormalCount = normalOutput.voxelCount;
+    return output.voxelCount;
+}
+
+TEST(transparentFragmentsDontDiscardOpaqueFragments)
+{
+    // the square comes first and covers at least as much of each voxel, so it would win every voxel if it took part
+    size_t maxNormals, blendNormals;
+    const size_t maxVoxels = countVoxelsOfOpaqueTriangleBehindTransparentSquare(OBJ2VOXEL_MAX_STRATEGY, &maxNormals);
+    const size_t blendVoxels =
+        countVoxelsOfOpaqueTriangleBehindTransparentSquare(OBJ2VOXEL_BLEND_STRATEGY, &blendNormals);
+
+    VXIO_ASSERT_NE(maxVoxels, 0u);
+    VXIO_ASSERT_EQ(maxVoxels, blendVoxels);
+    VXIO_ASSERT_EQ(maxNormals, maxVoxels);
+    VXIO_ASSERT_EQ(blendNormals, blendVoxels);
+}
+
+TEST(borrowedTexturesAreSampledLikeLoadedTextures)
+{
+    const size_t loadedVoxels = countVoxelsOfHalfTransparentPlane(0.5f, OBJ2VOXEL_MAX_STRATEGY);
+    const size_t borrowedVoxels = countVoxelsOfHalfTransparentPlane(0.5f, OBJ2VOXEL_MAX_STRATEGY, true);
+    VXIO_ASSERT_EQ(loadedVoxels, borrowedVoxels);
+}
+
+std::map<std::array<uint32_t, 3>, uint32_t> voxelizeTexturedTriangle(obj2voxel_enum_t strategy)
+{
+    // a single tilted triangle, so that every voxel receives exactly one fragment, sampled at its own UV coordinates
+    const float vertices[]{0, 0, 0, 1, 0, 0.4f, 0, 1, 0.7f};
+    const float uvs[]{0, 0, 1, 0, 0, 1};
+
+    // ARGB pixels with a distinct color each, so that voxels only match if they are sampled at the same location
+    std::vector<obj2voxel_byte_t> pixels;
+    for (obj2voxel_byte_t i = 0; i < 16; ++i) {
+        pixels.insert(pixels.end(), {255, static_cast<obj2voxel_byte_t>(i * 16), static_cast<obj2voxel_byte_t>(i), 0});
+    }
+    obj2voxel_texture *texture = obj2voxel_texture_alloc();
+    VXIO_ASSERT(obj2voxel_texture_load_pixels(texture, pixels.data(), 4, 4, 4));
+
+    TexturedTriangleInput input{vertices, uvs, texture, 1};
+    MapOutput output;
+
+    obj2voxel_instance *instance = obj2voxel_alloc();
+    obj2voxel_set_input_callback(instance, &inputCallback<TexturedTriangleInput>, &input);
+    obj2voxel_set_output_callback(instance, &outputCallback<MapOutput>, &output);
+    obj2voxel_set_resolution(instance, 32);
+    obj2voxel_set_color_strategy(instance, strategy);
+    obj2voxel_error_t result = obj2voxel_voxelize(instance);
+    obj2voxel_free(instance);
+    obj2voxel_texture_free(texture);
+
+    VXIO_ASSERT_EQ(result, OBJ2VOXEL_ERR_OK);
+    return std::move(output.voxels);
+}
+
+TEST(deferredMaxShadingMatchesImmediateShading)
+{
+    // blending samples every fragment immediately, which is the same as max for voxels with a single fragment
+    const std::map<std::array<uint32_t, 3>, uint32_t> deferred = voxelizeTexturedTriangle(OBJ2VOXEL_MAX_STRATEGY);
+    const std::map<std::array<uint32_t, 3>, uint32_t> immediate = voxelizeTexturedTriangle(OBJ2VOXEL_BLEND_STRATEGY);
+
+    VXIO_ASSERT_EQ(deferred.size(), immediate.size());
+    VXIO_ASSERT(deferred == immediate);
+
+    std::set<uint32_t> colors;
+    for (const auto &[position, color] : deferred) {
+        colors.insert(color);
+    }
+    VXIO_ASSERT_GT(colors.size(), 4u);
+}
+
+TEST(materialAttributeProducesMaterialIndices)
+{
+    // each half of the plane has its own material
+    const std::vector<float> vertices = makeTessellatedPlane(8);
+    const size_t triangleCount = vertices.size() / 9;
+
+    MaterialTriangleInput input{{vertices.data(), vertices.size() / 3}, triangleCount / 2};
+    HistogramOutput output;
+
+    obj2voxel_instance *instance = obj2voxel_alloc();
+    obj2voxel_set_input_callback(instance, &inputCallback<MaterialTriangleInput>, &input);
+    obj2voxel_set_output_callback(instance, &outputCallback<HistogramOutput>, &output);
+    obj2voxel_set_resolution(instance, 16);
+    obj2voxel_set_voxel_attribute(instance, OBJ2VOXEL_ATTRIBUTE_MATERIAL);
+    obj2voxel_error_t result = obj2voxel_voxelize(instance);
+    obj2voxel_free(instance);
+
+    VXIO_ASSERT_EQ(result, OBJ2VOXEL_ERR_OK);
+    VXIO_ASSERT_EQ(output.histogram.size(), 2u);
+    VXIO_ASSERT_NE(output.histogram[1], 0u);
+    VXIO_ASSERT_NE(output.histogram[2], 0u);
+    VXIO_ASSERT_EQ(output.histogram[1] + output.histogram[2], output.voxelCount);
+}
+
+TEST(coincidentTrianglesWithDifferentMaterialsAreKept)
+{
+    std::vector<float> vertices = makeTessellatedPlane(4);
+    const size_t triangleCount = vertices.size() / 9;
+    vertices.insert(vertices.end(), vertices.begin(), vertices.end());
+
+    // the second copy of the plane is only a duplicate if it has the same material as the first
+    for (size_t trianglesPerMaterial : {triangleCount, triangleCount * 2}) {
+        MaterialTriangleInput input{{vertices.data(), vertices.size() / 3}, trianglesPerMaterial};
+        CountingOutput output;
+
+        obj2voxel_instance *instance = obj2voxel_alloc();
+        obj2voxel_set_input_callback(instance, &inputCallback<MaterialTriangleInput>, &input);
+        obj2voxel_set_output_callback(instance, &outputCallback<CountingOutput>, &output);
+        obj2voxel_set_resolution(instance, 16);
+        obj2voxel_set_voxel_attribute(instance, OBJ2VOXEL_ATTRIBUTE_MATERIAL);
+        VXIO_ASSERT_EQ(obj2voxel_voxelize(instance), OBJ2VOXEL_ERR_OK);
+
+        uint64_t duplicateTriangles;
+        obj2voxel_get_culled_triangle_counts(instance, nullptr, &duplicateTriangles);
+        obj2voxel_free(instance);
+
+        VXIO_ASSERT_EQ(duplicateTriangles, trianglesPerMaterial == triangleCount ? 0u : triangleCount);
+    }
+}
+
+/// Voxelizes a plane with eight materials, optionally with worker threads, and returns the voxels.
+std::map<std::array<uint32_t, 3>, uint32_t> voxelizeMaterialPlane(size_t workerCount)
+{
+    const std::vector<float> vertices = makeTessellatedPlane(64);
+    const size_t triangleCount = vertices.size() / 9;
+
+    MaterialTriangleInput input{{vertices.data(), vertices.size() / 3}, triangleCount / 8};
+    MapOutput output;
+
+    obj2voxel_instance *instance = obj2voxel_alloc();
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < workerCount; ++i) {
+        workers.emplace_back(&obj2voxel_run_worker, instance);
+    }
+    obj2voxel_set_parallel(instance, workerCount != 0);
+    obj2voxel_set_input_callback(instance, &inputCallback<MaterialTriangleInput>, &input);
+    obj2voxel_set_output_callback(instance, &outputCallback<MapOutput>, &output);
+    // 8^3 chunks in 4^3 Morton ranges, so binning of later ranges overlaps with voxelization of earlier ones
+    obj2voxel_set_resolution(instance, 512);
+    obj2voxel_set_voxel_attribute(instance, OBJ2VOXEL_ATTRIBUTE_MATERIAL);
+    obj2voxel_error_t result = obj2voxel_voxelize(instance);
+
+    obj2voxel_stop_workers(instance);
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+    obj2voxel_free(instance);
+
+    VXIO_ASSERT_EQ(result, OBJ2VOXEL_ERR_OK);
+    return std::move(output.voxels);
+}
+
+TEST(overlappedBinningMatchesSerialVoxelization)
+{
+    // serial voxelization bins a single range before voxelizing any chunk
+    const std::map<std::array<uint32_t, 3>, uint32_t> serial = voxelizeMaterialPlane(0);
+    const std::map<std::array<uint32_t, 3>, uint32_t> parallel = voxelizeMaterialPlane(4);
+
+    VXIO_ASSERT_NE(serial.size(), 0u);
+    VXIO_ASSERT_EQ(parallel.size(), serial.size());
+    VXIO_ASSERT(parallel == serial);
+}
+
+struct LivePageOutput {
+    obj2voxel_instance *instance;
+    std::vector<uint64_t> livePages;
+
+    bool write(uint32_t *, size_t)
+    {
+        livePages.push_back(obj2voxel_get_live_triangle_pages(instance));
+        return true;
+    }
+};
+
+TEST(trianglePagesAreFreedDuringVoxelization)
+{
+    // the rows of the plane are spread over several pages, which are only referenced by the chunks of their rows
+    const std::vector<float> vertices = makeTessellatedPlane(128);
+    TriangleInput input{vertices.data(), vertices.size() / 3};
+
+    obj2voxel_instance *instance = obj2voxel_alloc();
+    LivePageOutput output{instance, {}};
+    obj2voxel_set_input_callback(instance, &inputCallback<TriangleInput>, &input);
+    obj2voxel_set_output_callback(instance, &outputCallback<LivePageOutput>, &output);
+    obj2voxel_set_resolution(instance, 256);
+    VXIO_ASSERT_EQ(obj2voxel_voxelize(instance), OBJ2VOXEL_ERR_OK);
+    const uint64_t livePagesAfterVoxelization = obj2voxel_get_live_triangle_pages(instance);
+    obj2voxel_free(instance);
+
+    VXIO_ASSERT_GT(output.livePages.size(), 1u);
+    VXIO_ASSERT_GT(output.livePages.front(), 1u);
+    VXIO_ASSERT_LT(output.livePages.back(), output.livePages.front());
+    VXIO_ASSERT_EQ(livePagesAfterVoxelization, 0u);
+}
+
+/// Voxelizes a triangle with 16 voxels per unit, using mesh bounds which map the origin to the corner of the grid.
+std::set<std::array<uint32_t, 3>> voxelizeTriangleAtFixedScale(const float vertices[9], uint32_t resolution)
+{
+    // the voxel grid spans [0.25, resolution - 0.25], see computeMeshTransform()
+    const float size = (static_cast<float>(resolution) - 0.5f) / 16;
+    const float bounds[6]{0, 0, 0, size, size, size};
+
+    TriangleInput input{vertices, 3};
+    MapOutput output;
+
+    obj2voxel_instance *instance = obj2voxel_alloc();
+    obj2voxel_set_input_callback(instance, &inputCallback<TriangleInput>, &input);
+    obj2voxel_set_output_callback(instance, &outputCallback<MapOutput>, &output);
+    obj2voxel_set_resolution(instance, resolution);
+    obj2voxel_set_mesh_boundaries(instance, bounds);
+    obj2voxel_error_t result = obj2voxel_voxelize(instance);
+    obj2voxel_free(instance);
+
+    VXIO_ASSERT_EQ(result, OBJ2VOXEL_ERR_OK);
+    std::set<std::array<uint32_t, 3>> positions;
+    for (const auto &[pos, color] : output.voxels) {
+        positions.insert(pos);
+    }
+    return positions;
+}
+
+TEST(thinTriangleAcrossChunkCornerMatchesSingleChunk)
+{
+    // Coordinates are multiples of 1/1024, so they remain exact when they are shifted by two units.
+    // A thin diagonal triangle whose long axis passes within a tenth of a voxel of (32, 32, 32).
+    // clang-format off
+    constexpr float vertices[9]{
+        1362 / 1024.f, 1413 / 1024.f, 1321 / 1024.f,
+        2790 / 1024.f, 2744 / 1024.f, 2826 / 1024.f,
+        2765 / 1024.f, 2806 / 1024.f, 2796 / 1024.f
+    };
+    // clang-format on
+    float shiftedVertices[9];
+    for (size_t i = 0; i < 9; ++i) {
+        shiftedVertices[i] = vertices[i] + 2;
+    }
+
+    // the whole grid is a single chunk, so the triangle is never tested against chunks it might miss
+    const std::set<std::array<uint32_t, 3>> reference = voxelizeTriangleAtFixedScale(vertices, 64);
+    // 32 voxels further, the triangle passes the corner where eight chunks meet and is binned into several of them
+    const std::set<std::array<uint32_t, 3>> binned = voxelizeTriangleAtFixedScale(shiftedVertices, 128);
+
+    std::set<std::array<uint32_t, 3>> shiftedReference;
+    for (const std::array<uint32_t, 3> &pos : reference) {
+        shiftedReference.insert({pos[0] + 32, pos[1] + 32, pos[2] + 32});
+    }
+    VXIO_ASSERT_NE(reference.size(), 0u);
+    VXIO_ASSERT_EQ(binned.size(), shiftedReference.size());
+    VXIO_ASSERT(binned == shiftedReference);
+
+    for (size_t axis = 0; axis < 3; ++axis) {
+        const auto isInFirstChunk = [axis](const std::array<uint32_t, 3> &pos) {
+            return pos[axis] < 64;
+        };
+        VXIO_ASSERT(std::any_of(binned.begin(), binned.end(), isInFirstChunk));
+        VXIO_ASSERT(not std::all_of(binned.begin(), binned.end(), isInFirstChunk));
+    }
+}
+
+std::map<std::array<uint32_t, 3>, uint32_t> voxelizeUniformlyColoredPlane(uint32_t supersampling)
+{
+    const std::vector<float> vertices = makeTessellatedPlane(24);
+    const size_t triangleCount = vertices.size() / 9;
+
+    // many triangles with the same color, so that every voxel blends several fragments
+    std::vector<float> colors;
+    for (size_t i = 0; i < triangleCount; ++i) {
+        colors.insert(colors.end(), {0.2f, 0.6f, 0.8f});
+    }
+
+    ColoredTriangleInput input{vertices.data(), colors.data(), triangleCount};
+    MapOutput output;
+
+    obj2voxel_instance *instance = obj2voxel_alloc();
+    obj2voxel_set_input_callback(instance, &inputCallback<ColoredTriangleInput>, &input);
+    obj2voxel_set_output_callback(instance, &outputCallback<MapOutput>, &output);
+    obj2voxel_set_resolution(instance, 16);
+    obj2voxel_set_supersampling(instance, supersampling);
+    obj2voxel_set_color_strategy(instance, OBJ2VOXEL_BLEND_STRATEGY);
+    obj2voxel_error_t result = obj2voxel_voxelize(instance);
+    obj2voxel_free(instance);
+
+    VXIO_ASSERT_EQ(result, OBJ2VOXEL_ERR_OK);
+    return std::move(output.voxels);
+}
+
+TEST(supersampledBlendingKeepsUniformColor)
+{
+    const auto regular = voxelizeUniformlyColoredPlane(1);
+    const auto supersampled = voxelizeUniformlyColoredPlane(2);
+    VXIO_ASSERT_NE(regular.size(), 0u);
+    VXIO_ASSERT_NE(supersampled.size(), 0u);
+
+    const uint32_t expected = regular.begin()->second;
+    for (const auto &voxels : {regular, supersampled}) {
+        for (const auto &[pos, color] : voxels) {
+            for (unsigned shift = 0; shift < 32; shift += 8) {
+                const int expectedChannel = (expected >> shift) & 0xff;
+                const int channel = (color >> shift) & 0xff;
+                VXIO_ASSERT_LE(std::abs(expectedChannel - channel), 1);
+            }
+        }
+    }
+}
+
 #ifdef DUMP_OUTPUTS
 TEST(dumpThreePlanes)
 {
@@ -6,7 +6,9 @@
 #include "voxelio/assert.hpp"
 #include "voxelio/voxelio.hpp"
 
+#include <array>
 #include <cstring>
+#include <map>
 #include <vector>
 
 // CONFIG ==============================================================================================================
@@ -52,18 +54,74 @@ struct TriangleInput {
 
     bool next(obj2voxel_triangle *triangle)
     {
-        constexpr const size_t floatsPerTriangle = 9;
+        constexpr const size_t floatsPerVertex = 3;
 
         if (vertexIndex >= vertexCount) {
             return false;
         }
 
-        obj2voxel_set_triangle_basic(triangle, vertices + vertexIndex * floatsPerTriangle);
+        obj2voxel_set_triangle_basic(triangle, vertices + vertexIndex * floatsPerVertex);
         vertexIndex += 3;
         return true;
     }
 };
 
+struct ColoredTriangleInput {
+    const float *vertices;
+    const float *colors;
+    size_t triangleCount;
+
+    size_t triangleIndex = 0;
+
+    bool next(obj2voxel_triangle *triangle)
+    {
+        if (triangleIndex >= triangleCount) {
+            return false;
+        }
+
+        obj2voxel_set_triangle_colored(triangle, vertices + triangleIndex * 9, colors + triangleIndex * 3);
+        ++triangleIndex;
+        return true;
+    }
+};
+
+struct TexturedTriangleInput {
+    const float *vertices;
+    const float *uvs;
+    obj2voxel_texture *texture;
+    size_t triangleCount;
+
+    size_t triangleIndex = 0;
+
+    bool next(obj2voxel_triangle *triangle)
+    {
+        if (triangleIndex >= triangleCount) {
+            return false;
+        }
+
+        obj2voxel_set_triangle_textured(triangle, vertices + triangleIndex * 9, uvs + triangleIndex * 6, texture);
+        ++triangleIndex;
+        return true;
+    }
+};
+
+/// Assigns each triangle the material index (triangle index / trianglesPerMaterial) + 1.
+struct MaterialTriangleInput {
+    TriangleInput triangles;
+    size_t trianglesPerMaterial;
+
+    size_t triangleIndex = 0;
+
+    bool next(obj2voxel_triangle *triangle)
+    {
+        if (not triangles.next(triangle)) {
+            return false;
+        }
+        obj2voxel_set_triangle_material(triangle, static_cast<uint32_t>(triangleIndex++ / trianglesPerMaterial + 1));
+        return true;
+    }
+};
+
 template <size_t PRIM_VERTICES, std::enable_if_t<PRIM_VERTICES == 3 || PRIM_VERTICES == 4, int> = 0>
 struct IndexedPrimitiveInput {
     const float *vertices;
@@ -145,6 +203,20 @@ struct HistogramOutput {
     }
 };
 
+struct MapOutput {
+    /// Maps voxel positions (x, y, z) to ARGB colors.
+    std::map<std::array<uint32_t, 3>, uint32_t> voxels;
+
+    bool write(uint32_t *voxelData, size_t voxelCount)
+    {
+        for (size_t i = 0; i < voxelCount; ++i) {
+            const uint32_t *voxel = voxelData + i * 4;
+            voxels.emplace(std::array<uint32_t, 3>{voxel[0], voxel[1], voxel[2]}, voxel[3]);
+        }
+        return true;
+    }
+};
+
 struct VoxelioOutput {
     voxelio::AbstractListWriter &writer;
     size_t voxelCount = 0;
@@ -159,6 +231,18 @@ struct VoxelioOutput {
     }
 };
 
+struct DistanceFieldOutput {
+    /// Distances in z-slice order, x varies fastest.
+    std::vector<float> distances;
+
+    bool write(uint32_t z, const float *slice, size_t count)
+    {
+        VXIO_ASSERT_EQ(distances.size(), z * count);
+        distances.insert(distances.end(), slice, slice + count);
+        return true;
+    }
+};
+
 template <typename T>
 bool inputCallback(void *iter, obj2voxel_triangle *triangle)
 {
@@ -171,6 +255,12 @@ bool outputCallback(void *sink, uint32_t *voxelBuffer, size_t voxelCount)
     return reinterpret_cast<T *>(sink)->write(voxelBuffer, voxelCount);
 }
 
+template <typename T>
+bool sdfCallback(void *sink, uint32_t z, const float *distances, size_t count)
+{
+    return reinterpret_cast<T *>(sink)->write(z, distances, count);
+}
+
 // TEST METAPROGRAMMING ================================================================================================
 
 using TestFunction = void (*)(void);